@@ -0,0 +1,489 @@
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "db/db.h"
+using namespace db;
+#include "gp/gp_data.h"
+#include "gp/gp_setting.h"
+#include "gp/gp_qsolve.h"
+#include "tdm/tdm_db.h"
+#include "tdm/tdm_net.h"
+#include "tdm/tdm_leg.h"
+#include "tdm/tdm_solve_lag.h"
+#include "tdm/timing_graph.h"
+
+// Micro-benchmarks of the kernels of the TDM and GP flows.
+// A fixture is a tdm_time work directory (as made by scripts/run.sh or larf_gen): combine/design.aux (or design.aux),
+// instance.pos and instance.device. Each fixture runs in its own process since the databases are global.
+
+Setting setting;
+
+class BenchStat {
+public:
+    vector<double> samples;  // seconds
+
+    double min() const { return *min_element(samples.begin(), samples.end()); }
+    double max() const { return *max_element(samples.begin(), samples.end()); }
+    double mean() const {
+        double sum = 0;
+        for (auto s : samples) sum += s;
+        return sum / samples.size();
+    }
+    double median() const {
+        vector<double> sorted(samples);
+        sort(sorted.begin(), sorted.end());
+        int n = sorted.size();
+        return (n % 2) ? sorted[n / 2] : 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+    }
+    double stddev() const {
+        double avg = mean(), sum = 0;
+        for (auto s : samples) sum += (s - avg) * (s - avg);
+        return samples.size() > 1 ? sqrt(sum / (samples.size() - 1)) : 0;
+    }
+};
+
+class TdmBench {
+public:
+    string fixture;
+    string csvFile;
+    int nRuns = 10;
+    bool lagCompare = false;
+
+    void run();
+
+private:
+    vector<Group> groups;
+    bool simdMismatch = false;
+
+    // one untimed warm-up, then nRuns timed calls of kernel, each after an untimed prepare
+    template <typename Prepare, typename Kernel>
+    void measure(const string& name, long size, Prepare prepare, Kernel kernel) {
+        BenchStat stat;
+        for (int r = -1; r < nRuns; r++) {
+            prepare();
+            timer::timer t;
+            kernel();
+            double elapsed = t.elapsed();
+            if (r >= 0) stat.samples.push_back(elapsed);
+        }
+        report(name, size, stat);
+    }
+    template <typename Kernel>
+    void measure(const string& name, long size, Kernel kernel) {
+        measure(name, size, []() {}, kernel);
+    }
+    void report(const string& name, long size, const BenchStat& stat);
+
+    void benchParse();
+    void readFixture();
+    void benchTiming();
+    template <typename T>
+    void benchSimd(TimingGraphT<T>& graph, const string& suffix);
+    template <typename T>
+    void benchLag();
+    void benchLagUpdate();
+    void benchLegalize();
+    void benchGP();
+};
+
+void TdmBench::report(const string& name, long size, const BenchStat& stat) {
+    printlog(LOG_NOTICE,
+             "bench %-14s size=%-9ld runs=%-3lu min=%.6lf median=%.6lf mean=%.6lf stddev=%.6lf max=%.6lf",
+             name.c_str(),
+             size,
+             stat.samples.size(),
+             stat.min(),
+             stat.median(),
+             stat.mean(),
+             stat.stddev(),
+             stat.max());
+    if (csvFile == "") return;
+    bool newFile = !ifstream(csvFile).good();
+    ofstream fs(csvFile, ios::app);
+    if (!fs.good()) {
+        printlog(LOG_ERROR, "Cannot open %s to write", csvFile.c_str());
+        return;
+    }
+    if (newFile) fs << "fixture,kernel,size,runs,min,median,mean,stddev,max" << endl;
+    fs << fixture << "," << name << "," << size << "," << stat.samples.size() << "," << stat.min() << ","
+       << stat.median() << "," << stat.mean() << "," << stat.stddev() << "," << stat.max() << endl;
+}
+
+string auxFile() { return ifstream("combine/design.aux").good() ? "combine/design.aux" : "design.aux"; }
+
+bool readDesign() {
+    return database.readAux(auxFile()) && database.readLib(setting.io_lib) && database.readNodes(setting.io_nodes) &&
+           database.readScl(setting.io_scl) && database.readPl(setting.io_pl) && database.readNets(setting.io_nets);
+}
+
+// the parser fills the global database, so each run parses in a child process and sends back its time
+void TdmBench::benchParse() {
+    BenchStat stat;
+    for (int r = -1; r < nRuns; r++) {
+        int fd[2];
+        if (pipe(fd) != 0) {
+            printlog(LOG_ERROR, "pipe fails");
+            return;
+        }
+        cout.flush();
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(fd[0]);
+            cout.setstate(ios::failbit);  // the parser is chatty
+            timer::timer t;
+            if (!readDesign()) _exit(1);
+            double elapsed = t.elapsed();
+            if (write(fd[1], &elapsed, sizeof(elapsed)) != sizeof(elapsed)) _exit(1);
+            _exit(0);
+        }
+        close(fd[1]);
+        double elapsed = 0;
+        bool ok = pid > 0 && read(fd[0], &elapsed, sizeof(elapsed)) == sizeof(elapsed);
+        close(fd[0]);
+        if (pid > 0) waitpid(pid, NULL, 0);
+        if (!ok) {
+            printlog(LOG_ERROR, "parsing %s fails", fixture.c_str());
+            return;
+        }
+        if (r >= 0) stat.samples.push_back(elapsed);
+    }
+    database.readAux(auxFile());
+    ifstream fs(setting.io_nets);
+    long nLines = count(istreambuf_iterator<char>(fs), istreambuf_iterator<char>(), '\n');
+    report("parse", nLines, stat);
+}
+
+void TdmBench::readFixture() {
+    database.bmName = "bench";
+    if (!readDesign()) exit(1);
+    database.setup();
+    gpSetting.init();
+
+    groups.resize(database.instances.size());
+    for (unsigned int i = 0; i < groups.size(); i++) {
+        groups[i].instances.push_back(database.instances[i]);
+        groups[i].id = i;
+    }
+    ifstream instPlFile("instance.pos");
+    for (unsigned int i = 0; i < groups.size(); i++) {
+        string instName;
+        double x, y;
+        instPlFile >> instName >> x >> y;
+        Instance *instance = database.getInstance(instName);
+        if (instance == NULL) {
+            printlog(LOG_ERROR, "Instance not found: %s", instName.c_str());
+            continue;
+        }
+        groups[instance->id].x = x;
+        groups[instance->id].y = y;
+    }
+    instPlFile.close();
+
+    int nDevice = 0;
+    ifstream instDeviceFile("instance.device");
+    string instName;
+    int device;
+    while (instDeviceFile >> instName >> device) nDevice = std::max(nDevice, device + 1);
+    instDeviceFile.close();
+    setting.nPartition = nDevice;
+
+    if (!tdmDatabase.init(nDevice, &groups)) exit(1);
+    tdmDatabase.getOptXdrVars();
+    printlog(LOG_NOTICE,
+             "fixture %s: #inst=%lu, #net=%lu, #device=%d, #troncon=%d, #xdr=%lu(%lu), #node=%d, #edge=%d",
+             fixture.c_str(),
+             database.instances.size(),
+             database.nets.size(),
+             nDevice,
+             tdmDatabase.getNumTroncon(),
+             tdmDatabase.getXdrVars().size(),
+             tdmDatabase.getOptXdrVars().size(),
+             tdmDatabase.getTimingGraph()->getNumNodes(),
+             tdmDatabase.getTimingGraph()->getNumEdges());
+}
+
+void TdmBench::benchTiming() {
+    TimingGraph* timingGraph = tdmDatabase.getTimingGraph();
+    long nEdges = timingGraph->getNumEdges();
+    measure("forward", nEdges, [&]() { timingGraph->updateArrivalTime(); });
+    measure("backward", nEdges, [&]() { timingGraph->updateRequireTime(); });
+    benchSimd(*timingGraph, "");
+    if (setting.precision == Setting::Precision_Float) {
+        TimingGraphT<float> floatGraph;
+        floatGraph.copyFrom(*timingGraph);
+        measure("forward_f32", nEdges, [&]() { floatGraph.updateArrivalTime(); });
+        measure("backward_f32", nEdges, [&]() { floatGraph.updateRequireTime(); });
+        benchSimd(floatGraph, "_f32");
+    }
+
+    long nNets = 0;
+    for (int i = 0; i < tdmDatabase.getNumTroncon(); i++) nNets += tdmDatabase.getTroncon(i)->getNumNets();
+    int usage = 0;
+    measure("getUsage", nNets, [&]() {
+        for (int i = 0; i < tdmDatabase.getNumTroncon(); i++) usage += tdmDatabase.getTroncon(i)->getUsage();
+    });
+    printlog(LOG_DEBUG, "usage checksum %d", usage);
+}
+
+// each ISA of the cpu against the propagation over the nodes and edges (-simd off), the times must be the same
+template <typename T>
+void TdmBench::benchSimd(TimingGraphT<T>& graph, const string& suffix) {
+    Setting::SimdIsa simd = setting.simd;
+    int nNodes = graph.getNumNodes(), nEdges = graph.getNumEdges();
+    auto getTimes = [&]() {
+        vector<T> times;
+        for (int i = 0; i < nNodes; i++) {
+            times.push_back(graph.getNode(i)->getArrivalTime());
+            times.push_back(graph.getNode(i)->getRequireTime());
+        }
+        for (int i = 0; i < nEdges; i++) {
+            times.push_back(graph.getEdge(i)->getDelay());
+            times.push_back(graph.getEdge(i)->getArrivalTimeAlongEdge());
+        }
+        return times;
+    };
+
+    setting.simd = Setting::Simd_Off;
+    graph.updateArrivalTime();
+    graph.updateRequireTime();
+    vector<T> ref = getTimes();
+
+    Setting::SimdIsa isas[] = {
+        Setting::Simd_Off, Setting::Simd_Scalar, Setting::Simd_SSE42, Setting::Simd_AVX2, Setting::Simd_AVX512};
+    for (auto isa : isas) {
+        if (!isSimdIsaSupported(isa)) continue;
+        setting.simd = isa;
+        string name = getSimdIsaName(isa) + suffix;
+        measure("forward_" + name, nEdges, [&]() { graph.updateArrivalTime(); });
+        measure("backward_" + name, nEdges, [&]() { graph.updateRequireTime(); });
+
+        vector<T> times = getTimes();
+        int nDiffs = 0;
+        for (unsigned i = 0; i < ref.size(); i++) nDiffs += memcmp(&times[i], &ref[i], sizeof(T)) != 0;
+        if (nDiffs) {
+            printlog(LOG_ERROR, "simd %s: %d times differ from off", name.c_str(), nDiffs);
+            simdMismatch = true;
+        }
+    }
+    setting.simd = simd;
+}
+
+// multipliers come from a full solve, each run restores them so that every run does the same work
+template <typename T>
+void TdmBench::benchLag() {
+    TdmLagSolverT<T> solver;
+    solver.solve();
+    vector<double> sol;
+    tdmDatabase.saveSol(sol);
+
+    TdmLagDataT<T>& data = solver._tdmLagData;
+    vector<T> mu = data._mu, lambda = data._lambda;
+    auto restore = [&]() {
+        data._mu = mu;
+        data._lambda = lambda;
+        tdmDatabase.recoverSol(sol);
+        data._timingGraph->updateArrivalTime();
+        data._timingGraph->updateRequireTime();
+    };
+
+    string suffix = sizeof(T) == sizeof(float) ? "_f32" : "";
+    TdmLagMultiplierUpdaterT<T> updater(data);
+    updater.getRatio(setting.lagIter);
+    measure("updateMu" + suffix, data._timingGraph->getNumEdges(), restore, [&]() { updater.updateMu(); });
+    measure("solveLRS" + suffix, data._optXdrVars.size(), restore, [&]() { solver.solveLRS(); });
+    restore();
+}
+
+// convergence of each multiplier update scheme from the same start: the first iteration within 0.1% of the best primal
+// of all the schemes, and the gap of the best primal and dual
+void TdmBench::benchLagUpdate() {
+    const char* names[] = {"geometric", "polyak", "momentum", "nesterov", "bundle"};
+    vector<double> sol;
+    tdmDatabase.saveSol(sol);
+    Setting::LagUpdate lagUpdate = setting.lagUpdate;
+    bool computeDual = setting.computeDual;
+    setting.computeDual = true;
+
+    vector<vector<pair<double, double>>> curves;
+    vector<double> times;
+    for (int s = Setting::LagUpdate_Geometric; s <= Setting::LagUpdate_Bundle; s++) {
+        setting.lagUpdate = (Setting::LagUpdate)s;
+        tdmDatabase.recoverSol(sol);
+        TdmLagSolver solver;
+        timer::timer t;
+        solver.solve();
+        times.push_back(t.elapsed());
+        curves.push_back(solver._curve);
+    }
+    double bestAll = DBL_MAX;
+    for (auto& curve : curves)
+        for (auto& point : curve) bestAll = min(bestAll, point.first);
+
+    for (unsigned s = 0; s < curves.size(); s++) {
+        double primal = DBL_MAX, dual = -DBL_MAX;
+        int iterToBest = -1;
+        for (unsigned i = 0; i < curves[s].size(); i++) {
+            primal = min(primal, curves[s][i].first);
+            dual = max(dual, curves[s][i].second);
+            if (iterToBest < 0 && curves[s][i].first <= bestAll * 1.001) iterToBest = i;
+        }
+        printlog(LOG_NOTICE,
+                 "bench lag_%-10s iters=%-5lu iterToBest=%-5d primal=%.3f dual=%.3f gap=%.4f time=%.3f",
+                 names[s],
+                 curves[s].size(),
+                 iterToBest,
+                 primal,
+                 dual,
+                 (primal - dual) / dual,
+                 times[s]);
+    }
+
+    setting.lagUpdate = lagUpdate;
+    setting.computeDual = computeDual;
+    tdmDatabase.recoverSol(sol);
+    tdmDatabase.updateTiming();
+}
+
+void TdmBench::benchLegalize() {
+    TdmLegalize legalizer;
+    legalizer.updateWireData();
+    measure("legalize", legalizer._optXdrVars.size(), [&]() {
+        for (auto& data : legalizer._wireData) {
+            Memorization memorization(data._vars.size(), data._troncon->_limit);
+            legalizer.legalizeTroncon(data, memorization);
+        }
+    });
+}
+
+// the B2B system of the initial placement of GP_Main: random cell locations
+void TdmBench::benchGP() {
+    gpSetting.set2();
+    gp_copy_in(groups, true);
+    srand(0);
+    for (int i = 0; i < numCells; i++) {
+        cellX[i] = getrand((double)(coreLX + 0.5 * cellW[i]), (double)(coreHX - 0.5 * cellW[i]));
+        cellY[i] = getrand((double)(coreLY + 0.5 * cellH[i]), (double)(coreHY - 0.5 * cellH[i]));
+    }
+
+    measure("b2b", numPins, []() { initCG(); }, []() { buildB2BSystem(0.0); });
+    int nIter = 0;
+    measure("cg", numCells, [&]() {
+        initCG();
+        buildB2BSystem(0.0);
+    }, [&]() { nIter = solveB2BSystem(0.001); });
+    printlog(LOG_NOTICE, "bench cg: %d iterations per run", nIter);
+}
+
+void TdmBench::run() {
+    if (chdir(fixture.c_str()) != 0) {
+        printlog(LOG_ERROR, "Cannot enter fixture %s", fixture.c_str());
+        exit(1);
+    }
+    // kernel logs go to a file, the results stay on the console
+    ofstream logFile("bench.log");
+    streambuf* coutBuf = cout.rdbuf();
+    cout.rdbuf(logFile.rdbuf());
+    benchParse();
+    readFixture();
+    benchTiming();
+    benchLag<double>();
+    if (setting.precision == Setting::Precision_Float) benchLag<float>();
+    if (lagCompare) benchLagUpdate();
+    benchLegalize();
+    benchGP();
+    cout.rdbuf(coutBuf);
+    if (simdMismatch) exit(1);
+}
+
+void usage(const char* bin) {
+    cerr << "usage: " << bin << " -fixture <dir> [-fixture <dir> ...] [-repeat <n>] [-thread <n>] [-lagIter <n>]"
+         << " [-lg Disp|MaxDisp] [-precision double|float] [-simd <isa>] [-lagCompare] [-csv <file>]" << endl;
+}
+
+int main(int argc, char** argv) {
+    init_log(LOG_NORMAL ^ LOG_INFO);
+
+    vector<string> fixtures;
+    TdmBench bench;
+    setting.nThreads = 1;
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "-fixture") == 0 && a + 1 < argc) {
+            fixtures.push_back(argv[++a]);
+        } else if (strcmp(argv[a], "-repeat") == 0 && a + 1 < argc) {
+            bench.nRuns = max(1, atoi(argv[++a]));
+        } else if (strcmp(argv[a], "-thread") == 0 && a + 1 < argc) {
+            setting.nThreads = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "-lagIter") == 0 && a + 1 < argc) {
+            setting.lagIter = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "-lg") == 0 && a + 1 < argc) {
+            string methodname(argv[++a]);
+            if (methodname == "Disp") {
+                setting.lg = Setting::Lg_Disp;
+            } else if (methodname == "MaxDisp") {
+                setting.lg = Setting::Lg_MaxDisp;
+            } else {
+                cerr << "unknown method: " << methodname << endl;
+                return 1;
+            }
+        } else if (strcmp(argv[a], "-precision") == 0 && a + 1 < argc) {
+            string precisionname(argv[++a]);
+            if (precisionname == "double") {
+                setting.precision = Setting::Precision_Double;
+            } else if (precisionname == "float") {
+                setting.precision = Setting::Precision_Float;
+            } else {
+                cerr << "unknown precision: " << precisionname << endl;
+                return 1;
+            }
+        } else if (strcmp(argv[a], "-simd") == 0 && a + 1 < argc) {
+            string isaname(argv[++a]);
+            Setting::SimdIsa isas[] = {Setting::Simd_Auto,
+                                       Setting::Simd_Off,
+                                       Setting::Simd_Scalar,
+                                       Setting::Simd_SSE42,
+                                       Setting::Simd_AVX2,
+                                       Setting::Simd_AVX512};
+            bool known = false;
+            for (auto isa : isas) {
+                if (isaname == getSimdIsaName(isa)) {
+                    setting.simd = isa;
+                    known = true;
+                }
+            }
+            if (!known) {
+                cerr << "unknown simd isa: " << isaname << endl;
+                return 1;
+            }
+        } else if (strcmp(argv[a], "-lagCompare") == 0) {
+            bench.lagCompare = true;
+        } else if (strcmp(argv[a], "-csv") == 0 && a + 1 < argc) {
+            char path[PATH_MAX];
+            bench.csvFile = argv[++a];
+            if (bench.csvFile[0] != '/' && getcwd(path, sizeof(path))) bench.csvFile = string(path) + "/" + bench.csvFile;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (fixtures.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    int nFail = 0;
+    for (auto& fixture : fixtures) {
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0) {
+            bench.fixture = fixture;
+            bench.run();
+            exit(0);
+        }
+        int status = 1;
+        if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            printlog(LOG_ERROR, "fixture %s fails", fixture.c_str());
+            nFail++;
+        }
+    }
+    return nFail ? 1 : 0;
+}
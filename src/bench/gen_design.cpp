@@ -0,0 +1,456 @@
+#include <random>
+
+#include "global.h"
+
+// Synthetic multi-FPGA designs for stress testing.
+// Writes a Bookshelf bundle (design.aux/nodes/nets/pl/scl/lib/wts) with instance.device and instance.pos, so that
+// the output directory can be used by every flow of larf (and as a fixture of larf_bench) as it is. The cell library
+// is copied from an ISPD'16 design since the database needs the complete DSP and BRAM cells.
+//
+// The netlist is levelized: FFs and IBUFs are level 0, LUTs are spread over levels 1..depth and input 0 of a LUT at
+// level l is driven from level l-1, which makes depth the length of the longest combinational path. The other LUT
+// inputs take a random lower level. Each driver has a Pareto weight, so fan-outs follow a power law. A sink pin is
+// driven from another FPGA with probability cut; instances are uniformly distributed over the FPGAs.
+
+class GenSetting {
+public:
+    string out;
+    string lib;  // design.lib of an ISPD'16 design
+    long nInst = 100000;  // LUTs + FFs
+    double ffRatio = 0.45;
+    vector<double> lutMix = {0, 6, 9, 16, 10, 9};  // weights of LUT1..LUT6
+    double fanoutExp = 2.5;
+    int maxFanout = 10000;
+    int depth = 10;
+    int nDevice = 8;
+    double cut = 0.02;
+    int nIO = 200;
+    double util = 0.6;  // target LUT/FF utilization of a FPGA
+    double spread = 8;  // distance between a LUT and its input 0 driver, in sites
+    unsigned seed = 1;
+};
+
+GenSetting gs;
+
+const int NoLevel = -1;
+
+class GenDesign {
+public:
+    enum Type { IBUF, OBUF, BUFGCE, FDRE, LUT1, LUT2, LUT3, LUT4, LUT5, LUT6 };
+
+    void generate();
+    void write();
+
+private:
+    mt19937_64 rng;
+
+    vector<char> type;
+    vector<int> device;
+    vector<int> level;
+    vector<float> posX, posY;
+    vector<int> slot;  // IO slot, fixed instances only
+
+    // sink pins, the driver of pin p of instance i is driver[pinStart[i] + p]
+    vector<long> pinStart;
+    vector<int> driver;
+
+    // driver pools of (device, level)
+    vector<vector<int>> pool;
+    vector<vector<double>> poolWeight;  // prefix sums
+    vector<unsigned> poolUsed;          // each driver is used once before weighted sampling
+
+    int nx, ny;      // sites of one FPGA
+    int nIOCol;      // IO columns, alternately on the left and right of the SLICE columns
+    int sliceLX;     // SLICE columns are [sliceLX, sliceLX + nSliceCol)
+    int nSliceCol;
+    int clkIBUF, clkBUFG;
+
+    static int numInputs(int t) { return t >= LUT1 ? t - LUT1 + 1 : 1; }
+    static const char* typeName(int t);
+
+    double uniform() { return uniform_real_distribution<double>(0.0, 1.0)(rng); }
+    int randInt(int n) { return uniform_int_distribution<int>(0, n - 1)(rng); }
+
+    int addInstance(int t, int d, int l);
+    void sizeArch(long nLUT, long nFF);
+    void buildPools();
+    int pickDriver(int d, int l);
+    int pickDriver(int sinkDevice, int lo, int hi, int exact);
+    void connect();
+    void place();
+
+    void writeNodes(const string& file);
+    void writeNets(const string& file);
+    void writePl(const string& file);
+    void writeScl(const string& file);
+    void writeLib(const string& file);
+    void writeDevice(const string& file);
+    void writePos(const string& file);
+};
+
+const char* GenDesign::typeName(int t) {
+    static const char* names[] = {"IBUF", "OBUF", "BUFGCE", "FDRE", "LUT1", "LUT2", "LUT3", "LUT4", "LUT5", "LUT6"};
+    return names[t];
+}
+
+int GenDesign::addInstance(int t, int d, int l) {
+    type.push_back(t);
+    device.push_back(d);
+    level.push_back(l);
+    return type.size() - 1;
+}
+
+// SLICE columns between IO columns, the height is a multiple of the 60-row IO site (of 64 slots)
+void GenDesign::sizeArch(long nLUT, long nFF) {
+    long nSlice = ceil(max(nLUT, nFF) / (double)gs.nDevice / 16 / gs.util) + 1;
+    long nIOSite = (gs.nIO + 2 + 63) / 64;
+    ny = max(60L, min(480L, (long)ceil(sqrt((double)nSlice) / 60) * 60));
+    ny = max((long)ny, min(480L, (nIOSite + 1) / 2 * 60));
+    nSliceCol = (nSlice + ny - 1) / ny;
+    nIOCol = max(2L, (nIOSite + ny / 60 - 1) / (ny / 60));
+    sliceLX = (nIOCol + 1) / 2;
+    nx = nSliceCol + nIOCol;
+}
+
+void GenDesign::generate() {
+    rng.seed(gs.seed);
+    long nFF = lround(gs.nInst * gs.ffRatio);
+    long nLUT = gs.nInst - nFF;
+    sizeArch(nLUT, nFF);
+
+    int nIBUF = gs.nIO / 2, nOBUF = gs.nIO - nIBUF;
+    clkIBUF = addInstance(IBUF, 0, NoLevel);
+    clkBUFG = addInstance(BUFGCE, 0, NoLevel);
+    for (int i = 0; i < nIBUF; i++) addInstance(IBUF, randInt(gs.nDevice), 0);
+    for (int i = 0; i < nOBUF; i++) addInstance(OBUF, randInt(gs.nDevice), NoLevel);
+    for (long i = 0; i < nFF; i++) addInstance(FDRE, randInt(gs.nDevice), 0);
+
+    discrete_distribution<int> lutDist(gs.lutMix.begin(), gs.lutMix.end());
+    for (int l = 1; l <= gs.depth; l++) {
+        long n = nLUT / gs.depth + (l <= nLUT % gs.depth);
+        for (long i = 0; i < n; i++) addInstance(LUT1 + lutDist(rng), randInt(gs.nDevice), l);
+    }
+
+    buildPools();
+    connect();
+    place();
+    printlog(LOG_INFO,
+             "generated %lu instances (%ld LUT, %ld FF, %d IO), %lu sink pins, %d FPGAs of %dx%d sites",
+             type.size(),
+             nLUT,
+             nFF,
+             gs.nIO,
+             driver.size(),
+             gs.nDevice,
+             nx,
+             ny);
+}
+
+void GenDesign::buildPools() {
+    int nPool = gs.nDevice * (gs.depth + 1);
+    pool.assign(nPool, vector<int>());
+    poolWeight.assign(nPool, vector<double>());
+    poolUsed.assign(nPool, 0);
+    for (unsigned i = 0; i < type.size(); i++)
+        if (level[i] != NoLevel) pool[device[i] * (gs.depth + 1) + level[i]].push_back(i);
+
+    // weight of a driver is its expected fan-out, Pareto with x_min = 1
+    for (int p = 0; p < nPool; p++) {
+        shuffle(pool[p].begin(), pool[p].end(), rng);
+        double sum = 0;
+        for (unsigned i = 0; i < pool[p].size(); i++) {
+            sum += min((double)gs.maxFanout, pow(1.0 - uniform(), -1.0 / (gs.fanoutExp - 1.0)));
+            poolWeight[p].push_back(sum);
+        }
+    }
+}
+
+int GenDesign::pickDriver(int d, int l) {
+    int p = d * (gs.depth + 1) + l;
+    if (pool[p].empty()) return -1;
+    if (poolUsed[p] < pool[p].size()) return pool[p][poolUsed[p]++];
+    double w = uniform() * poolWeight[p].back();
+    return pool[p][upper_bound(poolWeight[p].begin(), poolWeight[p].end(), w) - poolWeight[p].begin()];
+}
+
+// a driver of level exact (if >= 0) or in [lo, hi], from the sink device unless the pin is cut
+int GenDesign::pickDriver(int sinkDevice, int lo, int hi, int exact) {
+    int d = sinkDevice;
+    if (gs.nDevice > 1 && uniform() < gs.cut) d = (sinkDevice + 1 + randInt(gs.nDevice - 1)) % gs.nDevice;
+    int l = exact >= 0 ? exact : lo + randInt(hi - lo + 1);
+    for (int k = 0; k <= hi - lo; k++) {
+        int drv = pickDriver(d, l);
+        if (drv >= 0) return drv;
+        l = (l > lo) ? l - 1 : hi;
+    }
+    // the device has no driver in range, e.g., tiny designs over many FPGAs
+    for (int k = 1; k < gs.nDevice; k++) {
+        int drv = pickDriver((d + k) % gs.nDevice, exact >= 0 ? exact : hi);
+        if (drv >= 0) return drv;
+    }
+    return -1;
+}
+
+void GenDesign::connect() {
+    pinStart.assign(type.size() + 1, 0);
+    for (unsigned i = 0; i < type.size(); i++) {
+        int nPins = (type[i] == FDRE || type[i] >= LUT1 || type[i] == OBUF) ? numInputs(type[i]) : 0;
+        pinStart[i + 1] = pinStart[i] + nPins;
+    }
+    driver.assign(pinStart.back(), -1);
+
+    // LUTs level by level, then FFs (half of them from the top level) and OBUFs
+    for (unsigned i = 0; i < type.size(); i++) {
+        if (type[i] < LUT1) continue;
+        for (int p = 0; p < numInputs(type[i]); p++)
+            driver[pinStart[i] + p] = pickDriver(device[i], 0, level[i] - 1, p == 0 ? level[i] - 1 : -1);
+    }
+    for (unsigned i = 0; i < type.size(); i++) {
+        if (type[i] == FDRE)
+            driver[pinStart[i]] = pickDriver(device[i], 1, gs.depth, uniform() < 0.5 ? gs.depth : -1);
+        else if (type[i] == OBUF)
+            driver[pinStart[i]] = pickDriver(device[i], 1, gs.depth, -1);
+    }
+}
+
+void GenDesign::place() {
+    posX.assign(type.size(), 0);
+    posY.assign(type.size(), 0);
+    slot.assign(type.size(), -1);
+
+    // IOs fill the slots of the left and right IO columns
+    int ioSite = 0, ioSlot = 0;
+    for (unsigned i = 0; i < type.size(); i++) {
+        if (type[i] != IBUF && type[i] != OBUF && type[i] != BUFGCE) continue;
+        int col = ioSite % nIOCol, row = ioSite / nIOCol;
+        posX[i] = (col % 2) ? nx - 1 - col / 2 : col / 2;
+        posY[i] = row * 60;
+        slot[i] = ioSlot;
+        if (++ioSlot == 64) {
+            ioSlot = 0;
+            ioSite++;
+        }
+    }
+
+    // FFs at random, a LUT around the driver of its input 0
+    normal_distribution<double> offset(0.0, gs.spread);
+    for (unsigned i = 0; i < type.size(); i++) {
+        if (type[i] == FDRE) {
+            posX[i] = sliceLX + randInt(nSliceCol);
+            posY[i] = randInt(ny);
+        } else if (type[i] >= LUT1) {
+            int drv = driver[pinStart[i]];
+            if (drv >= 0 && device[drv] == device[i] && type[drv] != IBUF) {
+                posX[i] = max(sliceLX, min(sliceLX + nSliceCol - 1, (int)lround(posX[drv] + offset(rng))));
+                posY[i] = max(0, min(ny - 1, (int)lround(posY[drv] + offset(rng))));
+            } else {
+                posX[i] = sliceLX + randInt(nSliceCol);
+                posY[i] = randInt(ny);
+            }
+        }
+    }
+}
+
+// big buffered C streams, the outputs reach GBs for 10M instances
+class GenFile {
+public:
+    FILE* fp;
+    vector<char> buf;
+
+    GenFile(const string& file) : buf(1 << 22) {
+        fp = fopen(file.c_str(), "w");
+        if (fp == NULL) {
+            printlog(LOG_ERROR, "Cannot open %s to write", file.c_str());
+            exit(1);
+        }
+        setvbuf(fp, buf.data(), _IOFBF, buf.size());
+    }
+    ~GenFile() { fclose(fp); }
+};
+
+void GenDesign::writeNodes(const string& file) {
+    GenFile f(file);
+    for (unsigned i = 0; i < type.size(); i++) fprintf(f.fp, "inst_%u %s\n", i, typeName(type[i]));
+}
+
+void GenDesign::writeNets(const string& file) {
+    // group the sink pins by driver (counting sort)
+    vector<long> sinkStart(type.size() + 1, 0);
+    for (auto d : driver)
+        if (d >= 0) sinkStart[d + 1]++;
+    for (unsigned i = 0; i < type.size(); i++) sinkStart[i + 1] += sinkStart[i];
+    vector<long> sinks(sinkStart.back());
+    vector<long> fill(sinkStart.begin(), sinkStart.end() - 1);
+    for (unsigned i = 0; i < type.size(); i++)
+        for (long p = pinStart[i]; p < pinStart[i + 1]; p++)
+            if (driver[p] >= 0) sinks[fill[driver[p]]++] = p;
+    vector<int> pinOwner(driver.size());
+    for (unsigned i = 0; i < type.size(); i++)
+        for (long p = pinStart[i]; p < pinStart[i + 1]; p++) pinOwner[p] = i;
+
+    GenFile f(file);
+    long nNets = 0;
+    auto pinName = [&](int inst, int p, char* name) {
+        if (type[inst] >= LUT1)
+            sprintf(name, "I%d", p);
+        else
+            strcpy(name, type[inst] == FDRE ? "D" : "I");
+    };
+    char name[8];
+    for (unsigned i = 0; i < type.size(); i++) {
+        long n = sinkStart[i + 1] - sinkStart[i];
+        if (n == 0) continue;
+        fprintf(f.fp, "net net_%ld %ld\n\tinst_%u %s\n", nNets++, n + 1, i, type[i] == FDRE ? "Q" : "O");
+        for (long s = sinkStart[i]; s < sinkStart[i + 1]; s++) {
+            int inst = pinOwner[sinks[s]];
+            pinName(inst, sinks[s] - pinStart[inst], name);
+            fprintf(f.fp, "\tinst_%d %s\n", inst, name);
+        }
+        fprintf(f.fp, "endnet\n");
+    }
+
+    // clock
+    long nFF = 0;
+    for (auto t : type) nFF += (t == FDRE);
+    fprintf(f.fp, "net net_%ld 2\n\tinst_%d O\n\tinst_%d I\nendnet\n", nNets++, clkIBUF, clkBUFG);
+    fprintf(f.fp, "net net_%ld %ld\n\tinst_%d O\n", nNets++, nFF + 1, clkBUFG);
+    for (unsigned i = 0; i < type.size(); i++)
+        if (type[i] == FDRE) fprintf(f.fp, "\tinst_%u C\n", i);
+    fprintf(f.fp, "endnet\n");
+}
+
+void GenDesign::writePl(const string& file) {
+    GenFile f(file);
+    for (unsigned i = 0; i < type.size(); i++)
+        if (slot[i] >= 0) fprintf(f.fp, "inst_%u %d %d %d FIXED\n", i, (int)posX[i], (int)posY[i], slot[i]);
+}
+
+void GenDesign::writeScl(const string& file) {
+    GenFile f(file);
+    fprintf(f.fp, "SITE SLICE\n  LUT 16\n  FF 16\n  CARRY8 1\nEND SITE\n\n");
+    fprintf(f.fp, "SITE DSP\n  DSP48E2 1\nEND SITE\n\n");
+    fprintf(f.fp, "SITE BRAM\n  RAMB36E2 1\nEND SITE\n\n");
+    fprintf(f.fp, "SITE IO\n  IO 64\nEND SITE\n\n");
+    fprintf(f.fp, "RESOURCES\n  LUT LUT1 LUT2 LUT3 LUT4 LUT5 LUT6\n  FF  FDRE\n  CARRY8 CARRY8\n");
+    fprintf(f.fp, "  DSP48E2 DSP48E2\n  RAMB36E2 RAMB36E2\n  IO IBUF OBUF BUFGCE\nEND RESOURCES\n\n");
+    fprintf(f.fp, "SITEMAP %d %d\n", nx, ny);
+    for (int x = 0; x < nx; x++) {
+        if (x < sliceLX || x >= sliceLX + nSliceCol) {
+            for (int y = 0; y < ny; y += 60) fprintf(f.fp, "%d %d IO\n", x, y);
+        } else {
+            for (int y = 0; y < ny; y++) fprintf(f.fp, "%d %d SLICE\n", x, y);
+        }
+    }
+    fprintf(f.fp, "END SITEMAP\n");
+}
+
+void GenDesign::writeLib(const string& file) {
+    ifstream src(gs.lib, ios::binary);
+    if (!src.good()) {
+        printlog(LOG_ERROR, "Cannot open %s to read", gs.lib.c_str());
+        exit(1);
+    }
+    ofstream fs(file, ios::binary);
+    fs << src.rdbuf();
+}
+
+// same order as design.nodes, which is the order TdmDB::init reads
+void GenDesign::writeDevice(const string& file) {
+    GenFile f(file);
+    for (unsigned i = 0; i < type.size(); i++) fprintf(f.fp, "inst_%u %d\n", i, device[i]);
+}
+
+void GenDesign::writePos(const string& file) {
+    GenFile f(file);
+    for (unsigned i = 0; i < type.size(); i++) fprintf(f.fp, "inst_%u %.1f %.1f\n", i, posX[i], posY[i]);
+}
+
+void GenDesign::write() {
+    string dir = gs.out + "/";
+    if (system(("mkdir -p " + gs.out).c_str()) != 0) {
+        printlog(LOG_ERROR, "Cannot create %s", gs.out.c_str());
+        exit(1);
+    }
+    {
+        ofstream fs(dir + "design.aux");
+        fs << "design : design.nodes design.nets design.wts design.pl design.scl design.lib" << endl;
+        ofstream wts(dir + "design.wts");
+        wts << "# Intentionally left empty" << endl;
+    }
+    writeNodes(dir + "design.nodes");
+    writeNets(dir + "design.nets");
+    writePl(dir + "design.pl");
+    writeScl(dir + "design.scl");
+    writeLib(dir + "design.lib");
+    writeDevice(dir + "instance.device");
+    writePos(dir + "instance.pos");
+    printlog(LOG_INFO, "design is written to %s", gs.out.c_str());
+}
+
+bool get_args(int argc, char** argv) {
+    bool valid = true;
+    for (int a = 1; a < argc; a++) {
+        if (a + 1 >= argc) {
+            valid = false;
+        } else if (strcmp(argv[a], "-out") == 0) {
+            gs.out = argv[++a];
+        } else if (strcmp(argv[a], "-lib") == 0) {
+            gs.lib = argv[++a];
+        } else if (strcmp(argv[a], "-inst") == 0) {
+            gs.nInst = atol(argv[++a]);
+        } else if (strcmp(argv[a], "-ffRatio") == 0) {
+            gs.ffRatio = atof(argv[++a]);
+        } else if (strcmp(argv[a], "-lutMix") == 0) {
+            stringstream ss(argv[++a]);
+            string w;
+            gs.lutMix.clear();
+            while (getline(ss, w, ',')) gs.lutMix.push_back(atof(w.c_str()));
+            if (gs.lutMix.size() != 6) valid = false;
+        } else if (strcmp(argv[a], "-fanoutExp") == 0) {
+            gs.fanoutExp = atof(argv[++a]);
+        } else if (strcmp(argv[a], "-maxFanout") == 0) {
+            gs.maxFanout = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "-depth") == 0) {
+            gs.depth = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "-device") == 0) {
+            gs.nDevice = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "-cut") == 0) {
+            gs.cut = atof(argv[++a]);
+        } else if (strcmp(argv[a], "-io") == 0) {
+            gs.nIO = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "-util") == 0) {
+            gs.util = atof(argv[++a]);
+        } else if (strcmp(argv[a], "-spread") == 0) {
+            gs.spread = atof(argv[++a]);
+        } else if (strcmp(argv[a], "-seed") == 0) {
+            gs.seed = atoi(argv[++a]);
+        } else {
+            cerr << "unknown parameter: " << argv[a] << endl;
+            valid = false;
+        }
+    }
+    if (gs.out == "" || gs.lib == "" || gs.nInst < 2 || gs.ffRatio <= 0 || gs.ffRatio >= 1 || gs.fanoutExp <= 1 ||
+        gs.maxFanout < 1 || gs.depth < 1 || gs.nDevice < 1 || gs.cut < 0 || gs.cut > 1 || gs.nIO < 2 || gs.util <= 0 ||
+        gs.util > 1)
+        valid = false;
+    // the library is copied after the generation
+    if (valid && !ifstream(gs.lib).good()) {
+        printlog(LOG_ERROR, "Cannot open %s to read", gs.lib.c_str());
+        valid = false;
+    }
+    if (!valid) {
+        cerr << "usage: " << argv[0] << " -out <dir> -lib <ispd16_lib> [-inst <n>] [-ffRatio <r>] [-lutMix <w1,...,w6>]"
+             << " [-fanoutExp <a>] [-maxFanout <n>] [-depth <n>] [-device <n>] [-cut <r>] [-io <n>] [-util <r>]"
+             << " [-spread <sites>] [-seed <n>]" << endl;
+    }
+    return valid;
+}
+
+int main(int argc, char** argv) {
+    init_log(LOG_NORMAL);
+    if (!get_args(argc, argv)) return 1;
+    GenDesign design;
+    design.generate();
+    design.write();
+    return 0;
+}
@@ -9,6 +9,8 @@ Database::Database() {
     sitemap_ny = 0;
     crmap_nx = 0;
     crmap_ny = 0;
+    switchbox_nx = 0;
+    switchbox_ny = 0;
 
     canvas = NULL;
 }
@@ -20,20 +22,18 @@ Database::~Database() {
     for (auto s : sitetypes) delete s;
     for (auto r : resources) delete r;
     for (auto p : packs) delete p;
-    for (auto swv : switchboxes)
-        for (auto sw : swv) delete sw;
-    for (unsigned int i = 0; i < sites.size(); ++i)
-        for (unsigned int j = 0; j < sites[i].size(); ++j)
-            if (j == 0 || sites[i][j] != sites[i][j - 1]) delete sites[i][j];
+    for (int x = 0; x < sitemap_nx; ++x)
+        for (int y = 0; y < sitemap_ny; ++y)
+            if (y == 0 || siteAt(x, y) != siteAt(x, y - 1)) delete siteAt(x, y);
     if (canvas) delete canvas;
 }
 
 void Database::setup() {
     for (int x = 0; x < sitemap_nx; x++) {
         for (int y = 1; y < sitemap_ny; y++) {
-            if (sites[x][y] == NULL && sites[x][y - 1] != NULL) {
-                sites[x][y] = sites[x][y - 1];
-                sites[x][y]->h++;
+            if (siteAt(x, y) == NULL && siteAt(x, y - 1) != NULL) {
+                siteAt(x, y) = siteAt(x, y - 1);
+                siteAt(x, y)->h++;
             }
         }
     }
@@ -60,7 +60,7 @@ void Database::setup() {
             }
         }
         if(clkFound){
-            printlog(LOG_INFO, "clock net found: %s with %d pins", nets[i]->name.c_str(), (int)nets[i]->pins.size());
+            printlog(LOG_INFO, "clock net found: %s with %d pins", nets[i]->name, (int)nets[i]->pins.size());
             delete nets[i];
             nets.erase(nets.begin()+i);
             break;
@@ -98,22 +98,28 @@ Master *Database::addMaster(const Master &master) {
     return newmaster;
 }
 Instance *Database::addInstance(const Instance &instance) {
-    if (getInstance(instance.name) != NULL) {
+    int nameId = names.intern(instance.name);
+    if (nameId < (int)name_instances.size() && name_instances[nameId] != NULL) {
         cerr << "Instance: " << instance.name << " duplicated" << endl;
         return NULL;
     }
     Instance *newinstance = new Instance(instance);
-    name_instances[instance.name] = newinstance;
+    newinstance->name = names.str(nameId);
+    if (nameId >= (int)name_instances.size()) name_instances.resize(names.size(), NULL);
+    name_instances[nameId] = newinstance;
     instances.push_back(newinstance);
     return newinstance;
 }
 Net *Database::addNet(const Net &net) {
-    if (getNet(net.name) != NULL) {
+    int nameId = names.intern(net.name);
+    if (nameId < (int)name_nets.size() && name_nets[nameId] != NULL) {
         cerr << "Net: " << net.name << " duplicated" << endl;
         return NULL;
     }
     Net *newnet = new Net(net);
-    name_nets[net.name] = newnet;
+    newnet->name = names.str(nameId);
+    if (nameId >= (int)name_nets.size()) name_nets.resize(names.size(), NULL);
+    name_nets[nameId] = newnet;
     nets.push_back(newnet);
     return newnet;
 }
@@ -142,13 +148,13 @@ Site *Database::addSite(int x, int y, SiteType *sitetype) {
         printlog(LOG_ERROR, "Invalid position (%d,%d) (w=%d h=%d)", x, y, sitemap_nx, sitemap_ny);
         return NULL;
     }
-    if (sites[x][y] != NULL) {
+    if (siteAt(x, y) != NULL) {
         // site can be repeatly defined, simply ignore it
         printlog(LOG_ERROR, "Site already defined at %d,%d", x, y);
         return NULL;
     }
     Site *newsite = new Site(x, y, sitetype);
-    sites[x][y] = newsite;
+    siteAt(x, y) = newsite;
     return newsite;
 }
 
@@ -158,38 +164,24 @@ Pack *Database::addPack(SiteType *sitetype) {
     return newpack;
 }
 
-SwitchBox *Database::addSwitchBox(int x, int y) {
-    if (x < 0 || x >= switchbox_nx || y < 0 || y >= switchbox_ny) {
-        printlog(LOG_ERROR, "Invalid position (%d,%d) (w=%d h=%d)", x, y, switchbox_nx, switchbox_ny);
-        return NULL;
-    }
-    if (switchboxes[x][y] != NULL) {
-        printlog(LOG_ERROR, "Switch box already defined at %d,%d", x, y);
-        return NULL;
-    }
-    SwitchBox *newswitchbox = new SwitchBox(x, y);
-    switchboxes[x][y] = newswitchbox;
-    return newswitchbox;
-}
-
 Master *Database::getMaster(Master::Name name) {
     auto mi = name_masters.find(name);
     if (mi == name_masters.end()) return NULL;
     return mi->second;
 }
 Instance *Database::getInstance(const string &name) {
-    auto mi = name_instances.find(name);
-    if (mi == name_instances.end()) {
+    int nameId = names.find(name);
+    if (nameId < 0 || nameId >= (int)name_instances.size()) {
         return NULL;
     }
-    return mi->second;
+    return name_instances[nameId];
 }
 Net *Database::getNet(const string &name) {
-    auto mi = name_nets.find(name);
-    if (mi == name_nets.end()) {
+    int nameId = names.find(name);
+    if (nameId < 0 || nameId >= (int)name_nets.size()) {
         return NULL;
     }
-    return mi->second;
+    return name_nets[nameId];
 }
 Resource *Database::getResource(Resource::Name name) {
     auto mi = name_resources.find(name);
@@ -201,36 +193,24 @@ SiteType *Database::getSiteType(SiteType::Name name) {
     if (mi == name_sitetypes.end()) return NULL;
     return mi->second;
 }
-Site *Database::getSite(int x, int y) {
-    if (x < 0 || x >= sitemap_nx || y < 0 || y >= sitemap_ny) {
-        return NULL;
-    }
-    return sites[x][y];
-}
-
-SwitchBox *Database::getSwitchBox(int x, int y) {
-    if (x < 0 || x >= switchbox_nx || y < 0 || y >= switchbox_ny) {
-        return NULL;
-    }
-    return switchboxes[x][y];
-}
-
 void Database::setSiteMap(int nx, int ny) {
     sitemap_nx = nx;
     sitemap_ny = ny;
-    sites.resize(nx, vector<Site *>(ny, NULL));
+    sites.assign(nx * ny, NULL);
 }
 
 void Database::setSwitchBoxes(int nx, int ny) {
     switchbox_nx = nx;
     switchbox_ny = ny;
-    switchboxes.resize(nx, vector<SwitchBox *>(ny, NULL));
-
+    switchboxes.clear();
+    switchboxes.reserve(nx * ny);
     for (int x = 0; x < nx; x++) {
         for (int y = 0; y < ny; y++) {
-            switchboxes[x][y] = new SwitchBox(x, y);
+            switchboxes.emplace_back(x, y);
         }
     }
+    switchboxSupply.assign(nx * ny * SWITCHBOX_NUM_CONNECTIONS, 0);
+    switchboxDemand.assign(nx * ny * SWITCHBOX_NUM_CONNECTIONS, 0);
 }
 
 bool Database::place(Instance *instance, int x, int y, int slot) {
@@ -444,29 +424,26 @@ int Database::getRouteNet() {
 
 int Database::getTotNumDupInputs() {
     int tot = 0;
-    for (auto &ss : sites)
-        for (auto s : ss)
-            if (s) {
-                auto pack = s->pack;
-                if (pack && pack->type->name == SiteType::SLICE) {
-                    for (int i = 0; i < 8; i++) {
-                        Instance *a = pack->instances[2 * i];
-                        Instance *b = pack->instances[2 * i + 1];
-                        if (a == NULL || b == NULL) continue;
-                        tot += NumDupInputs(*a, *b);
-                    }
+    for (auto s : sites)
+        if (s) {
+            auto pack = s->pack;
+            if (pack && pack->type->name == SiteType::SLICE) {
+                for (int i = 0; i < 8; i++) {
+                    Instance *a = pack->instances[2 * i];
+                    Instance *b = pack->instances[2 * i + 1];
+                    if (a == NULL || b == NULL) continue;
+                    tot += NumDupInputs(*a, *b);
                 }
             }
+        }
     return tot;
 }
 
 bool Database::isPlacementValid() {
-    for (int i = 0; i < (int)sites.size(); i++) {
-        for (int j = 0; j < (int)sites[i].size(); j++) {
-            if (sites[i][j]->pack != NULL && sites[i][j]->pack->site != sites[i][j]) {
-                printlog(LOG_ERROR, "error in site->pack->site consistency validation");
-                return false;
-            }
+    for (auto site : sites) {
+        if (site->pack != NULL && site->pack->site != site) {
+            printlog(LOG_ERROR, "error in site->pack->site consistency validation");
+            return false;
         }
     }
     for (int i = 0; i < (int)packs.size(); i++) {
@@ -490,12 +467,10 @@ bool Database::isPlacementValid() {
             }
         }
     }
-    for (int i = 0; i < (int)sites.size(); i++) {
-        for (int j = 0; j < (int)sites[i].size(); j++) {
-            if (sites[i][j]->pack != NULL && !isPackValid(sites[i][j]->pack)) {
-                printlog(LOG_ERROR, "error in site legality validation");
-                return false;
-            }
+    for (auto site : sites) {
+        if (site->pack != NULL && !isPackValid(site->pack)) {
+            printlog(LOG_ERROR, "error in site legality validation");
+            return false;
         }
     }
     for (int i = 0; i < (int)instances.size(); i++) {
@@ -614,9 +589,7 @@ bool Database::isPlacementValid() {
 }
 
 bool Database::setDemand(int x1, int y1, int x2, int y2, int demand) {
-    SwitchBox *a = switchboxes[x1][y1];
-    SwitchBox *b = switchboxes[x2][y2];
-    return setDemand(a, b, demand);
+    return setDemand(&switchboxAt(x1, y1), &switchboxAt(x2, y2), demand);
 }
 bool Database::setDemand(SwitchBox *a, SwitchBox *b, int demand) {
     int ai, bi;
@@ -653,8 +626,8 @@ bool Database::setDemand(SwitchBox *a, SwitchBox *b, int demand) {
     }
     bi = 4 * (d - 1) + f;
     ai = 4 * (d - 1) + g;
-    a->demand[bi] = demand;
-    b->demand[ai] = demand;
+    switchboxDemand[connectionIdx(a->x, a->y, bi)] = demand;
+    switchboxDemand[connectionIdx(b->x, b->y, ai)] = demand;
     return true;
 }
 bool Database::setSupply(SwitchBox *a, SwitchBox *b, int supply) {
@@ -687,36 +660,31 @@ bool Database::setSupply(SwitchBox *a, SwitchBox *b, int supply) {
         return false;
     }
     bi = 4 * (d - 1) + f;
-    a->supply[bi] = supply;
+    switchboxSupply[connectionIdx(a->x, a->y, bi)] = supply;
     return true;
 }
 bool Database::setSupply(int x1, int y1, int x2, int y2, int supply) {
-    SwitchBox *a = switchboxes[x1][y1];
-    SwitchBox *b = switchboxes[x2][y2];
-    return setSupply(a, b, supply);
+    return setSupply(&switchboxAt(x1, y1), &switchboxAt(x2, y2), supply);
 }
 void Database::setSupplyAll() {
+    // supply of connection 4 * (d - 1) + f, f is the direction (0: +y, 1: +x, 2: -y, 3: -x) and d the distance
+    const int supplies[SWITCHBOX_NUM_CONNECTIONS] = {
+        21, 24, 20, 24,  // d = 1
+        14, 16, 18, 16,  // d = 2
+        2,  0,  0,  0,   // d = 3
+        8,  0,  8,  0,   // d = 4
+        7,  0,  8,  0,   // d = 5
+        1,  8,  0,  8,   // d = 6
+    };
     for (int x = 0; x < switchbox_nx; x++) {
         for (int y = 0; y < switchbox_ny; y++) {
-            if (y < switchbox_ny - 1) setSupply(switchboxes[x][y], switchboxes[x][y + 1], 21);
-            if (y < switchbox_ny - 2) setSupply(switchboxes[x][y], switchboxes[x][y + 2], 14);
-            if (y < switchbox_ny - 3) setSupply(switchboxes[x][y], switchboxes[x][y + 3], 2);
-            if (y < switchbox_ny - 4) setSupply(switchboxes[x][y], switchboxes[x][y + 4], 8);
-            if (y < switchbox_ny - 5) setSupply(switchboxes[x][y], switchboxes[x][y + 5], 7);
-            if (y < switchbox_ny - 6) setSupply(switchboxes[x][y], switchboxes[x][y + 6], 1);
-
-            if (y >= 1) setSupply(switchboxes[x][y], switchboxes[x][y - 1], 20);
-            if (y >= 2) setSupply(switchboxes[x][y], switchboxes[x][y - 2], 18);
-            if (y >= 4) setSupply(switchboxes[x][y], switchboxes[x][y - 4], 8);
-            if (y >= 5) setSupply(switchboxes[x][y], switchboxes[x][y - 5], 8);
-
-            if (x < switchbox_nx - 1) setSupply(switchboxes[x][y], switchboxes[x + 1][y], 24);
-            if (x < switchbox_nx - 2) setSupply(switchboxes[x][y], switchboxes[x + 2][y], 16);
-            if (x < switchbox_nx - 6) setSupply(switchboxes[x][y], switchboxes[x + 6][y], 8);
-
-            if (x >= 1) setSupply(switchboxes[x][y], switchboxes[x - 1][y], 24);
-            if (x >= 2) setSupply(switchboxes[x][y], switchboxes[x - 2][y], 16);
-            if (x >= 6) setSupply(switchboxes[x][y], switchboxes[x - 6][y], 8);
+            int *supply = &switchboxSupply[connectionIdx(x, y, 0)];
+            for (int d = 1; d <= SWITCHBOX_CONNECT_MAX_DISTANCE; d++) {
+                if (y + d < switchbox_ny) supply[4 * (d - 1) + 0] = supplies[4 * (d - 1) + 0];
+                if (x + d < switchbox_nx) supply[4 * (d - 1) + 1] = supplies[4 * (d - 1) + 1];
+                if (y - d >= 0) supply[4 * (d - 1) + 2] = supplies[4 * (d - 1) + 2];
+                if (x - d >= 0) supply[4 * (d - 1) + 3] = supplies[4 * (d - 1) + 3];
+            }
         }
     }
 }
@@ -770,7 +738,7 @@ void Database::setSwitchBoxPins(Instance *inst) {
     sbx = SWCol(x);
     sby = y;
     if (rule == PinRuleSlice) {
-        vector<Pin *> &sbPins = switchboxes[sbx][sby]->pins;
+        vector<Pin *> &sbPins = switchboxAt(sbx, sby).pins;
         sbPins.insert(sbPins.end(), inst->pins.begin(), inst->pins.end());
     } else if (rule == PinRuleDSP0 || rule == PinRuleDSP1 || rule == PinRuleBRAM) {
         if (rule == PinRuleDSP1) sby = y - 2;
@@ -778,16 +746,16 @@ void Database::setSwitchBoxPins(Instance *inst) {
             Pin *pin = inst->pins[i];
             int offset = pinSwitchBoxMap[rule][i];
             if (offset >= 0) {
-                switchboxes[sbx][sby + offset]->pins.push_back(pin);
+                switchboxAt(sbx, sby + offset).pins.push_back(pin);
             }
         }
     } else if (rule == PinRuleInput || rule == PinRuleOutput || rule == PinRuleInputS || rule == PinRuleOutputS) {
         int offset = pinSwitchBoxMap[rule][inst->slot];
-        vector<Pin *> &sbPins = switchboxes[sbx][sby + offset]->pins;
+        vector<Pin *> &sbPins = switchboxAt(sbx, sby + offset).pins;
         sbPins.insert(sbPins.end(), inst->pins.begin(), inst->pins.end());
     } else if (rule == PinRuleNone) {
         sby = y + site->h / 2;
-        vector<Pin *> &sbPins = switchboxes[sbx][sby]->pins;
+        vector<Pin *> &sbPins = switchboxAt(sbx, sby).pins;
         sbPins.insert(sbPins.end(), inst->pins.begin(), inst->pins.end());
     } else {
         printlog(LOG_ERROR, "pin mapping rule not handled");
@@ -796,13 +764,13 @@ void Database::setSwitchBoxPins(Instance *inst) {
 void Database::setSwitchBoxPins() {
     for (int x = 0; x < switchbox_nx; x++) {
         for (int y = 0; y < switchbox_ny; y++) {
-            switchboxes[x][y]->pins.clear();
+            switchboxAt(x, y).pins.clear();
         }
     }
     Site *prevSite = NULL;
     for (int x = 0; x < sitemap_nx; x++) {
         for (int y = 0; y < sitemap_ny; y++) {
-            Site *site = sites[x][y];
+            Site *site = siteAt(x, y);
             if (site->pack == NULL || site == prevSite) continue;
             for (auto inst : site->pack->instances) {
                 if (inst != NULL) setSwitchBoxPins(inst);
@@ -818,13 +786,13 @@ void Database::setCellPinIndex() {
         printlog(LOG_ERROR, "FF not found");
     } else {
         for (unsigned int i = 0; i < FF->pins.size(); ++i) {
-            if (FF->pins[i]->name == "C") {
+            if (strcmp(FF->pins[i]->name, "C") == 0) {
                 clkPinIdx = i;
-            } else if (FF->pins[i]->name == "R") {
+            } else if (strcmp(FF->pins[i]->name, "R") == 0) {
                 srPinIdx = i;
-            } else if (FF->pins[i]->name == "CE") {
+            } else if (strcmp(FF->pins[i]->name, "CE") == 0) {
                 cePinIdx = i;
-            } else if (FF->pins[i]->name == "D") {
+            } else if (strcmp(FF->pins[i]->name, "D") == 0) {
                 ffIPinIdx = i;
             }
         }
@@ -8,6 +8,7 @@
 #include "swbox.h"
 #include "group.h"
 #include "clkrgn.h"
+#include "names.h"
 
 using namespace std;
 
@@ -16,11 +17,11 @@ namespace db {
 class Database {
 private:
     // net
-    unordered_map<string, Net*> name_nets;
+    vector<Net*> name_nets;  // by name id
 
     // instance
     unordered_map<Master::Name, Master*, hash<int>> name_masters;
-    unordered_map<string, Instance*> name_instances;
+    vector<Instance*> name_instances;  // by name id
 
     // site
     unordered_map<Resource::Name, Resource*, hash<int>> name_resources;
@@ -28,6 +29,7 @@ private:
 
 public:
     string bmName = "";  // benchmark name (for dev)
+    NameTable names;     // of instances, nets and pin types
     Database();
     ~Database();
     void setup();
@@ -44,10 +46,11 @@ public:
     vector<Resource*> resources;
     vector<SiteType*> sitetypes;
     vector<Pack*> packs;
-    vector<vector<Site*>> sites;
+    vector<Site*> sites;  // x-major, see siteAt
     int sitemap_nx;
     int sitemap_ny;
     void setSiteMap(int nx, int ny);
+    Site*& siteAt(int x, int y) { return sites[x * sitemap_ny + y]; }  // unchecked
     bool place(Instance* instance, int x, int y, int slot);
     bool place(Instance* instance, Site* site, int slot);
     bool unplace(Instance* instance);
@@ -58,10 +61,15 @@ public:
     void ClearEmptyPack();
 
     // swbox
-    vector<vector<SwitchBox*>> switchboxes;
+    vector<SwitchBox> switchboxes;  // x-major, see switchboxAt
     int switchbox_nx;
     int switchbox_ny;
+    // routing resources of the i-th connection of switchbox (x, y) are at connectionIdx(x, y, i)
+    vector<int> switchboxSupply;
+    vector<int> switchboxDemand;
     void setSwitchBoxes(int nx, int ny);
+    SwitchBox& switchboxAt(int x, int y) { return switchboxes[x * switchbox_ny + y]; }  // unchecked
+    int connectionIdx(int x, int y, int i) const { return (x * switchbox_ny + y) * SWITCHBOX_NUM_CONNECTIONS + i; }
     bool setDemand(int x1, int y1, int x2, int y2, int demand);
     bool setDemand(SwitchBox* a, SwitchBox* b, int demand);
     bool setSupply(int x1, int y1, int x2, int y2, int supply);
@@ -117,15 +125,18 @@ public:
     SiteType* addSiteType(const SiteType& sitetype);
     Site* addSite(int x, int y, SiteType* sitetype);
     Pack* addPack(SiteType* sitetype);
-    SwitchBox* addSwitchBox(int x, int y);
 
     Master* getMaster(Master::Name name);
     Instance* getInstance(const string& name);
     Net* getNet(const string& name);
     Resource* getResource(Resource::Name name);
     SiteType* getSiteType(SiteType::Name name);
-    Site* getSite(int x, int y);
-    SwitchBox* getSwitchBox(int x, int y);
+    Site* getSite(int x, int y) {
+        return (unsigned)x < (unsigned)sitemap_nx && (unsigned)y < (unsigned)sitemap_ny ? siteAt(x, y) : NULL;
+    }
+    SwitchBox* getSwitchBox(int x, int y) {
+        return (unsigned)x < (unsigned)switchbox_nx && (unsigned)y < (unsigned)switchbox_ny ? &switchboxAt(x, y) : NULL;
+    }
 
     /***** File IO (defined in db_bookshelf.cpp) *****/
     bool readAux(string file);
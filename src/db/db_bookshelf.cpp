@@ -101,11 +101,13 @@ bool Database::readNodes(string file) {
         if (instance != NULL) {
             printlog(LOG_ERROR, "Instance duplicated: %s", tokens[0].c_str());
         } else {
-            Master *master = database.getMaster(Master::NameString2Enum(tokens[1]));
+            Master::Name name;
+            if (!Master::NameString2Enum(tokens[1], name)) return false;
+            Master *master = database.getMaster(name);
             if (master == NULL) {
                 printlog(LOG_ERROR, "Master not found: %s", tokens[1].c_str());
             } else {
-                Instance newinstance(tokens[0], master);
+                Instance newinstance(tokens[0].c_str(), master);
                 instance = database.addInstance(newinstance);
             }
         }
@@ -133,7 +135,7 @@ bool Database::readNets(string file) {
             if (net != NULL) {
                 printlog(LOG_ERROR, "Net duplicated: %s", tokens[1].c_str());
             } else {
-                Net newnet(tokens[1]);
+                Net newnet(tokens[1].c_str());
                 net = database.addNet(newnet);
             }
         } else if (tokens[0] == "endnet") {
@@ -160,7 +162,7 @@ bool Database::readNets(string file) {
     }
 
     fs.close();
-    return false;
+    return true;
 }
 
 bool Database::readPl(string file) {
@@ -200,9 +202,11 @@ bool Database::readScl(string file) {
     vector<string> tokens;
     while (read_line_as_tokens(fs, tokens)) {
         if (tokens[0] == "SITE") {
-            SiteType *sitetype = database.getSiteType(SiteType::NameString2Enum(tokens[1]));
+            SiteType::Name siteTypeName;
+            if (!SiteType::NameString2Enum(tokens[1], siteTypeName)) return false;
+            SiteType *sitetype = database.getSiteType(siteTypeName);
             if (sitetype == NULL) {
-                SiteType newsitetype(SiteType::NameString2Enum(tokens[1]));
+                SiteType newsitetype(siteTypeName);
                 sitetype = database.addSiteType(newsitetype);
             } else {
                 printlog(LOG_WARN, "Duplicated site type: %s", sitetype->name);
@@ -211,9 +215,11 @@ bool Database::readScl(string file) {
                 if (tokens[0] == "END" && tokens[1] == "SITE") {
                     break;
                 }
-                Resource *resource = database.getResource(Resource::NameString2Enum(tokens[0]));
+                Resource::Name resourceName;
+                if (!Resource::NameString2Enum(tokens[0], resourceName)) return false;
+                Resource *resource = database.getResource(resourceName);
                 if (resource == NULL) {
-                    Resource newresource(Resource::NameString2Enum(tokens[0]));
+                    Resource newresource(resourceName);
                     resource = database.addResource(newresource);
                 }
                 sitetype->addResource(resource, atoi(tokens[1].c_str()));
@@ -224,13 +230,17 @@ bool Database::readScl(string file) {
                 if (tokens[0] == "END" && tokens[1] == "RESOURCES") {
                     break;
                 }
-                Resource *resource = database.getResource(Resource::NameString2Enum(tokens[0]));
+                Resource::Name resourceName;
+                if (!Resource::NameString2Enum(tokens[0], resourceName)) return false;
+                Resource *resource = database.getResource(resourceName);
                 if (resource == NULL) {
-                    Resource newresource(Resource::NameString2Enum(tokens[0]));
+                    Resource newresource(resourceName);
                     resource = database.addResource(newresource);
                 }
                 for (int i = 1; i < (int)tokens.size(); i++) {
-                    Master *master = database.getMaster(Master::NameString2Enum(tokens[i]));
+                    Master::Name masterName;
+                    if (!Master::NameString2Enum(tokens[i], masterName)) return false;
+                    Master *master = database.getMaster(masterName);
                     if (master == NULL) {
                         printlog(LOG_ERROR, "Master not found: %s", tokens[i].c_str());
                     } else {
@@ -250,7 +260,9 @@ bool Database::readScl(string file) {
                 }
                 int x = atoi(tokens[0].c_str());
                 int y = atoi(tokens[1].c_str());
-                SiteType *sitetype = database.getSiteType(SiteType::NameString2Enum(tokens[2]));
+                SiteType::Name siteTypeName;
+                if (!SiteType::NameString2Enum(tokens[2], siteTypeName)) return false;
+                SiteType *sitetype = database.getSiteType(siteTypeName);
                 if (sitetype == NULL) {
                     printlog(LOG_ERROR, "Site type not found: %s", tokens[2].c_str());
                 } else {
@@ -296,9 +308,11 @@ bool Database::readLib(string file) {
     Master *master = NULL;
     while (read_line_as_tokens(fs, tokens)) {
         if (tokens[0] == "CELL") {
-            master = database.getMaster(Master::NameString2Enum(tokens[1]));
+            Master::Name name;
+            if (!Master::NameString2Enum(tokens[1], name)) return false;
+            master = database.getMaster(name);
             if (master == NULL) {
-                Master newmaster(Master::NameString2Enum(tokens[1]));
+                Master newmaster(name);
                 master = database.addMaster(newmaster);
             } else {
                 printlog(LOG_WARN, "Duplicated master: %s", tokens[1].c_str());
@@ -347,7 +361,7 @@ bool Database::writePl(string file) {
         Instance *instance = *ii;
         if (instance->pack == NULL || instance->pack->site == NULL) {
             if (nErrorLimit > 0) {
-                printlog(LOG_ERROR, "Instance not placed: %s", instance->name.c_str());
+                printlog(LOG_ERROR, "Instance not placed: %s", instance->name);
                 nErrorLimit--;
             } else if (nErrorLimit == 0) {
                 printlog(LOG_ERROR, "(Remaining same errors are not shown)");
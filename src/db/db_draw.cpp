@@ -94,7 +94,7 @@ void Database::drawSites() {
 
     for (int x = 0; x < sitemap_nx; x++) {
         for (int y = 0; y < sitemap_ny; y++) {
-            Site *site = sites[x][y];
+            Site *site = siteAt(x, y);
             if (site != NULL && site->x == x && site->y == y) {
                 int color = colors[site->type];
                 canvas->SetFillColor(color);
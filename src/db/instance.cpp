@@ -4,37 +4,38 @@
 using namespace db;
 
 /***** Master *****/
-Master::Name Master::NameString2Enum(const string &name) {
+bool Master::NameString2Enum(const string &name, Master::Name &res) {
     if (name == "LUT1")
-        return LUT1;
+        res = LUT1;
     else if (name == "LUT2")
-        return LUT2;
+        res = LUT2;
     else if (name == "LUT3")
-        return LUT3;
+        res = LUT3;
     else if (name == "LUT4")
-        return LUT4;
+        res = LUT4;
     else if (name == "LUT5")
-        return LUT5;
+        res = LUT5;
     else if (name == "LUT6")
-        return LUT6;
+        res = LUT6;
     else if (name == "FDRE")
-        return FDRE;
+        res = FDRE;
     else if (name == "CARRY8")
-        return CARRY8;
+        res = CARRY8;
     else if (name == "DSP48E2")
-        return DSP48E2;
+        res = DSP48E2;
     else if (name == "RAMB36E2")
-        return RAMB36E2;
+        res = RAMB36E2;
     else if (name == "IBUF")
-        return IBUF;
+        res = IBUF;
     else if (name == "OBUF")
-        return OBUF;
+        res = OBUF;
     else if (name == "BUFGCE")
-        return BUFGCE;
+        res = BUFGCE;
     else {
-        cerr << "unknown master name: " << name << endl;
-        exit(1);
+        printlog(LOG_ERROR, "Unknown master: %s", name.c_str());
+        return false;
     }
+    return true;
 }
 
 string masterNameStrs[] = {
@@ -64,8 +65,11 @@ Master::~Master() {
 void Master::addPin(PinType &pin) { pins.push_back(new PinType(pin)); }
 
 PinType *Master::getPin(const string &name) {
+    int nameId = database.names.find(name);
+    if (nameId < 0) return NULL;
+    const char *str = database.names.str(nameId);
     for (int i = 0; i < (int)pins.size(); i++) {
-        if (pins[i]->name == name) {
+        if (pins[i]->name == str) {
             return pins[i];
         }
     }
@@ -75,6 +79,7 @@ PinType *Master::getPin(const string &name) {
 /***** Instance *****/
 Instance::Instance() {
     id = -1;
+    name = NULL;
     master = NULL;
     pack = NULL;
     slot = -1;
@@ -82,7 +87,7 @@ Instance::Instance() {
     inputFixed = false;
 }
 
-Instance::Instance(const string &name, Master *master) {
+Instance::Instance(const char *name, Master *master) {
     this->id = -1;
     this->name = name;
     this->master = master;
@@ -118,8 +123,11 @@ Instance::~Instance() {
 }
 
 Pin *Instance::getPin(const string &name) {
+    int nameId = database.names.find(name);
+    if (nameId < 0) return NULL;
+    const char *str = database.names.str(nameId);
     for (int i = 0; i < (int)pins.size(); i++) {
-        if (pins[i]->type->name == name) {
+        if (pins[i]->type->name == str) {
             return pins[i];
         }
     }
@@ -29,7 +29,7 @@ public:
         OBUF,
         BUFGCE  // IO: input buf, output buf, clock buf
     };
-    static Name NameString2Enum(const string &name);
+    static bool NameString2Enum(const string &name, Name &res);  // false (with an error) if unknown
     static string NameEnum2String(const Master::Name &name);
 
     Name name;
@@ -48,7 +48,7 @@ public:
 class Instance {
 public:
     int id;
-    string name;
+    const char *name;  // interned by Database::addInstance
     Master *master;
     Pack *pack;
     int slot;
@@ -57,7 +57,7 @@ public:
     vector<Pin *> pins;
 
     Instance();
-    Instance(const string &name, Master *master);
+    Instance(const char *name, Master *master);
     Instance(const Instance &instance);
     ~Instance();
 
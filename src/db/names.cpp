@@ -0,0 +1,62 @@
+#include "names.h"
+
+using namespace db;
+
+NameTable::NameTable() : _slots(1024, -1), _blockUsed(BlockSize) {}
+
+NameTable::~NameTable() {
+    for (auto block : _blocks) delete[] block;
+}
+
+// FNV-1a
+uint32_t NameTable::hash(const char* name, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)name[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+int NameTable::probe(const char* name, size_t len, uint32_t h) const {
+    size_t mask = _slots.size() - 1;
+    for (size_t s = h & mask;; s = (s + 1) & mask) {
+        int id = _slots[s];
+        if (id < 0) return s;
+        if (_hashes[id] == h && memcmp(_strs[id], name, len) == 0 && _strs[id][len] == '\0') return s;
+    }
+}
+
+int NameTable::find(const char* name, size_t len) const { return _slots[probe(name, len, hash(name, len))]; }
+
+int NameTable::intern(const char* name, size_t len) {
+    uint32_t h = hash(name, len);
+    int s = probe(name, len, h);
+    if (_slots[s] >= 0) return _slots[s];
+
+    if (_blockUsed + len + 1 > BlockSize) {
+        _blocks.push_back(new char[max(BlockSize, len + 1)]);
+        _blockUsed = 0;
+    }
+    char* str = _blocks.back() + _blockUsed;
+    memcpy(str, name, len);
+    str[len] = '\0';
+    _blockUsed += len + 1;
+
+    int id = _strs.size();
+    _strs.push_back(str);
+    _hashes.push_back(h);
+    _slots[s] = id;
+    if (_strs.size() * 2 > _slots.size()) rehash(_slots.size() * 2);
+    return id;
+}
+
+void NameTable::rehash(size_t nSlots) {
+    _slots.assign(nSlots, -1);
+    size_t mask = nSlots - 1;
+    for (int id = 0; id < (int)_strs.size(); id++) {
+        size_t s = _hashes[id] & mask;
+        while (_slots[s] >= 0) s = (s + 1) & mask;
+        _slots[s] = id;
+    }
+}
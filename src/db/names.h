@@ -0,0 +1,39 @@
+#pragma once
+
+#include "../global.h"
+
+namespace db {
+
+// Interns names into one arena. Each distinct name has a 32-bit id (in insertion order) and a stable
+// NUL-terminated copy, so interned names can be compared by pointer.
+class NameTable {
+public:
+    NameTable();
+    NameTable(const NameTable&) = delete;
+    NameTable& operator=(const NameTable&) = delete;
+    ~NameTable();
+
+    int find(const char* name, size_t len) const;  // -1 if not interned
+    int find(const string& name) const { return find(name.data(), name.size()); }
+    int intern(const char* name, size_t len);
+    int intern(const string& name) { return intern(name.data(), name.size()); }
+    int intern(const char* name) { return intern(name, strlen(name)); }
+
+    const char* str(int id) const { return _strs[id]; }
+    int size() const { return _strs.size(); }
+
+private:
+    vector<const char*> _strs;  // by id
+    vector<uint32_t> _hashes;   // by id
+    vector<int> _slots;         // open addressing with linear probing, -1 if empty
+    vector<char*> _blocks;
+    size_t _blockUsed;
+
+    static const size_t BlockSize = 1 << 20;
+
+    static uint32_t hash(const char* name, size_t len);
+    int probe(const char* name, size_t len, uint32_t h) const;  // slot of the name or the empty slot to insert
+    void rehash(size_t nSlots);
+};
+
+}  // namespace db
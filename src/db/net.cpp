@@ -4,10 +4,13 @@
 using namespace db;
 
 /***** PinType *****/
-PinType::PinType() { type = 'x'; }
+PinType::PinType() {
+    name = NULL;
+    type = 'x';
+}
 
 PinType::PinType(const string &name, char type) {
-    this->name = name;
+    this->name = database.names.str(database.names.intern(name));
     this->type = type;
 }
 
@@ -42,9 +45,9 @@ Pin::Pin(const Pin &pin) {
 }
 
 /***** Net *****/
-Net::Net() {}
+Net::Net() { name = NULL; }
 
-Net::Net(const string &name) {
+Net::Net(const char *name) {
     this->name = name;
     this->pins.resize(1, NULL);
     this->isClk = false;
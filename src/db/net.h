@@ -10,7 +10,7 @@ class Site;
 
 class PinType {
 public:
-    string name;
+    const char *name;  // interned, so pin types compare names by pointer
     char type;
     /*
        I = primary input
@@ -40,12 +40,12 @@ public:
 class Net {
 public:
     int id;
-    std::string name;
+    const char *name;  // interned by Database::addNet
     std::vector<Pin *> pins;
     bool isClk;
 
     Net();
-    Net(const string &name);
+    Net(const char *name);
     Net(const Net &net);
     ~Net();
 
@@ -4,25 +4,26 @@
 using namespace db;
 
 /***** Resource *****/
-Resource::Name Resource::NameString2Enum(const string &name) {
+bool Resource::NameString2Enum(const string &name, Resource::Name &res) {
     using db::Resource;
 
     if (name == "LUT")
-        return LUT;
+        res = LUT;
     else if (name == "FF")
-        return FF;
+        res = FF;
     else if (name == "CARRY8")
-        return CARRY8;
+        res = CARRY8;
     else if (name == "DSP48E2")
-        return DSP48E2;
+        res = DSP48E2;
     else if (name == "RAMB36E2")
-        return RAMB36E2;
+        res = RAMB36E2;
     else if (name == "IO")
-        return IO;
+        res = IO;
     else {
-        cerr << "unknown master name: " << name << endl;
-        exit(1);
+        printlog(LOG_ERROR, "Unknown resource: %s", name.c_str());
+        return false;
     }
+    return true;
 }
 
 string resourceNameStrs[] = {"LUT", "FF", "CARRY8", "DSP48E2", "RAMB36E2", "IO"};
@@ -41,20 +42,21 @@ void Resource::addMaster(Master *master) {
 }
 
 /***** SiteType *****/
-SiteType::Name SiteType::NameString2Enum(const string &name) {
+bool SiteType::NameString2Enum(const string &name, SiteType::Name &res) {
     using db::SiteType;
     if (name == "SLICE")
-        return SLICE;
+        res = SLICE;
     else if (name == "DSP")
-        return DSP;
+        res = DSP;
     else if (name == "BRAM")
-        return BRAM;
+        res = BRAM;
     else if (name == "IO")
-        return IO;
+        res = IO;
     else {
-        cerr << "unknown site type name: " << name << endl;
-        exit(1);
+        printlog(LOG_ERROR, "Unknown site type: %s", name.c_str());
+        return false;
     }
+    return true;
 }
 
 string siteTypeNameStrs[] = {"SLICE", "DSP", "BRAM", "IO"};
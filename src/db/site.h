@@ -12,7 +12,7 @@ class Pack;
 class Resource {
 public:
     enum Name { LUT, FF, CARRY8, DSP48E2, RAMB36E2, IO };
-    static Name NameString2Enum(const string &name);
+    static bool NameString2Enum(const string &name, Name &res);  // false (with an error) if unknown
     static string NameEnum2String(const Resource::Name &name);
 
     Name name;
@@ -28,7 +28,7 @@ public:
 class SiteType {
 public:
     enum Name { SLICE, DSP, BRAM, IO };
-    static Name NameString2Enum(const string &name);
+    static bool NameString2Enum(const string &name, Name &res);  // false (with an error) if unknown
     static string NameEnum2String(const SiteType::Name &name);
 
     int id;
@@ -5,36 +5,25 @@ using namespace db;
 
 /***** SwitchBox *****/
 
-#define SWITCHBOX_CONNECT_MAX_DISTANCE 6
-
 SwitchBox::SwitchBox() {
     x = -1;
     y = -1;
-    connections.resize(SWITCHBOX_CONNECT_MAX_DISTANCE * 4, NULL);
-    supply.resize(SWITCHBOX_CONNECT_MAX_DISTANCE * 4, 0);
-    demand.resize(SWITCHBOX_CONNECT_MAX_DISTANCE * 4, 0);
 }
 
 SwitchBox::SwitchBox(int x, int y) {
     this->x = x;
     this->y = y;
-    this->connections.resize(SWITCHBOX_CONNECT_MAX_DISTANCE * 4, NULL);
-    this->supply.resize(SWITCHBOX_CONNECT_MAX_DISTANCE * 4, 0);
-    this->demand.resize(SWITCHBOX_CONNECT_MAX_DISTANCE * 4, 0);
 }
 
 SwitchBox::SwitchBox(const SwitchBox &switchbox) {
     x = switchbox.x;
     y = switchbox.y;
     sites = switchbox.sites;
-    connections = switchbox.connections;
-    supply = switchbox.supply;
-    demand = switchbox.demand;
 }
 
 bool SwitchBox::getSwitchBoxOffset(int i, int &x, int &y) {
     x = y = 0;
-    if (i < 0 || i >= SWITCHBOX_CONNECT_MAX_DISTANCE * 4) {
+    if (i < 0 || i >= SWITCHBOX_NUM_CONNECTIONS) {
         return false;
     }
     int direction = i % 4;
@@ -1315,13 +1304,13 @@ void Database::setPinMap() {
     for (int i = 0; i < (int)dsp->pins.size(); i++) {
         auto p0i = DSP0PinMap.find(dsp->pins[i]->name);
         if (p0i == DSP0PinMap.end()) {
-            printlog(LOG_ERROR, "pin not found on DSP0: %s", dsp->pins[i]->name.c_str());
+            printlog(LOG_ERROR, "pin not found on DSP0: %s", dsp->pins[i]->name);
         } else {
             pinSwitchBoxMap[PinRuleDSP0][i] = p0i->second;
         }
         auto p1i = DSP1PinMap.find(dsp->pins[i]->name);
         if (p1i == DSP0PinMap.end()) {
-            printlog(LOG_ERROR, "pin not found on DSP1: %s", dsp->pins[i]->name.c_str());
+            printlog(LOG_ERROR, "pin not found on DSP1: %s", dsp->pins[i]->name);
         } else {
             pinSwitchBoxMap[PinRuleDSP1][i] = p1i->second;
         }
@@ -1331,7 +1320,7 @@ void Database::setPinMap() {
     for (int i = 0; i < (int)bram->pins.size(); i++) {
         auto bi = BRAMPinMap.find(bram->pins[i]->name);
         if (bi == BRAMPinMap.end()) {
-            printlog(LOG_ERROR, "pin not found on BRAM: %s", bram->pins[i]->name.c_str());
+            printlog(LOG_ERROR, "pin not found on BRAM: %s", bram->pins[i]->name);
         } else {
             pinSwitchBoxMap[PinRuleBRAM][i] = bi->second;
         }
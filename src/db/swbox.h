@@ -2,20 +2,20 @@
 
 #include "../global.h"
 
+#define SWITCHBOX_CONNECT_MAX_DISTANCE 6
+#define SWITCHBOX_NUM_CONNECTIONS (SWITCHBOX_CONNECT_MAX_DISTANCE * 4)
+
 namespace db {
 
 class Site;
 class Pin;
 
+// routing supply/demand of the connections are kept by Database in flat arrays
 class SwitchBox {
 public:
     int x, y;
     std::vector<Site *> sites;
-    std::vector<SwitchBox *> connections;
     std::vector<Pin *> pins;
-    // for global routing
-    std::vector<int> supply;
-    std::vector<int> demand;
 
     SwitchBox();
     SwitchBox(int x, int y);
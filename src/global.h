@@ -30,6 +30,7 @@
 #include <boost/functional/hash.hpp>
 
 #include "utils/log.h"
+#include "utils/prof.h"
 #include "utils/misc.h"
 #include "utils/geo.h"
 
@@ -37,12 +38,22 @@ using namespace std;
 
 class Setting {
 public:
-    enum AlgoFlow { Flow_Tdm_Part, Flow_Tdm_Place, Flow_Tdm_Time };
+    enum AlgoFlow { Flow_Tdm_Part, Flow_Tdm_Place, Flow_Tdm_Time, Flow_Tdm_Sweep };
 
     enum ContMethod { Tdm_ILP, Tdm_LP, Tdm_Lag, Tdm_Iter, Tdm_None };
 
     enum LgMethod { Lg_Disp, Lg_SR, Lg_None, Lg_MaxDisp };
 
+    enum PrecondMethod { Precond_Jacobi, Precond_IC, Precond_AMG };
+
+    enum UBMethod { UB_Spread, UB_Electro };
+
+    enum Precision { Precision_Double, Precision_Float };
+
+    enum SimdIsa { Simd_Auto, Simd_Off, Simd_Scalar, Simd_SSE42, Simd_AVX2, Simd_AVX512 };
+
+    enum LagUpdate { LagUpdate_Geometric, LagUpdate_Polyak, LagUpdate_Momentum, LagUpdate_Nesterov, LagUpdate_Bundle };
+
     string io_out;
     string io_aux;
     string io_nodes;
@@ -51,24 +62,56 @@ public:
     string io_wts;
     string io_scl;
     string io_lib;
+    string io_report;
+    string io_eco;      // delta file of an incremental run
+    string io_ecoBase;  // solution of the run the delta is applied to
+    string io_serve;    // unix socket of the server mode
+    string io_sweep;    // scenarios of tdm_sweep
+    string io_board;    // wires between pairs of devices
     int nPartition;
 
     AlgoFlow flow;
     ContMethod cont;
     LgMethod lg;
+    PrecondMethod precond;
+    UBMethod ub;
+    Precision precision;  // of the timing and the multipliers of the Lagrangian iterations
+    SimdIsa simd;         // of the timing propagation, Simd_Off for the propagation over the nodes and edges
+    LagUpdate lagUpdate;  // step of the Lagrangian multipliers
     int nThreads;
+    int gpThreads;  // of the global placement, half of them for the SpMVs of x and of y
     int lagIter;
+    int partSeeds;       // independent partitions, the best cut is kept
+    int partTimingIter;  // rounds of timing-driven net costs for partitioning, 0 for unit costs
+    bool partFork;       // the seeds in child processes, one after another if false (e.g., in the library)
     bool doRefine;
     bool computeDual;
+    bool binSol;  // final solution in the binary format of TdmDB::writeSol instead of text
+    bool presolve;  // fix the vars far from critical before the optimization
+    bool ecoSave;   // save the Lagrangian multipliers of tdm_time for the warm start of -ecoBase runs
+    int serveJobs;  // concurrent jobs of the server, 0 for cores / nThreads
 
     Setting() {
         cont = Tdm_Lag;
         lg = Lg_MaxDisp;
         flow = Flow_Tdm_Time;
+        precond = Precond_Jacobi;
+        ub = UB_Spread;
+        precision = Precision_Double;
+        simd = Simd_Auto;
+        lagUpdate = LagUpdate_Geometric;
         nThreads = 8;
+        gpThreads = 2;
         lagIter = 1000;
+        partSeeds = 1;
+        partTimingIter = 0;
+        partFork = true;
         doRefine = false;
         computeDual = false;
+        presolve = false;
+        ecoSave = false;
+        binSol = false;
+        serveJobs = 0;
     }
 };
 
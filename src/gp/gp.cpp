@@ -5,6 +5,7 @@
 #include "gp.h"
 
 void gplace(vector<Group> &groups) {
+    PROF_SCOPE("gplace");
     printlog(LOG_INFO, "");
     gp_copy_in(groups, true);
     GP_Main();
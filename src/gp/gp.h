@@ -3,6 +3,10 @@
 
 #include "gp_setting.h"
 
-void gplace(vector<Group> &groups);
+namespace db {
+class Group;
+}
+
+void gplace(vector<db::Group> &groups);
 
 #endif
@@ -43,10 +43,10 @@ int numDBinY;
 double DBinW;
 double DBinH;
 // legalization bin
-vector<vector<vector<LGBin> > > LGGrid; // information of each bin    [fence][binx][biny]
+vector<LGFenceGrid> LGGrid;             // legalization bins and their cells [fence]
 vector<vector<double> > LGTD;           // target density of each bin [binx][biny]
-vector<list<OFBin> > OFBins;            // [fence][bin]
-vector<vector<vector<char> > > OFMap;   // mark if a bin is handled   [fence][binx][biny]
+vector<vector<OFBin> > OFBins;          // [fence][bin]
+vector<int> LGCellBin;                  // bin index of each cell in its fence grid
 int LGNumX;
 int LGNumY;
 double LGBinW;
@@ -112,7 +112,7 @@ void reset(){
     LGGrid.clear();
     LGTD.clear();
     OFBins.clear();
-    OFMap.clear();
+    LGCellBin.clear();
     LGNumX = 0;
     LGNumY = 0;
     LGBinW = 0;
@@ -254,7 +254,7 @@ void gp_copy_group_in(vector<Group> &groups){
 
         for(auto pin : net->pins){
             if(pin == NULL){
-                printlog(LOG_WARN, "null pin found in net: %s", net->name.c_str());
+                printlog(LOG_WARN, "null pin found in net: %s", net->name);
                 continue;
             }
             if(pin->instance != NULL && pin->instance->fixed){
@@ -347,7 +347,7 @@ void gp_copy_group_in(vector<Group> &groups){
     }
     for(int x=0; x<database.sitemap_nx; x++){
         for(int y=0; y<database.sitemap_ny; y++){
-            int fence = database.sites[x][y]->type->id;
+            int fence = database.siteAt(x, y)->type->id;
             fenceFreeArea[fence] += 1.0;
         }
     }
@@ -415,7 +415,7 @@ void gp_copy_group_in(vector<Group> &groups){
     }
     for(int x=0; x<database.sitemap_nx; x++){
         for(int i=0; i<numFences; i++){
-            if(regions[i].type != database.sites[x][0]->type){
+            if(regions[i].type != database.siteAt(x, 0)->type){
                 continue;
             }
             FRect rect(x, 0, x+1, database.sitemap_ny);
@@ -48,10 +48,10 @@ extern int numDBinY;
 extern double DBinW;
 extern double DBinH;
 // legalization bin
-extern vector<vector<vector<LGBin> > > LGGrid;  // information of each bin    [fence][binx][biny]
-extern vector<vector<double> > LGTD;            // target density of each bin [binx][biny]
-extern vector<list<OFBin> > OFBins;             // [fence][bin]
-extern vector<vector<vector<char> > > OFMap;    // mark if a bin is handled   [fence][binx][biny]
+extern vector<LGFenceGrid> LGGrid;             // legalization bins and their cells [fence]
+extern vector<vector<double> > LGTD;           // target density of each bin [binx][biny]
+extern vector<vector<OFBin> > OFBins;          // [fence][bin]
+extern vector<int> LGCellBin;                  // bin index of each cell in its fence grid
 extern int LGNumX;
 extern int LGNumY;
 extern double LGBinW;
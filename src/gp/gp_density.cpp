@@ -0,0 +1,326 @@
+#include "gp_setting.h"
+#include "gp_data.h"
+#include "gp_spread.h"
+#include "gp_density.h"
+
+#include <complex>
+#include <memory>
+
+// complex DFT of any length n in place, X[k] = sum_j x[j] exp(-2 pi i k j / n): mixed-radix Cooley-Tukey over the
+// factors 4, 2, 3, 5 and other primes up to maxRadix, otherwise Bluestein's chirp-z transform through a convolution
+// of a power-of-two length m >= 2n - 1
+class FFT {
+private:
+    static const int maxRadix = 31;
+
+    int n;
+    vector<int> factors;  // radix and remaining length of each stage
+    vector<complex<double>> tw;  // exp(-2 pi i k / n)
+    vector<complex<double>> out, scratch;
+
+    unique_ptr<FFT> conv;             // of length m for Bluestein
+    vector<complex<double>> chirp;     // exp(-pi i k^2 / n)
+    vector<complex<double>> chirpDFT;  // DFT of the conjugate chirp, wrapped around m
+    vector<complex<double>> work;
+
+    void butterfly(complex<double>* f, int fstride, int p, int m) {
+        if (p == 2) {
+            for (int k = 0; k < m; k++) {
+                complex<double> t = f[k + m] * tw[k * fstride];
+                f[k + m] = f[k] - t;
+                f[k] += t;
+            }
+        } else if (p == 4) {
+            for (int k = 0; k < m; k++) {
+                complex<double> s0 = f[k + m] * tw[k * fstride];
+                complex<double> s1 = f[k + 2 * m] * tw[2 * k * fstride];
+                complex<double> s2 = f[k + 3 * m] * tw[3 * k * fstride];
+                complex<double> s5 = f[k] - s1;
+                f[k] += s1;
+                complex<double> s3 = s0 + s2, s4 = s0 - s2;
+                f[k + 2 * m] = f[k] - s3;
+                f[k] += s3;
+                f[k + m] = complex<double>(s5.real() + s4.imag(), s5.imag() - s4.real());
+                f[k + 3 * m] = complex<double>(s5.real() - s4.imag(), s5.imag() + s4.real());
+            }
+        } else {
+            scratch.resize(p);
+            for (int u = 0; u < m; u++) {
+                for (int q = 0; q < p; q++) scratch[q] = f[u + q * m];
+                for (int q = 0; q < p; q++) {
+                    int k = u + q * m, idx = 0;
+                    complex<double> sum = scratch[0];
+                    for (int j = 1; j < p; j++) {
+                        idx += fstride * k;  // < n
+                        if (idx >= n) idx -= n;
+                        sum += scratch[j] * tw[idx];
+                    }
+                    f[k] = sum;
+                }
+            }
+        }
+    }
+
+    // f[0..p*m) = DFT of in[0], in[stride], .. at the stage of factors[stage]
+    void transform(complex<double>* f, const complex<double>* in, int fstride, int stage) {
+        int p = factors[stage], m = factors[stage + 1];
+        if (m == 1) {
+            for (int q = 0; q < p; q++) f[q] = in[q * fstride];
+        } else {
+            for (int q = 0; q < p; q++) transform(f + q * m, in + q * fstride, fstride * p, stage + 2);
+        }
+        butterfly(f, fstride, p, m);
+    }
+
+public:
+    void init(int _n) {
+        n = _n;
+        factors.clear();
+        int rest = n, p = 4;
+        while (rest > 1) {
+            while (rest % p != 0) {
+                p = (p == 4) ? 2 : (p == 2) ? 3 : p + 2;
+                if (p * p > rest) p = rest;
+            }
+            rest /= p;
+            factors.push_back(p);
+            factors.push_back(rest);
+        }
+        bool direct = factors.empty() || factors[factors.size() - 2] <= maxRadix;
+        for (unsigned i = 0; direct && i < factors.size(); i += 2) direct = factors[i] <= maxRadix;
+        conv.reset();
+        if (direct) {
+            tw.resize(n);
+            for (int k = 0; k < n; k++) tw[k] = polar(1.0, -2 * M_PI * k / n);
+            out.resize(n);
+            return;
+        }
+        int m = 1;
+        while (m < 2 * n - 1) m <<= 1;
+        conv.reset(new FFT());
+        conv->init(m);
+        chirp.resize(n);
+        for (int k = 0; k < n; k++) chirp[k] = polar(1.0, -M_PI * (double)((long long)k * k % (2 * n)) / n);
+        chirpDFT.assign(m, 0.0);
+        chirpDFT[0] = conj(chirp[0]);
+        for (int k = 1; k < n; k++) chirpDFT[k] = chirpDFT[m - k] = conj(chirp[k]);
+        conv->forward(chirpDFT);
+        work.resize(m);
+    }
+
+    void forward(vector<complex<double>>& a) {
+        if (!conv) {
+            if (n == 1) return;
+            transform(out.data(), a.data(), 1, 0);
+            copy(out.begin(), out.end(), a.begin());
+            return;
+        }
+        int m = work.size();
+        for (int k = 0; k < n; k++) work[k] = a[k] * chirp[k];
+        fill(work.begin() + n, work.end(), 0.0);
+        conv->forward(work);
+        // inverse DFT of the product by conjugation
+        for (int k = 0; k < m; k++) work[k] = conj(work[k] * chirpDFT[k]);
+        conv->forward(work);
+        for (int k = 0; k < n; k++) a[k] = conj(work[k]) * chirp[k] / (double)m;
+    }
+
+    // X[k] = sum_j x[j] exp(2 pi i k j / n)
+    void backward(vector<complex<double>>& a) {
+        for (int k = 0; k < n; k++) a[k] = conj(a[k]);
+        forward(a);
+        for (int k = 0; k < n; k++) a[k] = conj(a[k]);
+    }
+};
+
+// cosine and sine transforms on n bin centers through a DFT of length n (Makhoul), omega[u] = pi * u / n,
+// the elements of a line are a[0], a[stride], .., a[(n - 1) * stride]
+class DCT {
+private:
+    int n;
+    FFT fft;
+    vector<complex<double>> shift;  // exp(-i omega[u] / 2)
+    vector<complex<double>> buf;
+
+    // even elements of the line first, then the odd ones backwards
+    inline int order(int x) const { return (x % 2 == 0) ? x / 2 : n - 1 - x / 2; }
+
+public:
+    vector<double> omega;
+
+    void init(int _n) {
+        n = _n;
+        fft.init(n);
+        omega.resize(n);
+        shift.resize(n);
+        for (int u = 0; u < n; u++) {
+            omega[u] = M_PI * u / n;
+            shift[u] = polar(1.0, -0.5 * omega[u]);
+        }
+        buf.resize(n);
+    }
+
+    // a[u] = sum_x a[x] cos(omega[u] * (x + 0.5))
+    void dct(double* a, int stride) {
+        for (int x = 0; x < n; x++) buf[order(x)] = a[x * stride];
+        fft.forward(buf);
+        for (int u = 0; u < n; u++) a[u * stride] = real(shift[u] * buf[u]);
+    }
+    // a[x] = sum_u a[u] cos(omega[u] * (x + 0.5))
+    void idct(double* a, int stride) {
+        double a0 = a[0];
+        buf[0] = a0;
+        for (int u = 1; u < n; u++) buf[u] = conj(shift[u]) * complex<double>(a[u * stride], -a[(n - u) * stride]);
+        fft.backward(buf);
+        for (int x = 0; x < n; x++) a[x * stride] = 0.5 * (real(buf[order(x)]) + a0);
+    }
+    // a[x] = sum_u a[u] sin(omega[u] * (x + 0.5)), as sin(omega[u] * (x + 0.5)) = (-1)^x cos(omega[n - u] * (x + 0.5))
+    void idst(double* a, int stride) {
+        a[0] = 0.0;
+        for (int u = 1, w = n - 1; u < w; u++, w--) swap(a[u * stride], a[w * stride]);
+        idct(a, stride);
+        for (int x = 1; x < n; x += 2) a[x * stride] = -a[x * stride];
+    }
+};
+
+// Solve the Poisson equation lap(psi) = -rho with Neumann boundary on an nx * ny grid by DCT,
+// the field ex, ey = -grad(psi) is sampled at bin centers, all arrays are indexed [x * ny + y]
+class ElectroField {
+private:
+    int nx, ny;
+    DCT bx, by;
+    vector<double> coef;
+
+public:
+    vector<double> ex;
+    vector<double> ey;
+
+    void init(int _nx, int _ny) {
+        nx = _nx;
+        ny = _ny;
+        bx.init(nx);
+        by.init(ny);
+        coef.resize(nx * ny);
+        ex.resize(nx * ny);
+        ey.resize(nx * ny);
+    }
+
+    void solve(const vector<double>& rho) {
+        // coef(u,v) = sum_x sum_y rho(x,y) cos_u(x) cos_v(y), scaled for the inverse transform
+        coef = rho;
+        for (int x = 0; x < nx; x++) by.dct(&coef[x * ny], 1);
+        for (int y = 0; y < ny; y++) bx.dct(&coef[y], ny);
+        for (int u = 0; u < nx; u++)
+            for (int v = 0; v < ny; v++) {
+                double scale = (u == 0 ? 1.0 : 2.0) * (v == 0 ? 1.0 : 2.0) / (nx * ny);
+                double w2 = bx.omega[u] * bx.omega[u] + by.omega[v] * by.omega[v];
+                // potential coefficient, the DC term (mean density) does not create a field
+                coef[u * ny + v] = (u == 0 && v == 0) ? 0.0 : coef[u * ny + v] * scale / w2;
+            }
+
+        // ex(x,y) = sum_u sum_v coef(u,v) omega_u sin_u(x) cos_v(y)
+        for (int u = 0; u < nx; u++)
+            for (int v = 0; v < ny; v++) ex[u * ny + v] = coef[u * ny + v] * bx.omega[u];
+        for (int u = 0; u < nx; u++) by.idct(&ex[u * ny], 1);
+        for (int y = 0; y < ny; y++) bx.idst(&ex[y], ny);
+
+        // ey(x,y) = sum_u sum_v coef(u,v) omega_v cos_u(x) sin_v(y)
+        for (int u = 0; u < nx; u++)
+            for (int v = 0; v < ny; v++) ey[u * ny + v] = coef[u * ny + v] * by.omega[v];
+        for (int u = 0; u < nx; u++) by.idst(&ey[u * ny], 1);
+        for (int y = 0; y < ny; y++) bx.idct(&ey[y], ny);
+    }
+};
+
+// cloud-in-cell weights of a point between the two nearest bin centers
+inline void cicWeights(double pos, double lo, double binSize, int n, int& i0, int& i1, double& w0) {
+    double f = (pos - lo) / binSize - 0.5;
+    i0 = (int)floor(f);
+    w0 = 1.0 - (f - i0);
+    i1 = i0 + 1;
+    i0 = max(0, min(n - 1, i0));
+    i1 = max(0, min(n - 1, i1));
+}
+
+// one gradient step of the cells in fence r along the electric field of (cell area - usable area)
+void electroStepFence(int r, ElectroField& field, vector<double>& rho) {
+    const auto& grid = LGGrid[r];
+    double binArea = LGBinW * LGBinH;
+    for (int b = 0; b < LGNumX * LGNumY; b++) rho[b] = -grid.bins[b].uArea / binArea;
+    for (auto i : grid.cells) {
+        int x0, x1, y0, y1;
+        double wx, wy;
+        cicWeights(cellX[i], coreLX, LGBinW, LGNumX, x0, x1, wx);
+        cicWeights(cellY[i], coreLY, LGBinH, LGNumY, y0, y1, wy);
+        double q = cellW[i] * cellH[i] / binArea;
+        rho[x0 * LGNumY + y0] += q * wx * wy;
+        rho[x0 * LGNumY + y1] += q * wx * (1 - wy);
+        rho[x1 * LGNumY + y0] += q * (1 - wx) * wy;
+        rho[x1 * LGNumY + y1] += q * (1 - wx) * (1 - wy);
+    }
+    field.solve(rho);
+
+    // field at cells, the step moves the most pushed cell by epStepRatio bins
+    vector<double> fx(grid.cells.size()), fy(grid.cells.size());
+    double maxF = 0.0;
+    for (unsigned k = 0; k < grid.cells.size(); k++) {
+        int i = grid.cells[k];
+        int x0, x1, y0, y1;
+        double wx, wy;
+        cicWeights(cellX[i], coreLX, LGBinW, LGNumX, x0, x1, wx);
+        cicWeights(cellY[i], coreLY, LGBinH, LGNumY, y0, y1, wy);
+        int b00 = x0 * LGNumY + y0, b01 = x0 * LGNumY + y1, b10 = x1 * LGNumY + y0, b11 = x1 * LGNumY + y1;
+        fx[k] = wx * (wy * field.ex[b00] + (1 - wy) * field.ex[b01]) +
+                (1 - wx) * (wy * field.ex[b10] + (1 - wy) * field.ex[b11]);
+        fy[k] = wx * (wy * field.ey[b00] + (1 - wy) * field.ey[b01]) +
+                (1 - wx) * (wy * field.ey[b10] + (1 - wy) * field.ey[b11]);
+        maxF = max(maxF, max(std::abs(fx[k]), std::abs(fy[k])));
+    }
+    if (maxF == 0.0) return;
+    double stepX = gpSetting.epStepRatio * LGBinW / maxF;
+    double stepY = gpSetting.epStepRatio * LGBinH / maxF;
+    for (unsigned k = 0; k < grid.cells.size(); k++) {
+        int i = grid.cells[k];
+        cellX[i] = max(coreLX + 0.5 * cellW[i], min(coreHX - 0.5 * cellW[i], cellX[i] + stepX * fx[k]));
+        cellY[i] = max(coreLY + 0.5 * cellH[i], min(coreHY - 0.5 * cellH[i], cellY[i] + stepY * fy[k]));
+    }
+}
+
+void electroSpreadCells(int binSize, int times) {
+    initSpreadCells(binSize);
+    updateTargetDensity();
+    updateBinUsableArea();
+
+    vector<ElectroField> fields(numFences);
+    vector<vector<double>> rhos(numFences, vector<double>(LGNumX * LGNumY));
+    for (auto& field : fields) field.init(LGNumX, LGNumY);
+
+    int nSteps = times * gpSetting.epSteps;
+    int step = 0;
+    double ofRatio = overfillRatio();  // also buckets the cells of each fence
+    for (; step < nSteps && ofRatio >= gpSetting.epStopOF; step++) {
+        // fences are independent
+        int rIdx = 0;
+        std::mutex idx_mutex;
+        auto thread_func = [&]() {
+            int r;
+            while (true) {
+                idx_mutex.lock();
+                r = rIdx++;
+                idx_mutex.unlock();
+                if (r >= numFences) break;
+                if (!LGGrid[r].cells.empty()) electroStepFence(r, fields[r], rhos[r]);
+            }
+        };
+        int nThreads = min(gpSetting.nThreads, numFences);
+        if (nThreads <= 1) {
+            thread_func();
+        } else {
+            std::thread threads[nThreads];
+            for (int i = 0; i < nThreads; i++) threads[i] = std::thread(thread_func);
+            for (int i = 0; i < nThreads; i++) threads[i].join();
+        }
+        ofRatio = overfillRatio();
+    }
+    printlog(LOG_VERBOSE, "electro: %d steps, OF=%.4lf", step, ofRatio);
+}
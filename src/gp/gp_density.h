@@ -0,0 +1,7 @@
+#ifndef _GP_DENSITY_H_
+#define _GP_DENSITY_H_
+
+// electrostatic (ePlace-style) spreading on the legalization grid
+void electroSpreadCells(int binSize, int times);
+
+#endif
@@ -2,6 +2,7 @@
 #include "gp_data.h"
 #include "gp_qsolve.h"
 #include "gp_spread.h"
+#include "gp_density.h"
 #include "gp_main.h"
 #include "global.h"
 
@@ -78,7 +79,13 @@ void drawNet(string file) {
 #endif
 }
 
-void upperBound(int binSize, int legalTimes) { spreadCells(binSize, legalTimes); }
+void upperBound(int binSize, int legalTimes) {
+    PROF_SCOPE("upperBound");
+    if (gpSetting.ubMethod == Setting::UB_Electro)
+        electroSpreadCells(binSize, legalTimes);
+    else
+        spreadCells(binSize, legalTimes);
+}
 
 void GP_Main() {
     static int GPCount = 0;
@@ -119,8 +126,10 @@ void GP_Main() {
 
     //--Global Placement Iteration
     double PW = PWBegin;
+    double lastLBWL = 0.0;
     for (int iter = 1; iter <= gs.mainWLIter; iter++, PW += PWStep) {
         printlog(LOG_INFO, " = = = = GP iteration %d = = = =", iter);
+        prof::count("iterations");
 
         //--Upper Bound
         upperBound((database.crmap_nx == 0) ? 3 : 1, gs.ubIter);
@@ -134,13 +143,30 @@ void GP_Main() {
         lowerBound(0.001, PW, gs.lbIter, fence);
 
         hpwlxy = hpwl(&hpwlx, &hpwly);
-        printlog(LOG_INFO, "LB WL: %ld (x: %ld, y: %ld)", (long)hpwlxy, (long)hpwlx, (long)hpwly);
+        double maxOFRatio;
+        double ofRatio = overfillRatio(&maxOFRatio);
+        printlog(LOG_INFO,
+                 "LB WL: %ld (x: %ld, y: %ld), OF: %.4lf (max %.4lf)",
+                 (long)hpwlxy,
+                 (long)hpwlx,
+                 (long)hpwly,
+                 ofRatio,
+                 maxOFRatio);
         drawCell("gp" + to_string(GPCount) + "_lo" + to_string(iter));
+
+        //--Convergence: LB stops moving and is almost spread
+        if (iter > 1 && fabs(hpwlxy - lastLBWL) < gs.stopWLRatio * lastLBWL && ofRatio < gs.stopOFRatio &&
+            maxOFRatio < gs.stopMaxOFRatio) {
+            printlog(LOG_INFO, "GP converges at iteration %d, %d of %d skipped", iter, gs.mainWLIter - iter, gs.mainWLIter);
+            break;
+        }
+        lastLBWL = hpwlxy;
     }
 
-    //--Final Upper Bound
+    //--Final Upper Bound (always by bin spreading, which resolves the remaining overfill)
     if (gs.finalIter > 0) {
-        upperBound((database.crmap_nx == 0) ? 3 : 1, gs.finalIter);
+        PROF_SCOPE("finalUpperBound");
+        spreadCells((database.crmap_nx == 0) ? 3 : 1, gs.finalIter);
         hpwlxy = hpwl(&hpwlx, &hpwly);
         printlog(LOG_INFO, "UB WL: %ld (x: %ld, y: %ld)", (long)hpwlxy, (long)hpwlx, (long)hpwly);
     }
@@ -1,23 +1,275 @@
 #include "../alg/Eigen/Eigen"
+#include <condition_variable>
+#include <memory>
 
 #include "gp_data.h"
 #include "gp_qsolve.h"
 #include "gp_region.h"
 
-//#define MATRIX_LO_UP_MODE // for Eigen CG solver
-
 double MinCellDist = 1;  // to avoid zero distance between two cells
 int CGi_max = 500;       // maximum iteration times of CG
 
 int nMovables = 0;
 int nConnects = 0;
 
+typedef Eigen::SparseMatrix<double, Eigen::RowMajor> SpMat;
+
+const int SpMVMinRows = 4096;  // minimum rows per thread to worth a chunk of its own
+
+// y = A * x, rows are split into chunks of similar #non-zeros; the threads are kept for the SpMVs of one CG solve,
+// and the caller computes the first chunk
+class SpMVTeam {
+private:
+    vector<thread> workers;
+    mutex mtx;
+    condition_variable startCv, doneCv;
+    int generation = 0;
+    int pending = 0;
+    bool quit = false;
+
+    const SpMat* A = NULL;
+    const Eigen::VectorXd* x = NULL;
+    Eigen::VectorXd* y = NULL;
+    vector<int> bounds;  // chunk t is [bounds[t], bounds[t + 1])
+
+    void rows(int begin, int end) {
+        const int* outer = A->outerIndexPtr();
+        const int* inner = A->innerIndexPtr();
+        const double* val = A->valuePtr();
+        for (int i = begin; i < end; ++i) {
+            double sum = 0;
+            for (int k = outer[i]; k < outer[i + 1]; ++k) sum += val[k] * (*x)[inner[k]];
+            (*y)[i] = sum;
+        }
+    }
+
+    void work(int t) {
+        int done = 0;
+        unique_lock<mutex> lock(mtx);
+        while (true) {
+            startCv.wait(lock, [&] { return quit || generation != done; });
+            if (quit) return;
+            done = generation;
+            lock.unlock();
+            rows(bounds[t], bounds[t + 1]);
+            lock.lock();
+            if (--pending == 0) doneCv.notify_one();
+        }
+    }
+
+public:
+    explicit SpMVTeam(int nThreads) : bounds(max(1, nThreads) + 1) {
+        for (int t = 1; t < nThreads; ++t) workers.emplace_back(&SpMVTeam::work, this, t);
+    }
+    ~SpMVTeam() {
+        {
+            lock_guard<mutex> lock(mtx);
+            quit = true;
+        }
+        startCv.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    void spmv(const SpMat& A_, const Eigen::VectorXd& x_, Eigen::VectorXd& y_) {
+        A = &A_;
+        x = &x_;
+        y = &y_;
+        int n = A->rows();
+        y->resize(n);
+        int nChunks = min((int)workers.size() + 1, n / SpMVMinRows);
+        if (nChunks <= 1) {
+            rows(0, n);
+            return;
+        }
+        const int* outer = A->outerIndexPtr();
+        long nnz = outer[n];
+        bounds[0] = 0;
+        for (int t = 1; t < (int)bounds.size(); ++t)
+            bounds[t] = (t >= nChunks) ? n : lower_bound(outer + bounds[t - 1], outer + n, nnz * t / nChunks) - outer;
+        {
+            lock_guard<mutex> lock(mtx);
+            pending = workers.size();
+            ++generation;
+        }
+        startCv.notify_all();
+        rows(bounds[0], bounds[1]);
+        unique_lock<mutex> lock(mtx);
+        doneCv.wait(lock, [&] { return pending == 0; });
+    }
+};
+
+// z = M^-1 r
+class CGPreconditioner {
+public:
+    virtual ~CGPreconditioner() {}
+    virtual void compute(const SpMat& A, SpMVTeam& team) = 0;
+    virtual void solve(const Eigen::VectorXd& r, Eigen::VectorXd& z) const = 0;
+};
+
+class JacobiPreconditioner : public CGPreconditioner {
+private:
+    Eigen::VectorXd invDiag;
+
+public:
+    void compute(const SpMat& A, SpMVTeam& team) {
+        invDiag.setOnes(A.rows());
+        for (int i = 0; i < A.rows(); ++i) {
+            double d = A.coeff(i, i);
+            if (d != 0) invDiag[i] = 1.0 / d;
+        }
+    }
+    void solve(const Eigen::VectorXd& r, Eigen::VectorXd& z) const { z = invDiag.cwiseProduct(r); }
+};
+
+// incomplete Cholesky, falls back to Jacobi if the factorization breaks down
+class ICPreconditioner : public CGPreconditioner {
+private:
+    Eigen::IncompleteCholesky<double, Eigen::Lower> ic;
+    JacobiPreconditioner jacobi;
+    bool ok;
+
+public:
+    void compute(const SpMat& A, SpMVTeam& team) {
+        Eigen::SparseMatrix<double> colA(A);
+        ic.compute(colA);
+        ok = (ic.info() == Eigen::Success);
+        if (!ok) {
+            printlog(LOG_WARN, "incomplete Cholesky fails, use Jacobi instead");
+            jacobi.compute(A, team);
+        }
+    }
+    void solve(const Eigen::VectorXd& r, Eigen::VectorXd& z) const {
+        if (ok)
+            z = ic.solve(r);
+        else
+            jacobi.solve(r, z);
+    }
+};
+
+// one V-cycle of unsmoothed aggregation multigrid with damped Jacobi smoothing
+class AggregationPreconditioner : public CGPreconditioner {
+private:
+    struct Level {
+        SpMat A;
+        Eigen::VectorXd invDiag;
+        vector<int> agg;  // fine row -> coarse row
+        int nCoarse;
+    };
+    const int coarseSize = 500;
+    const int maxLevels = 12;
+    const double omega = 2.0 / 3.0;
+
+    vector<Level> levels;
+    Eigen::SparseMatrix<double> coarseA;
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> coarse;
+    SpMVTeam* team;
+
+    // pair each row with its strongest free neighbor, leftovers join their strongest neighbor
+    static int aggregate(const SpMat& A, vector<int>& agg) {
+        int n = A.rows();
+        int nc = 0;
+        agg.assign(n, -1);
+        for (int i = 0; i < n; ++i) {
+            if (agg[i] != -1) continue;
+            int best = -1;
+            double bestW = 0;
+            for (SpMat::InnerIterator it(A, i); it; ++it) {
+                int j = it.index();
+                if (j != i && agg[j] == -1 && -it.value() > bestW) {
+                    best = j;
+                    bestW = -it.value();
+                }
+            }
+            if (best != -1) {
+                agg[i] = agg[best] = nc++;
+                continue;
+            }
+            for (SpMat::InnerIterator it(A, i); it; ++it) {
+                int j = it.index();
+                if (j != i && agg[j] != -1 && -it.value() > bestW) {
+                    best = j;
+                    bestW = -it.value();
+                }
+            }
+            agg[i] = (best == -1) ? nc++ : agg[best];
+        }
+        return nc;
+    }
+
+    void vcycle(int l, const Eigen::VectorXd& r, Eigen::VectorXd& z) const {
+        if (l == (int)levels.size()) {
+            z = coarse.solve(r);
+            return;
+        }
+        const Level& lv = levels[l];
+        Eigen::VectorXd Az;
+        z = omega * lv.invDiag.cwiseProduct(r);
+        team->spmv(lv.A, z, Az);
+        Eigen::VectorXd rc = Eigen::VectorXd::Zero(lv.nCoarse);
+        for (int i = 0; i < lv.A.rows(); ++i) rc[lv.agg[i]] += r[i] - Az[i];
+        Eigen::VectorXd zc;
+        vcycle(l + 1, rc, zc);
+        for (int i = 0; i < lv.A.rows(); ++i) z[i] += zc[lv.agg[i]];
+        team->spmv(lv.A, z, Az);
+        z += omega * lv.invDiag.cwiseProduct(r - Az);
+    }
+
+public:
+    void compute(const SpMat& A, SpMVTeam& team_) {
+        team = &team_;
+        levels.clear();
+        const SpMat* fine = &A;
+        SpMat next;
+        while (fine->rows() > coarseSize && (int)levels.size() < maxLevels) {
+            levels.emplace_back();
+            Level& lv = levels.back();
+            lv.A = *fine;
+            lv.nCoarse = aggregate(lv.A, lv.agg);
+            lv.invDiag.setOnes(lv.A.rows());
+            for (int i = 0; i < lv.A.rows(); ++i) {
+                double d = lv.A.coeff(i, i);
+                if (d != 0) lv.invDiag[i] = 1.0 / d;
+            }
+            // Galerkin coarse matrix P^T A P with piecewise constant P
+            vector<Eigen::Triplet<double>> triplets;
+            triplets.reserve(lv.A.nonZeros());
+            for (int i = 0; i < lv.A.rows(); ++i)
+                for (SpMat::InnerIterator it(lv.A, i); it; ++it)
+                    triplets.emplace_back(lv.agg[i], lv.agg[it.index()], it.value());
+            next.resize(lv.nCoarse, lv.nCoarse);
+            next.setFromTriplets(triplets.begin(), triplets.end());
+            fine = &next;
+            if (lv.nCoarse > 0.8 * lv.A.rows()) break;  // coarsening stagnates
+        }
+        // regularize empty or singular (floating) rows of the coarsest matrix
+        coarseA = *fine;
+        for (int i = 0; i < coarseA.rows(); ++i) {
+            double d = coarseA.coeff(i, i);
+            coarseA.coeffRef(i, i) = (d == 0) ? 1.0 : d * (1.0 + 1e-8);
+        }
+        coarse.compute(coarseA);
+        printlog(LOG_VERBOSE, "AMG: %d levels, coarsest %d", (int)levels.size() + 1, (int)coarseA.rows());
+    }
+    void solve(const Eigen::VectorXd& r, Eigen::VectorXd& z) const { vcycle(0, r, z); }
+};
+
+CGPreconditioner* newPreconditioner(Setting::PrecondMethod method) {
+    switch (method) {
+        case Setting::Precond_IC:
+            return new ICPreconditioner();
+        case Setting::Precond_AMG:
+            return new AggregationPreconditioner();
+        default:
+            return new JacobiPreconditioner();
+    }
+}
+
 // Eigen (TODO: lo, hi)
 class SpMatSolver {
 private:
     // Ax=b, lo[i]<=x[i]<=hi[i]
     // Mat A, sparse, PSD
-    vector<Eigen::Triplet<double>> A_nondig;  // A(i,j), Lower
+    vector<Eigen::Triplet<double>> A_nondig;  // A(i,j), both Lower and Upper
     vector<double> A_dig;                     // A(i,i)
     Eigen::VectorXd b;                        // Vec b, dense
     Eigen::VectorXd x;                        // variables
@@ -25,6 +277,8 @@ private:
 public:
     int numIter;
     double err;
+    double initErr;  // relative residual of the initial guess
+    double time;  // seconds, including preconditioner setup
 
     inline double getLoc(int i) { return x[i]; }
     inline void setLoc(int i, double v) { x[i] = v; }
@@ -59,15 +313,8 @@ public:
         if (mov1 && mov2) {
             A_dig[i1] += w;
             A_dig[i2] += w;
-#ifdef MATRIX_LO_UP_MODE
             A_nondig.emplace_back(i1, i2, -w);
             A_nondig.emplace_back(i2, i1, -w);
-#else
-            if (i1 < i2)
-                A_nondig.emplace_back(i1, i2, -w);
-            else
-                A_nondig.emplace_back(i2, i1, -w);
-#endif
         } else if (mov1) {
             A_dig[i1] += w;
             b[i1] += w * x2;
@@ -82,28 +329,54 @@ public:
         b[i] += w * x[i];
     }
 
-    void compute(int maxIter, double tolerance) {
+    // preconditioned CG (same iteration as Eigen::ConjugateGradient) with threaded SpMV
+    void compute(int maxIter, double tolerance, Setting::PrecondMethod method, int nThreads) {
+        timer::timer t;
         // load A
         for (int i = 0; i < nMovables; ++i)
             if (A_dig[i] != 0) A_nondig.emplace_back(i, i, A_dig[i]);
-        Eigen::SparseMatrix<double> A;
+        SpMat A;
         A.resize(nMovables, nMovables);
         A.setFromTriplets(A_nondig.begin(), A_nondig.end());
 
-        // compute x (TODO: OpenMP)
-#ifdef MATRIX_LO_UP_MODE
-        Eigen::ConjugateGradient<Eigen::SparseMatrix<double>, Eigen::Lower | Eigen::Upper> cg;
-#else
-        Eigen::ConjugateGradient<Eigen::SparseMatrix<double>, Eigen::Upper> cg;
-#endif
-        cg.setMaxIterations(maxIter);
-        cg.setTolerance(tolerance);
-        cg.compute(A);
-        x = cg.solveWithGuess(b, x);
-        numIter = cg.iterations();
-        err = cg.error();
-        // cout << "#iterations:     " << cg.iterations() << endl;
-        // cout << "estimated error: " << cg.error()      << endl;
+        numIter = 0;
+        err = initErr = 0;
+        double bNorm2 = b.squaredNorm();
+        if (bNorm2 == 0) {
+            x.setZero();
+            time = t.elapsed();
+            return;
+        }
+
+        SpMVTeam team(min(nThreads, nMovables / SpMVMinRows));
+        Eigen::VectorXd r, Ap;
+        team.spmv(A, x, Ap);
+        r = b - Ap;
+        double threshold = tolerance * tolerance * bNorm2;
+        double rNorm2 = r.squaredNorm();
+        initErr = sqrt(rNorm2 / bNorm2);
+        if (rNorm2 >= threshold) {
+            unique_ptr<CGPreconditioner> precond(newPreconditioner(method));
+            precond->compute(A, team);
+            Eigen::VectorXd p, z;
+            precond->solve(r, p);
+            double absNew = r.dot(p);
+            while (numIter < maxIter) {
+                team.spmv(A, p, Ap);
+                double alpha = absNew / p.dot(Ap);
+                x += alpha * p;
+                r -= alpha * Ap;
+                rNorm2 = r.squaredNorm();
+                if (rNorm2 < threshold) break;
+                precond->solve(r, z);
+                double absOld = absNew;
+                absNew = r.dot(z);
+                p = z + (absNew / absOld) * p;
+                ++numIter;
+            }
+        }
+        err = sqrt(rNorm2 / bNorm2);
+        time = t.elapsed();
     }
 };
 
@@ -229,32 +502,67 @@ void pseudonetAddInC_b(double alpha) {
     }
 }
 
+void buildB2BSystem(double pseudoAlpha) {
+    for (auto& sol : solvers) sol.reset();
+
+    B2BModel();
+
+    if (pseudoAlpha > 0.0) {
+        pseudonetAddInC_b(pseudoAlpha);
+    }
+}
+
+int solveB2BSystem(double epsilon) {
+    // x and y are solved concurrently, each with half of the threads for SpMV
+    if (gpSetting.nThreads > 1) {
+        thread t[2];
+        int nSpMVThreads = max(1, gpSetting.nThreads / 2);
+        auto thread_func = [&](int idx) { solvers[idx].compute(CGi_max, epsilon, gpSetting.precond, nSpMVThreads); };
+        for (int i = 0; i < 2; ++i) t[i] = thread(thread_func, i);
+        for (int i = 0; i < 2; ++i) t[i].join();
+    } else {
+        for (int i = 0; i < 2; ++i) solvers[i].compute(CGi_max, epsilon, gpSetting.precond, 1);
+    }
+    return solvers[0].numIter + solvers[1].numIter;
+}
+
 void lowerBound(double epsilon, double pseudoAlpha, int repeat, LBMode mode, double maxDisp) {
+    PROF_SCOPE("lowerBound");
     initCG();
 
+    int totIter = 0, nSolved = 0;
+    double maxErr = 0, totTime = 0;
     for (int r = 0; r < repeat; r++) {
-        for (auto& sol : solvers) sol.reset();
+        buildB2BSystem(pseudoAlpha);
+        totIter += solveB2BSystem(epsilon);
+        printlog(LOG_VERBOSE,
+                 "\tCG #%d: it=%d/%d, init err=%e/%e, err=%e/%e, time=%.3lf/%.3lf",
+                 r,
+                 solvers[0].numIter,
+                 solvers[1].numIter,
+                 solvers[0].initErr,
+                 solvers[1].initErr,
+                 solvers[0].err,
+                 solvers[1].err,
+                 solvers[0].time,
+                 solvers[1].time);
+        maxErr = max(maxErr, max(solvers[0].err, solvers[1].err));
+        totTime += solvers[0].time + solvers[1].time;
+        ++nSolved;
 
-        B2BModel();
-
-        if (pseudoAlpha > 0.0) {
-            pseudonetAddInC_b(pseudoAlpha);
-        }
-
-        if (gpSetting.nThreads > 1) {
-            thread t[2];
-            auto thread_func = [&](int idx) { solvers[idx].compute(CGi_max, epsilon); };
-            for (int i = 0; i < 2; ++i) t[i] = thread(thread_func, i);
-            for (int i = 0; i < 2; ++i) t[i].join();
-        } else {
-            for (int i = 0; i < 2; ++i) solvers[i].compute(CGi_max, epsilon);
-        }
-        // double wlX, wlY;
-        // hpwl(&wlX, &wlY);
-        // solvers[0].finish(cellX);
-        // solvers[1].finish(cellY);
-        // printlog(LOG_INFO, "\tCG #%d: wl=%ld+%ld, it=%d/%d, err=%e/%e", r, (long)wlX, (long)wlY,
-        //     solvers[0].numIter, solvers[1].numIter, solvers[0].err, solvers[1].err);
+        // B2B model reaches its fixed point, the remaining repeats would not move cells
+        if (r > 0 && solvers[0].initErr < gpSetting.lbStopErr && solvers[1].initErr < gpSetting.lbStopErr) break;
+    }
+    prof::count("cgIterations", totIter);
+    if (repeat > 0) {
+        printlog(LOG_INFO,
+                 "CG (%s): %d/%d repeats, %d iterations, max err=%e, time=%.3lf",
+                 precond2str(gpSetting.precond).c_str(),
+                 nSolved,
+                 repeat,
+                 totIter,
+                 maxErr,
+                 totTime);
     }
     solvers[0].finish(cellX);
     solvers[1].finish(cellY);
@@ -6,5 +6,10 @@
 void initLowerBound();
 void lowerBound(double epsilon, double pseudoAlpha, int repeat, LBMode mode, double maxDisp=-1);
 
+// steps of one lowerBound repeat, also used by the benchmarks
+void initCG();                                // load the current cell locations
+void buildB2BSystem(double pseudoAlpha);      // B2B net model (+ pseudonets) into Ax=b
+int solveB2BSystem(double epsilon);           // returns the total CG iterations of x and y
+
 #endif
 
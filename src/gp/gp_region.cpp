@@ -1,7 +1,7 @@
 #include "gp_data.h"
 #include "gp_region.h"
 
-void findCellRegionDist() {
+bool findCellRegionDist() {
     for (int i = 0; i < numCells; i++) {
         // for each cell, find nearest region block
         double x = cellX[i];
@@ -47,14 +47,15 @@ void findCellRegionDist() {
             }
         }
         if (regionr < 0) {
-            cerr << "no rect defined for region " << region << endl;
-            exit(1);
+            printlog(LOG_ERROR, "no rect defined for region %d", region);
+            return false;
         }
         cellFenceX[i] = regionx;
         cellFenceY[i] = regiony;
         cellFenceRect[i] = regionr;
         cellFenceDist[i] = dist;
     }
+    return true;
 }
 /*int legal_count=0;
 void legalizeRegion(){
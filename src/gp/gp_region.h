@@ -1,7 +1,7 @@
 #ifndef _GP_REGION_H_
 #define _GP_REGION_H_
 
-void findCellRegionDist();
+bool findCellRegionDist();  // false if a region has no rect
 void legalizeRegion();
 
 #endif
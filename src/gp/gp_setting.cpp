@@ -51,8 +51,10 @@ void GPSetting::setDefault() {
 #ifdef SINGLE_THREAD
     nThreads = 1;
 #else
-    nThreads = 2;
+    nThreads = max(1, setting.gpThreads);
 #endif
+    precond = setting.precond;
+    ubMethod = setting.ub;
     initIter = 0;
     mainWLIter = 0;
     mainCongIter = 0;
@@ -65,6 +67,14 @@ void GPSetting::setDefault() {
     ioNetWeight = 1.0;
     expandBoxRatio = 0.0;
     expandBoxLimit = 0.2;
+    stopWLRatio = 0.005;
+    stopOFRatio = 0.1;
+    stopMaxOFRatio = 1.0;
+    lbStopErr = 0.01;
+    ubStopDisp = 0.01;
+    epSteps = 20;
+    epStepRatio = 0.5;
+    epStopOF = 0.1;
     pseudoNetWeightRatioX = 1.2;
     pseudoNetWeightRatioY = 0.6;
     enableFence = false;
@@ -116,8 +126,22 @@ void GPSetting::set3c() {
 
 inline string bool2str(bool b) { return b ? "true" : "false"; }
 
+string precond2str(Setting::PrecondMethod precond) {
+    switch (precond) {
+        case Setting::Precond_Jacobi:
+            return "Jacobi";
+        case Setting::Precond_IC:
+            return "IC";
+        case Setting::Precond_AMG:
+            return "AMG";
+    }
+    return "unknown";
+}
+
 void GPSetting::print() {
     printlog(LOG_INFO, "nThreads    : %d", nThreads);
+    printlog(LOG_INFO, "precond     : %s", precond2str(precond).c_str());
+    printlog(LOG_INFO, "ubMethod    : %s", ubMethod == Setting::UB_Electro ? "Electro" : "Spread");
     printlog(LOG_INFO, "initIter    : %d", initIter);
     printlog(LOG_INFO, "mainWLIter  : %d", mainWLIter);
     printlog(LOG_INFO, "mainCongIter: %d", mainCongIter);
@@ -127,6 +151,10 @@ void GPSetting::print() {
     printlog(LOG_INFO, "pseudoNetWeightEnd   : %lf", pseudoNetWeightEnd);
     printlog(LOG_INFO, "degreeNetWeight      : %lf", degreeNetWeight);
     printlog(LOG_INFO, "ioNetWeight          : %lf", ioNetWeight);
+    printlog(LOG_INFO, "stopWLRatio : %lf", stopWLRatio);
+    printlog(LOG_INFO, "stopOFRatio : %lf (max %lf)", stopOFRatio, stopMaxOFRatio);
+    printlog(LOG_INFO, "lbStopErr   : %lf", lbStopErr);
+    printlog(LOG_INFO, "ubStopDisp  : %lf", ubStopDisp);
     printlog(LOG_INFO, "enableFence : %s", bool2str(enableFence).c_str());
     printlog(LOG_INFO, "packed      : %s", bool2str(packed).c_str());
     printlog(LOG_INFO, "useLastXY   : %s", bool2str(useLastXY).c_str());
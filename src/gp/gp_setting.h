@@ -8,6 +8,8 @@ enum LBMode { LBModeSimple = 1, LBModeFenceBBox = 2, LBModeFenceRect = 3 };
 class GPSetting {
 public:
     int nThreads;
+    Setting::PrecondMethod precond;  // preconditioner of the lower-bound CG
+    Setting::UBMethod ubMethod;      // upper-bound spreading of the main iterations
 
     int initIter;
     int mainWLIter;
@@ -22,6 +24,18 @@ public:
     double expandBoxRatio;
     double expandBoxLimit;
 
+    // convergence criteria
+    double stopWLRatio;     // GP stops if the relative change of LB WL is below it,
+    double stopOFRatio;     // total overfill / cell area is below it,
+    double stopMaxOFRatio;  // and the max overfill ratio of a bin is below it
+    double lbStopErr;       // CG repeats stop if the initial residual of the B2B model is below it
+    double ubStopDisp;      // spreading stops if the average cell displacement is below it
+
+    // electrostatic spreading
+    int epSteps;         // gradient steps per upper-bound pass
+    double epStepRatio;  // max cell move per step, in bins
+    double epStopOF;     // stop when total overfill / cell area is below it
+
     double pseudoNetWeightRatioX;
     double pseudoNetWeightRatioY;
 
@@ -45,4 +59,6 @@ public:
 
 extern GPSetting gpSetting;
 
+string precond2str(Setting::PrecondMethod precond);
+
 #endif
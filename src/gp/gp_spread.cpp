@@ -43,44 +43,94 @@ public:
 inline bool cmpX(const int& a, const int& b) { return cellX[a] < cellX[b]; }
 inline bool cmpY(const int& a, const int& b) { return cellY[a] < cellY[b]; }
 
+void LGFenceGrid::bucket(const vector<int>& binOf) {
+    int nBins = bins.size();
+    binStart.assign(nBins + 1, 0);
+    for (auto i : cells) binStart[binOf[i] + 1]++;
+    for (int b = 0; b < nBins; b++) binStart[b + 1] += binStart[b];
+    vector<int> pos(binStart.begin(), binStart.end() - 1);
+    vector<int> sorted(cells.size());
+    for (auto i : cells) sorted[pos[binOf[i]]++] = i;
+    cells.swap(sorted);
+    binBox.assign(nBins, -1);
+    boxes.clear();
+}
+
+void LGFenceGrid::bucketBox(
+    int id, int lx, int ly, int hx, int hy, const vector<int>& boxCells, const vector<int>& binOf) {
+    Box& box = boxes[id];
+    box.lx = lx;
+    box.ly = ly;
+    box.hx = hx;
+    box.hy = hy;
+    int ny = hy - ly + 1;
+    int nBins = (hx - lx + 1) * ny;
+    auto local = [&](int i) { return (binOf[i] / numY - lx) * ny + binOf[i] % numY - ly; };
+    box.binStart.assign(nBins + 1, 0);
+    for (auto i : boxCells) box.binStart[local(i) + 1]++;
+    for (int b = 0; b < nBins; b++) box.binStart[b + 1] += box.binStart[b];
+    vector<int> pos(box.binStart.begin(), box.binStart.end() - 1);
+    box.cells.resize(boxCells.size());
+    for (auto i : boxCells) box.cells[pos[local(i)]++] = i;
+    for (int x = lx; x <= hx; x++)
+        for (int y = ly; y <= hy; y++) binBox[index(x, y)] = id;
+}
+
+void LGFenceGrid::appendCells(int x, int ly, int hy, vector<int>& out) const {
+    for (int y = ly; y <= hy; y++) {
+        int b = index(x, y);
+        if (binBox[b] == -1) {
+            out.insert(out.end(), cells.begin() + binStart[b], cells.begin() + binStart[b + 1]);
+        } else {
+            const Box& box = boxes[binBox[b]];
+            int l = (x - box.lx) * (box.hy - box.ly + 1) + y - box.ly;
+            out.insert(out.end(), box.cells.begin() + box.binStart[l], box.cells.begin() + box.binStart[l + 1]);
+        }
+    }
+}
+
+inline int cellLGBinIndex(int i) {
+    int x = max(0, min(LGNumX - 1, (int)((cellX[i] - coreLX) / LGBinW)));
+    int y = max(0, min(LGNumY - 1, (int)((cellY[i] - coreLY) / LGBinH)));
+    return x * LGNumY + y;
+}
+
 void updateLGGrid() {
     // clear information
     for (int r = 0; r < numFences; r++) {
-        for (int x = 0; x < LGNumX; x++) {
-            for (int y = 0; y < LGNumY; y++) {
-                LGGrid[r][x][y].cArea = 0;
-                LGGrid[r][x][y].cells.clear();
-            }
-        }
+        for (auto& bin : LGGrid[r].bins) bin.cArea = 0;
+        LGGrid[r].cells.clear();
     }
     // add cell to bins
+    LGCellBin.resize(numCells);
     for (int i = 0; i < numCells; i++) {
-        int r = cellFence[i];
-        int x = max(0, min(LGNumX - 1, (int)((cellX[i] - coreLX) / LGBinW)));
-        int y = max(0, min(LGNumY - 1, (int)((cellY[i] - coreLY) / LGBinH)));
-        LGGrid[r][x][y].cArea += cellW[i] * cellH[i];
-        LGGrid[r][x][y].cells.push_back(i);
+        auto& grid = LGGrid[cellFence[i]];
+        int b = cellLGBinIndex(i);
+        LGCellBin[i] = b;
+        grid.bins[b].cArea += cellW[i] * cellH[i];
+        grid.cells.push_back(i);
     }
+    for (int r = 0; r < numFences; r++) LGGrid[r].bucket(LGCellBin);
 }
 
-void updateLGGridFast(int lx, int ly, int hx, int hy, int r, const vector<int>& cells) {
-    // update cell area information inside the box (lx,ly,hx,hy)
+void updateLGGridFast(int lx, int ly, int hx, int hy, int r, int boxId, const vector<int>& cells) {
+    // update cell area information inside the box (lx,ly,hx,hy), and regroup its cells into box boxId
     // clear information
+    auto& grid = LGGrid[r];
     for (int x = lx; x <= hx; x++) {
         for (int y = ly; y <= hy; y++) {
-            LGGrid[r][x][y].cArea = 0;
-            LGGrid[r][x][y].cells.clear();
+            grid.bin(x, y).cArea = 0;
         }
     }
     // add cell to bins
     for (auto i : cells) {
         assert(r == cellFence[i]);
-        int x = max(0, min(LGNumX - 1, (int)((cellX[i] - coreLX) / LGBinW)));
-        int y = max(0, min(LGNumY - 1, (int)((cellY[i] - coreLY) / LGBinH)));
-        assert(x >= lx && x <= hx && y >= ly && y <= hy);
-        LGGrid[r][x][y].cArea += cellW[i] * cellH[i];
-        LGGrid[r][x][y].cells.push_back(i);
+        int b = cellLGBinIndex(i);
+        assert(b / LGNumY >= lx && b / LGNumY <= hx && b % LGNumY >= ly && b % LGNumY <= hy);
+        LGCellBin[i] = b;
+        grid.bins[b].cArea += cellW[i] * cellH[i];
     }
+    grid.bucketBox(boxId, lx, ly, hx, hy, cells, LGCellBin);
 }
 
 void initSpreadCells(int binSize) {
@@ -95,12 +145,11 @@ void initSpreadCells(int binSize) {
 
     // resize data structures
     LGGrid.clear();
-    OFMap.clear();
     OFBins.clear();
     LGTD.clear();
 
-    LGGrid.resize(numFences, vector<vector<LGBin> >(LGNumX, vector<LGBin>(LGNumY)));  // reinitialize bins
-    OFMap.resize(numFences, vector<vector<char> >(LGNumX, vector<char>(LGNumY, 0)));  // nothing to be handled
+    LGGrid.resize(numFences);
+    for (auto& grid : LGGrid) grid.init(LGNumX, LGNumY);  // reinitialize bins, nothing to be handled
     OFBins.resize(numFences);                          // no overfilled bin for each fence
     LGTD.resize(LGNumX, vector<double>(LGNumY, 1.0));  // target density = 1.0
 
@@ -115,10 +164,10 @@ void initSpreadCells(int binSize) {
                 double ly = coreLY + y * LGBinH;
                 double hx = lx + LGBinW;
                 double hy = ly + LGBinH;
-                LGGrid[r][x][y].lx = lx;
-                LGGrid[r][x][y].ly = ly;
-                LGGrid[r][x][y].hx = hx;
-                LGGrid[r][x][y].hy = hy;
+                LGGrid[r].bin(x, y).lx = lx;
+                LGGrid[r].bin(x, y).ly = ly;
+                LGGrid[r].bin(x, y).hx = hx;
+                LGGrid[r].bin(x, y).hy = hy;
                 // convert to unit of site map
                 int blx = x * (int)round(LGBinW / siteW);
                 int bhx = blx + (int)round(LGBinW / siteW) - 1;
@@ -128,11 +177,11 @@ void initSpreadCells(int binSize) {
                 bly = max(0, bly);
                 bhx = min((int)database.sitemap_nx - 1, bhx);
                 bhy = min((int)database.sitemap_ny - 1, bhy);
-                LGGrid[r][x][y].fArea = 0;
+                LGGrid[r].bin(x, y).fArea = 0;
                 for (int sx = blx; sx <= bhx; sx++) {
                     for (int sy = bly; sy <= bhy; sy++) {
-                        if (database.sites[sx][sy]->type->id == r) {
-                            LGGrid[r][x][y].fArea += siteArea;
+                        if (database.siteAt(sx, sy)->type->id == r) {
+                            LGGrid[r].bin(x, y).fArea += siteArea;
                         }
                     }
                 }
@@ -213,8 +262,8 @@ void updateBinUsableArea() {
         // calculate total usable area under the current target density
         for (int x = 0; x < LGNumX; x++) {
             for (int y = 0; y < LGNumY; y++) {
-                totalUArea[r] += LGGrid[r][x][y].fArea * LGTD[x][y];
-                totalFArea[r] += LGGrid[r][x][y].fArea;
+                totalUArea[r] += LGGrid[r].bin(x, y).fArea * LGTD[x][y];
+                totalFArea[r] += LGGrid[r].bin(x, y).fArea;
             }
         }
         if (totalFArea[r] < totalCArea[r]) {
@@ -230,10 +279,10 @@ void updateBinUsableArea() {
         // calculate usable area for each bin
         for (int x = 0; x < LGNumX; x++) {
             for (int y = 0; y < LGNumY; y++) {
-                if (LGTD[x][y] * scale > LGGrid[r][x][y].fArea) {
-                    LGGrid[r][x][y].uArea = LGGrid[r][x][y].fArea;
+                if (LGTD[x][y] * scale > LGGrid[r].bin(x, y).fArea) {
+                    LGGrid[r].bin(x, y).uArea = LGGrid[r].bin(x, y).fArea;
                 } else {
-                    LGGrid[r][x][y].uArea = LGGrid[r][x][y].fArea * LGTD[x][y] * scale;
+                    LGGrid[r].bin(x, y).uArea = LGGrid[r].bin(x, y).fArea * LGTD[x][y] * scale;
                 }
             }
         }
@@ -265,20 +314,20 @@ void findOverfillBins() {
         for (int x = 0; x < LGNumX; x++) {
             for (int y = 0; y < LGNumY; y++) {
                 // cell area overfill
-                if (LGGrid[r][x][y].cArea > LGGrid[r][x][y].uArea) {
+                if (LGGrid[r].bin(x, y).cArea > LGGrid[r].bin(x, y).uArea) {
                     OFBin ofb(r, x, y);
-                    ofb.ofArea = LGGrid[r][x][y].cArea - LGGrid[r][x][y].uArea;
-                    ofb.aofArea = LGGrid[r][x][y].cArea - LGGrid[r][x][y].fArea;
-                    ofb.exCArea = LGGrid[r][x][y].cArea;
-                    ofb.exFArea = LGGrid[r][x][y].fArea;
-                    ofb.exUArea = LGGrid[r][x][y].uArea;
-                    OFMap[r][x][y] = 1;
-                    if (LGGrid[r][x][y].uArea < siteArea) {
+                    ofb.ofArea = LGGrid[r].bin(x, y).cArea - LGGrid[r].bin(x, y).uArea;
+                    ofb.aofArea = LGGrid[r].bin(x, y).cArea - LGGrid[r].bin(x, y).fArea;
+                    ofb.exCArea = LGGrid[r].bin(x, y).cArea;
+                    ofb.exFArea = LGGrid[r].bin(x, y).fArea;
+                    ofb.exUArea = LGGrid[r].bin(x, y).uArea;
+                    LGGrid[r].ofMap[LGGrid[r].index(x, y)] = 1;
+                    if (LGGrid[r].bin(x, y).uArea < siteArea) {
                         ofb.ofRatio = ofb.ofArea;
                         ofb.aofRatio = ofb.aofArea;
                     } else {
-                        ofb.ofRatio = ofb.ofArea / LGGrid[r][x][y].uArea;
-                        ofb.aofRatio = ofb.aofArea / LGGrid[r][x][y].fArea;
+                        ofb.ofRatio = ofb.ofArea / LGGrid[r].bin(x, y).uArea;
+                        ofb.aofRatio = ofb.aofArea / LGGrid[r].bin(x, y).fArea;
                     }
                     OFBins[r].push_back(ofb);
                     totOF += ofb.ofArea;
@@ -288,7 +337,7 @@ void findOverfillBins() {
                     maxAOFR = max(ofb.aofRatio, maxAOFR);
                     nOF++;
                 } else {
-                    OFMap[r][x][y] = 0;
+                    LGGrid[r].ofMap[LGGrid[r].index(x, y)] = 0;
                 }
             }
         }
@@ -326,7 +375,7 @@ bool spreadCellsH(int r, const ExpandBox& box, ExpandBox& lobox, ExpandBox& hibo
     // calculate stripe free area
     for (int x = box.lx; x <= box.hx; x++) {
         for (int y = box.ly; y <= box.hy; y++) {
-            double area = LGGrid[r][x][y].uArea;
+            double area = LGGrid[r].bin(x, y).uArea;
             uArea[x - box.lx] += area;
             totalFArea += area;
         }
@@ -470,7 +519,7 @@ bool spreadCellsV(int r, ExpandBox box, ExpandBox& lobox, ExpandBox& hibox) {
     // calculate stripe free area
     for (int x = box.lx; x <= box.hx; x++) {
         for (int y = box.ly; y <= box.hy; y++) {
-            double area = LGGrid[r][x][y].uArea;
+            double area = LGGrid[r].bin(x, y).uArea;
             uArea[y - box.ly] += area;
             totalFArea += area;
         }
@@ -603,9 +652,9 @@ bool spreadCellsV(int r, ExpandBox box, ExpandBox& lobox, ExpandBox& hibox) {
 void expandLGRegion(OFBin& ofBin) {
     ofBin.lx = ofBin.hx = ofBin.x;
     ofBin.ly = ofBin.hy = ofBin.y;
-    ofBin.exFArea = LGGrid[ofBin.region][ofBin.x][ofBin.y].fArea;
-    ofBin.exUArea = LGGrid[ofBin.region][ofBin.x][ofBin.y].uArea;
-    ofBin.exCArea = LGGrid[ofBin.region][ofBin.x][ofBin.y].cArea;
+    ofBin.exFArea = LGGrid[ofBin.region].bin(ofBin.x, ofBin.y).fArea;
+    ofBin.exUArea = LGGrid[ofBin.region].bin(ofBin.x, ofBin.y).uArea;
+    ofBin.exCArea = LGGrid[ofBin.region].bin(ofBin.x, ofBin.y).cArea;
     char direction = 0;
     double boxW = 1.0;
     double boxH = 1.0;
@@ -642,36 +691,36 @@ void expandLGRegion(OFBin& ofBin) {
             ofBin.lx--;
             boxW += 1.0;
             for (int y = ofBin.ly; y <= ofBin.hy; y++) {
-                ofBin.exFArea += LGGrid[ofBin.region][ofBin.lx][y].fArea;
-                ofBin.exUArea += LGGrid[ofBin.region][ofBin.lx][y].uArea;
-                ofBin.exCArea += LGGrid[ofBin.region][ofBin.lx][y].cArea;
+                ofBin.exFArea += LGGrid[ofBin.region].bin(ofBin.lx, y).fArea;
+                ofBin.exUArea += LGGrid[ofBin.region].bin(ofBin.lx, y).uArea;
+                ofBin.exCArea += LGGrid[ofBin.region].bin(ofBin.lx, y).cArea;
             }
         } else if (direction == 1 && ofBin.ly > 0 && (disableBoxRatio || dirYCost <= dirXCost)) {
             // expand to bottom
             ofBin.ly--;
             boxH += 1.0;
             for (int x = ofBin.lx; x <= ofBin.hx; x++) {
-                ofBin.exFArea += LGGrid[ofBin.region][x][ofBin.ly].fArea;
-                ofBin.exUArea += LGGrid[ofBin.region][x][ofBin.ly].uArea;
-                ofBin.exCArea += LGGrid[ofBin.region][x][ofBin.ly].cArea;
+                ofBin.exFArea += LGGrid[ofBin.region].bin(x, ofBin.ly).fArea;
+                ofBin.exUArea += LGGrid[ofBin.region].bin(x, ofBin.ly).uArea;
+                ofBin.exCArea += LGGrid[ofBin.region].bin(x, ofBin.ly).cArea;
             }
         } else if (direction == 2 && ofBin.hx < LGNumX - 1 && (disableBoxRatio || dirXCost <= dirYCost)) {
             // expand to right
             ofBin.hx++;
             boxW += 1.0;
             for (int y = ofBin.ly; y <= ofBin.hy; y++) {
-                ofBin.exFArea += LGGrid[ofBin.region][ofBin.hx][y].fArea;
-                ofBin.exUArea += LGGrid[ofBin.region][ofBin.hx][y].uArea;
-                ofBin.exCArea += LGGrid[ofBin.region][ofBin.hx][y].cArea;
+                ofBin.exFArea += LGGrid[ofBin.region].bin(ofBin.hx, y).fArea;
+                ofBin.exUArea += LGGrid[ofBin.region].bin(ofBin.hx, y).uArea;
+                ofBin.exCArea += LGGrid[ofBin.region].bin(ofBin.hx, y).cArea;
             }
         } else if (direction == 3 && ofBin.hy < LGNumY - 1 && (disableBoxRatio || dirYCost <= dirXCost)) {
             // expand to top
             ofBin.hy++;
             boxH += 1.0;
             for (int x = ofBin.lx; x <= ofBin.hx; x++) {
-                ofBin.exFArea += LGGrid[ofBin.region][x][ofBin.hy].fArea;
-                ofBin.exUArea += LGGrid[ofBin.region][x][ofBin.hy].uArea;
-                ofBin.exCArea += LGGrid[ofBin.region][x][ofBin.hy].cArea;
+                ofBin.exFArea += LGGrid[ofBin.region].bin(x, ofBin.hy).fArea;
+                ofBin.exUArea += LGGrid[ofBin.region].bin(x, ofBin.hy).uArea;
+                ofBin.exCArea += LGGrid[ofBin.region].bin(x, ofBin.hy).cArea;
             }
         }
         bool fullyExpandedX = (ofBin.lx == 0 && ofBin.hx == LGNumX - 1);
@@ -699,22 +748,13 @@ void expandLGRegion(OFBin& ofBin) {
     }
 }
 
-void spreadCellsForABin(OFBin& maxBin, int r)  // r is the fence id
-{
-    if (OFMap[r][maxBin.x][maxBin.y] == 0) return;  // overfill have been resolved
-
-    // find expand region
-    expandLGRegion(maxBin);
-    ExpandBox box(maxBin.lx, maxBin.ly, maxBin.hx, maxBin.hy, maxLevel);
+// spread cells in the expanded region of ofBin, only touches the bins and cells inside the region
+void spreadCellsInRegion(const OFBin& ofBin, int boxId) {
+    int r = ofBin.region;
+    ExpandBox box(ofBin.lx, ofBin.ly, ofBin.hx, ofBin.hy, maxLevel);
 
     // get list of cells in expanded region
-    for (int x = maxBin.lx; x <= maxBin.hx; x++) {
-        for (int y = maxBin.ly; y <= maxBin.hy; y++) {
-            OFMap[r][x][y] = 0;
-            auto& lcells = LGGrid[r][x][y].cells;
-            box.cells.insert(box.cells.end(), lcells.begin(), lcells.end());  // better to "reserve"
-        }
-    }
+    for (int x = ofBin.lx; x <= ofBin.hx; x++) LGGrid[r].appendCells(x, ofBin.ly, ofBin.hy, box.cells);
     auto cellsCopy = box.cells;
     queue<ExpandBox> boxes;
     boxes.push(move(box));
@@ -760,7 +800,51 @@ void spreadCellsForABin(OFBin& maxBin, int r)  // r is the fence id
             if (hibox.cells.size() > 0 && hibox.level > 0) boxes.push(move(hibox));
         }
     }
-    updateLGGridFast(box.lx, box.ly, box.hx, box.hy, r, cellsCopy);
+    updateLGGridFast(box.lx, box.ly, box.hx, box.hy, r, boxId, cellsCopy);
+}
+
+// Pick the next batch of overfilled bins, in the order of OFBins, whose expanded regions do not
+// overlap the region of any earlier pending bin of the same fence. Regions of different fences
+// never conflict. The bins in a batch can be spread independently.
+// A region is expanded again only if a bin of it has been spread since its last expansion (binSpread, the schedule
+// of the last spreading of each bin).
+bool scheduleOverfillBins(vector<OFBin>& batch, vector<vector<int>>& boxMark, const vector<vector<int>>& binSpread,
+                          int& stamp) {
+    batch.clear();
+    ++stamp;
+    for (int r = 0; r < numFences; r++) {
+        auto& grid = LGGrid[r];
+        auto& mark = boxMark[r];
+        auto& spread = binSpread[r];
+        int nPending = 0;
+        for (auto& ofBin : OFBins[r]) {
+            if (grid.ofMap[grid.index(ofBin.x, ofBin.y)] == 0) continue;  // overfill have been resolved
+            bool stale = (ofBin.expandedAt < 0);
+            for (int x = ofBin.lx; x <= ofBin.hx && !stale; x++)
+                for (int y = ofBin.ly; y <= ofBin.hy && !stale; y++)
+                    stale = (spread[grid.index(x, y)] >= ofBin.expandedAt);
+            if (stale) {
+                expandLGRegion(ofBin);
+                ofBin.expandedAt = stamp;
+            }
+            bool conflict = false;
+            for (int x = ofBin.lx; x <= ofBin.hx; x++) {
+                for (int y = ofBin.ly; y <= ofBin.hy; y++) {
+                    if (mark[grid.index(x, y)] == stamp) conflict = true;
+                    mark[grid.index(x, y)] = stamp;
+                }
+            }
+            if (conflict) {
+                OFBins[r][nPending++] = ofBin;
+                continue;
+            }
+            for (int x = ofBin.lx; x <= ofBin.hx; x++)
+                for (int y = ofBin.ly; y <= ofBin.hy; y++) grid.ofMap[grid.index(x, y)] = 0;
+            batch.push_back(ofBin);
+        }
+        OFBins[r].resize(nPending);
+    }
+    return !batch.empty();
 }
 
 void spreadCells(int binSize, int times) {
@@ -771,9 +855,17 @@ void spreadCells(int binSize, int times) {
     updateTargetDensity();
     updateBinUsableArea();
 
+    vector<OFBin> batch;
+    vector<vector<int>> boxMark(numFences, vector<int>(LGNumX * LGNumY, 0));  // indexed as LGFenceGrid::bins
+    vector<vector<int>> binSpread(numFences, vector<int>(LGNumX * LGNumY, 0));
+    vector<int> boxIds;
+    int stamp = 0;
+    int nBatches = 0, nSpread = 0;
+
     for (int iter = 0; iter < times; iter++) {  // start an iteration
         updateLGGrid();
         findOverfillBins();
+        if (nOF == 0) break;
         // if(nOF>0){
         //     avgOF=totOF/nOF;
         //     printlog(LOG_INFO, "\tRoughLegalize #%d OF: avg=%lf max=%lf #=%d", iter, avgOF, maxOF, nOF);
@@ -784,16 +876,44 @@ void spreadCells(int binSize, int times) {
         copy(cellX.begin(), cellX.begin() + numCells, _cellX.begin());
         copy(cellY.begin(), cellY.begin() + numCells, _cellY.begin());
 
-        for (int r = 0; r < numFences; r++) {  // start a fence
-            if (OFBins[r].size() == 0) continue;
-            OFBins[r].sort();
+        for (int r = 0; r < numFences; r++) stable_sort(OFBins[r].begin(), OFBins[r].end());
 
-            // legalize all overfilled bins
-            while (OFBins[r].size() > 0) {
-                spreadCellsForABin(OFBins[r].front(), r);
-                OFBins[r].pop_front();
+        // legalize all overfilled bins, batch by batch
+        while (scheduleOverfillBins(batch, boxMark, binSpread, stamp)) {
+            boxIds.resize(batch.size());
+            for (unsigned i = 0; i < batch.size(); i++) {
+                auto& boxes = LGGrid[batch[i].region].boxes;
+                boxIds[i] = boxes.size();
+                boxes.emplace_back();
+            }
+            int bIdx = 0;
+            std::mutex idx_mutex;
+            auto thread_func = [&]() {
+                int idx;
+                while (true) {
+                    idx_mutex.lock();
+                    idx = bIdx++;
+                    idx_mutex.unlock();
+                    if (idx >= (int)batch.size()) break;
+                    spreadCellsInRegion(batch[idx], boxIds[idx]);
+                }
+            };
+            int nThreads = min(gpSetting.nThreads, (int)batch.size());
+            if (nThreads <= 1) {
+                thread_func();
+            } else {
+                std::thread threads[nThreads];
+                for (int i = 0; i < nThreads; i++) threads[i] = std::thread(thread_func);
+                for (int i = 0; i < nThreads; i++) threads[i].join();
             }
-        }  // finish a fence
+            for (auto& ofBin : batch) {
+                auto& grid = LGGrid[ofBin.region];
+                for (int x = ofBin.lx; x <= ofBin.hx; x++)
+                    for (int y = ofBin.ly; y <= ofBin.hy; y++) binSpread[ofBin.region][grid.index(x, y)] = stamp;
+            }
+            nBatches++;
+            nSpread += batch.size();
+        }
 
         double dispx = 0.0;
         double dispy = 0.0;
@@ -802,14 +922,15 @@ void spreadCells(int binSize, int times) {
             dispy += std::abs(cellY[i] - _cellY[i]);
         }
         printlog(LOG_VERBOSE, "disp = %d + %d = %d", (int)dispx, (int)dispy, (int)(dispx + dispy));
-        if ((int)(dispx + dispy) == 0) break;
+        if ((int)(dispx + dispy) == 0 || dispx + dispy < gpSetting.ubStopDisp * numCells) break;
     }  // finish an iteration
+    printlog(LOG_VERBOSE, "spread %d bins in %d batches", nSpread, nBatches);
 
     // updateLGGrid(0, 0, LGNumX-1, LGNumY-1);
     // for(int r=0; r<numFences; r++){
     //     for(int x=0; x<LGNumX; x++){
     //         for(int y=0; y<LGNumY; y++){
-    //             LGBin &bin=LGGrid[r][x][y];
+    //             LGBin &bin=LGGrid[r].bin(x, y);
     //             ExpandBox box(x, y, x, y, 0, bin.cells);
     //             spreadCellsInBoxEven(r, box);
     //             spreadCellsInBoxOverlapFree(r, box);
@@ -817,4 +938,14 @@ void spreadCells(int binSize, int times) {
     //         }
     //     }
     // }
+}
+
+// total overfill over total cell area of the current placement, on the grid of the last spreading
+double overfillRatio(double *maxRatio) {
+    updateLGGrid();
+    findOverfillBins();
+    double cArea = 0.0;
+    for (int r = 0; r < numFences; r++) cArea += totalCArea[r];
+    if (maxRatio) *maxRatio = maxOFR;
+    return (cArea > 0) ? totOF / cArea : 0.0;
 }
\ No newline at end of file
@@ -4,7 +4,6 @@
 class LGBin {
 public:
     double lx, ly, hx, hy;
-    vector<int> cells;
     double uArea;  // usable area
     double fArea;  // free area
     double cArea;  // cell area
@@ -21,6 +20,46 @@ public:
     }
 };
 
+// Legalization bins of a fence, bin (x, y) is bins[x * numY + y].
+// Cells are bucketed by a stable counting sort on their bin index,
+// the cells of bin b are cells[binStart[b]] .. cells[binStart[b + 1] - 1].
+// A box spread during a pass buckets its own cells, which replace those of its bins until the next full bucket.
+class LGFenceGrid {
+public:
+    class Box {
+    public:
+        int lx, ly, hx, hy;
+        vector<int> binStart;  // over the bins of the box, (x - lx) * (hy - ly + 1) + (y - ly)
+        vector<int> cells;
+    };
+
+    int numY;
+    vector<LGBin> bins;
+    vector<int> binStart;  // prefix offsets, size #bins + 1
+    vector<int> cells;     // cells of the fence, grouped by bin
+    vector<char> ofMap;    // mark if a bin is handled
+    vector<int> binBox;    // box holding the cells of a bin, -1 for cells
+    vector<Box> boxes;
+
+    void init(int nx, int ny) {
+        numY = ny;
+        bins.assign(nx * ny, LGBin());
+        binStart.assign(nx * ny + 1, 0);
+        cells.clear();
+        ofMap.assign(nx * ny, 0);
+        binBox.assign(nx * ny, -1);
+        boxes.clear();
+    }
+    inline int index(int x, int y) const { return x * numY + y; }
+    inline LGBin &bin(int x, int y) { return bins[x * numY + y]; }
+    // append the cells of bins (x, ly) .. (x, hy) to out
+    void appendCells(int x, int ly, int hy, vector<int> &out) const;
+    // regroup cells by their bin index in binOf, keeping the current order inside a bin, and drop the boxes
+    void bucket(const vector<int> &binOf);
+    // regroup the cells of a box into boxes[id], which the caller has added, only the bins of the box are touched
+    void bucketBox(int id, int lx, int ly, int hx, int hy, const vector<int> &boxCells, const vector<int> &binOf);
+};
+
 class OFBin {
 public:
     int x, y;  // overfill center
@@ -34,6 +73,7 @@ public:
     double exCArea;
     double exUArea;
     double exFArea;
+    int expandedAt;  // schedule of the last expansion, -1 if none
     OFBin(int _r, int _x, int _y) {
         lx = hx = x = _x;
         ly = hy = y = _y;
@@ -45,6 +85,7 @@ public:
         exCArea = 0.0;
         exFArea = 0.0;
         exUArea = 0.0;
+        expandedAt = -1;
     }
     OFBin() {
         lx = hx = x = -1;
@@ -57,11 +98,16 @@ public:
         exCArea = 0.0;
         exFArea = 0.0;
         exUArea = 0.0;
+        expandedAt = -1;
     }
 
     bool operator<(const OFBin &b) const { return ofRatio > b.ofRatio; }
 };
 
+void initSpreadCells(int binSize);
+void updateTargetDensity();
+void updateBinUsableArea();
 void spreadCells(int binSize, int times);
+double overfillRatio(double *maxRatio = NULL);
 
 #endif
@@ -0,0 +1,355 @@
+#include "larf.h"
+#include "db/db.h"
+#include "gp/gp.h"
+#include "tdm/tdm_db.h"
+#include "tdm/tdm_net.h"
+#include "tdm/tdm_part.h"
+#include "tdm/tdm_solve_lp.h"
+#include "tdm/tdm_solve_lag.h"
+#include "tdm/tdm_leg.h"
+#include "tdm/tdm_refine_lp.h"
+#include "tdm/tdm_refine_greedy.h"
+#include "tdm/timing_graph.h"
+
+// The engine works on the globals of larf (setting, db::database, tdmDatabase and gpSetting), which the library
+// defines or owns instead of main.cpp. A call fills them from its design and options and empties them at the end.
+
+Setting setting;
+
+namespace {
+
+mutex engineMutex;
+
+// serializes the calls and resets the globals before and after one
+class EngineScope {
+public:
+    EngineScope() : _lock(engineMutex) {
+        reset();
+        init_log(LOG_NORMAL);
+    }
+    ~EngineScope() { reset(); }
+
+private:
+    lock_guard<mutex> _lock;
+
+    static void reset() {
+        tdmDatabase.clear();
+        clearTdmNets();
+        db::database.~Database();
+        new (&db::database) db::Database();
+        setting = Setting();
+        prof::reset();
+    }
+};
+
+const vector<larf::Resource> ispdResources = {
+    {"LUT", {"LUT1", "LUT2", "LUT3", "LUT4", "LUT5", "LUT6"}},
+    {"FF", {"FDRE"}},
+    {"CARRY8", {"CARRY8"}},
+    {"DSP48E2", {"DSP48E2"}},
+    {"RAMB36E2", {"RAMB36E2"}},
+    {"IO", {"IBUF", "OBUF", "BUFGCE"}},
+};
+
+const vector<larf::SiteType> ispdSiteTypes = {
+    {"SLICE", {{"LUT", 16}, {"FF", 16}, {"CARRY8", 1}}},
+    {"DSP", {{"DSP48E2", 1}}},
+    {"BRAM", {{"RAMB36E2", 1}}},
+    {"IO", {{"IO", 64}}},
+};
+
+db::Resource *getResource(const string &str) {
+    db::Resource::Name name;
+    if (!db::Resource::NameString2Enum(str, name)) return NULL;
+    db::Resource *resource = db::database.getResource(name);
+    return resource ? resource : db::database.addResource(db::Resource(name));
+}
+
+// as readDesign of the bookshelf files: the library, the nodes, the scl, the pl (if sites), the nets, then setup
+bool buildDesign(const larf::Design &design, bool needSites) {
+    const char pinTypes[] = {'i', 'o', 'c', 'e'};  // by PinDir
+    for (auto &master : design.masters) {
+        db::Master::Name name;
+        if (!db::Master::NameString2Enum(master.name, name)) return false;
+        if (db::database.getMaster(name) != NULL) {
+            printlog(LOG_ERROR, "Duplicated master: %s", master.name.c_str());
+            return false;
+        }
+        db::Master newmaster(name);
+        for (auto &pin : master.pins) {
+            db::PinType pintype(pin.name, pinTypes[(int)pin.dir]);
+            newmaster.addPin(pintype);
+        }
+        db::database.addMaster(newmaster);
+    }
+
+    for (auto &instance : design.instances) {
+        db::Master::Name name;
+        if (!db::Master::NameString2Enum(instance.master, name)) return false;
+        db::Master *master = db::database.getMaster(name);
+        if (master == NULL) {
+            printlog(LOG_ERROR, "Master not found: %s", instance.master.c_str());
+            return false;
+        }
+        if (db::database.getInstance(instance.name) != NULL) {
+            printlog(LOG_ERROR, "Instance duplicated: %s", instance.name.c_str());
+            return false;
+        }
+        db::database.addInstance(db::Instance(instance.name.c_str(), master));
+    }
+
+    const larf::Arch &arch = design.arch;
+    for (auto &siteType : arch.siteTypes.empty() ? ispdSiteTypes : arch.siteTypes) {
+        db::SiteType::Name name;
+        if (!db::SiteType::NameString2Enum(siteType.name, name)) return false;
+        if (db::database.getSiteType(name) != NULL) {
+            printlog(LOG_ERROR, "Duplicated site type: %s", siteType.name.c_str());
+            return false;
+        }
+        db::SiteType *sitetype = db::database.addSiteType(db::SiteType(name));
+        for (auto &pair : siteType.resources) {
+            db::Resource *resource = getResource(pair.first);
+            if (resource == NULL) return false;
+            sitetype->addResource(resource, pair.second);
+        }
+    }
+    // the masters not in the library have no instance
+    for (auto &res : arch.resources.empty() ? ispdResources : arch.resources) {
+        db::Resource *resource = getResource(res.name);
+        if (resource == NULL) return false;
+        for (auto &str : res.masters) {
+            db::Master::Name name;
+            if (!db::Master::NameString2Enum(str, name)) return false;
+            db::Master *master = db::database.getMaster(name);
+            if (master != NULL) resource->addMaster(master);
+        }
+    }
+    for (auto master : db::database.masters) {
+        if (master->resource == NULL) {
+            printlog(LOG_ERROR, "Master without resource: %s", db::Master::NameEnum2String(master->name).c_str());
+            return false;
+        }
+    }
+
+    if (arch.sites.empty() && needSites) {
+        printlog(LOG_ERROR, "The architecture has no site");
+        return false;
+    } else if (!arch.sites.empty()) {
+        if (arch.nx < 2 || arch.ny < 1) {
+            printlog(LOG_ERROR, "Invalid site map: %d x %d", arch.nx, arch.ny);
+            return false;
+        }
+        db::database.setSiteMap(arch.nx, arch.ny);
+        db::database.setSwitchBoxes(arch.nx / 2 - 1, arch.ny);
+        for (auto &site : arch.sites) {
+            db::SiteType::Name name;
+            if (!db::SiteType::NameString2Enum(site.type, name)) return false;
+            db::SiteType *sitetype = db::database.getSiteType(name);
+            if (sitetype == NULL) {
+                printlog(LOG_ERROR, "Site type not found: %s", site.type.c_str());
+                return false;
+            }
+            if (db::database.addSite(site.x, site.y, sitetype) == NULL) return false;
+        }
+        for (unsigned i = 0; i < design.instances.size(); i++) {
+            const larf::Instance &instance = design.instances[i];
+            if (!instance.fixed) continue;
+            db::Instance *dbInstance = db::database.instances[i];
+            dbInstance->inputFixed = dbInstance->fixed = true;
+            int x = instance.x, y = instance.y, slot = instance.slot;
+            if (dbInstance->IsFF())
+                slot += 16;
+            else if (dbInstance->IsCARRY())
+                slot += 32;
+            if (!db::database.place(dbInstance, x, y, slot)) {
+                printlog(LOG_ERROR, "Cannot place %s at (%d,%d)", instance.name.c_str(), x, y);
+                return false;
+            }
+        }
+    }
+
+    for (auto &net : design.nets) {
+        if (db::database.getNet(net.name) != NULL) {
+            printlog(LOG_ERROR, "Net duplicated: %s", net.name.c_str());
+            return false;
+        }
+        db::Net *dbNet = db::database.addNet(db::Net(net.name.c_str()));
+        for (auto &ref : net.pins) {
+            db::Pin *pin = NULL;
+            if ((unsigned)ref.instance < db::database.instances.size())
+                pin = db::database.instances[ref.instance]->getPin(ref.pin);
+            if (pin == NULL) {
+                printlog(LOG_ERROR, "Pin not found: %s of instance %d", ref.pin.c_str(), ref.instance);
+                return false;
+            }
+            dbNet->addPin(pin);
+            if (pin->type->type == 'o' && pin->instance->master->name == db::Master::BUFGCE) dbNet->isClk = true;
+        }
+    }
+
+    db::database.setup();
+    db::database.print();
+    return true;
+}
+
+}  // namespace
+
+namespace larf {
+
+bool partition(const Design &design, const PartitionOptions &options, vector<int> &devices) {
+    EngineScope engine;
+    setting.nThreads = options.nThreads;
+    setting.nPartition = options.nDevices;
+    setting.partSeeds = options.seeds;
+    setting.partTimingIter = options.timingRounds;
+    setting.partFork = false;  // a fork of the host is unsafe if it has other threads
+    if (options.nDevices < 1) {
+        printlog(LOG_ERROR, "Invalid number of devices: %d", options.nDevices);
+        return false;
+    }
+    if (!buildDesign(design, false)) return false;
+
+    vector<vector<int>> clusters;
+    {
+        PROF_SCOPE("partition");
+        if (!::partition(clusters, options.nDevices)) return false;
+    }
+    devices.assign(design.instances.size(), -1);
+    for (unsigned i = 0; i < clusters.size(); i++) {
+        for (auto instId : clusters[i]) devices[instId] = i;
+    }
+    return true;
+}
+
+bool place(const Design &design, const PlaceOptions &options, vector<pair<double, double>> &positions) {
+    EngineScope engine;
+    setting.gpThreads = options.nThreads;
+    setting.precond = (Setting::PrecondMethod)options.precond;
+    setting.ub = (Setting::UBMethod)options.spreading;
+    if (!buildDesign(design, true)) return false;
+    gpSetting.init();
+
+    PROF_SCOPE("tdm_place");
+    vector<db::Group> groups(db::database.instances.size());
+    for (unsigned int i = 0; i < groups.size(); i++) {
+        groups[i].instances.push_back(db::database.instances[i]);
+        groups[i].id = i;
+    }
+
+    gpSetting.set2();
+    gplace(groups);
+    gpSetting.set3();
+    gplace(groups);
+
+    positions.resize(groups.size());
+    for (unsigned int i = 0; i < groups.size(); i++) positions[i] = {groups[i].x, groups[i].y};
+    return true;
+}
+
+bool optimizeTdm(const Design &design, const TdmOptions &options, TdmResult &result) {
+    const Setting::ContMethod contMethods[] = {Setting::Tdm_Lag, Setting::Tdm_LP, Setting::Tdm_ILP};
+    const Setting::LgMethod lgMethods[] = {Setting::Lg_MaxDisp, Setting::Lg_Disp, Setting::Lg_None};
+
+    EngineScope engine;
+    setting.nThreads = options.nThreads;
+    setting.nPartition = options.nDevices;
+    setting.cont = contMethods[(int)options.cont];
+    setting.lg = lgMethods[(int)options.lg];
+    setting.doRefine = options.refine;
+    setting.presolve = options.presolve;
+    setting.lagIter = options.lagIter;
+    setting.lagUpdate = (Setting::LagUpdate)options.lagUpdate;
+    setting.precision = options.singlePrecision ? Setting::Precision_Float : Setting::Precision_Double;
+
+    vector<int> devices(design.instances.size());
+    for (unsigned i = 0; i < devices.size(); i++) {
+        devices[i] = design.instances[i].device;
+        if (devices[i] < 0 || devices[i] >= options.nDevices) {
+            printlog(LOG_ERROR, "Invalid device of %s: %d", design.instances[i].name.c_str(), devices[i]);
+            return false;
+        }
+    }
+    if (design.arch.sites.empty()) {
+        printlog(LOG_WARN, "The architecture has no site, every LUT to FF connection is taken as within a site");
+    }
+    if (!buildDesign(design, false)) return false;
+
+    PROF_SCOPE("tdm_time");
+    vector<db::Group> groups(db::database.instances.size());
+    for (unsigned int i = 0; i < groups.size(); i++) {
+        groups[i].instances.push_back(db::database.instances[i]);
+        groups[i].id = i;
+        groups[i].x = design.instances[i].x;
+        groups[i].y = design.instances[i].y;
+    }
+
+    {
+        PROF_SCOPE("TdmDB::init");
+        vector<array<int, 3>> board;
+        set<pair<int, int>> pairs;
+        for (auto &connection : options.board) {
+            int device1 = connection.device1, device2 = connection.device2;
+            if (device1 < 0 || device2 < 0 || device1 >= options.nDevices || device2 >= options.nDevices ||
+                device1 == device2 || connection.wires < 0) {
+                printlog(LOG_ERROR, "Invalid connection %d-%d of the board", device1, device2);
+                return false;
+            }
+            if (!pairs.emplace(min(device1, device2), max(device1, device2)).second) {
+                printlog(LOG_ERROR, "Duplicate connection %d-%d of the board", device1, device2);
+                return false;
+            }
+            board.push_back({{device1, device2, connection.wires}});
+        }
+        tdmDatabase.setBoard(board, options.wires);
+        if (!tdmDatabase.init(options.nDevices, &groups, devices)) return false;
+        if (options.maxRatio != tdmDatabase.getMaxChoice()) tdmDatabase.setMaxChoice(options.maxRatio);
+    }
+    if (setting.presolve) {
+        PROF_SCOPE("presolve");
+        tdmDatabase.presolve();
+    }
+
+    if (setting.cont == Setting::Tdm_LP || setting.cont == Setting::Tdm_ILP) {
+        PROF_SCOPE("solveLP");
+        TdmLpSolver tdmLpSolver(setting.cont == Setting::Tdm_LP);
+        tdmLpSolver.solve();
+    } else {
+        PROF_SCOPE("solveLag");
+        solveLag("", "");
+    }
+
+    if (setting.doRefine) {
+        PROF_SCOPE("refineLP");
+        TdmRefineLP contRefiner(true);
+        contRefiner.solve();
+    }
+
+    if (setting.lg != Setting::Lg_None) {
+        PROF_SCOPE("legalize");
+        TdmLegalize legalizer;
+        legalizer.solve();
+    }
+
+    {
+        PROF_SCOPE("refineGreedy");
+        TdmRefine greedyRefiner;
+        greedyRefiner.solve();
+    }
+
+    tdmDatabase.reportSol();
+    if (setting.presolve) tdmDatabase.checkPresolve();
+
+    TimingGraph *timingGraph = tdmDatabase.getTimingGraph();
+    result.period = tdmDatabase.getArrivalTime();
+    result.arrival.resize(groups.size());
+    for (unsigned int i = 0; i < groups.size(); i++) result.arrival[i] = timingGraph->getNode(i)->getArrivalTime();
+    result.ratios.clear();
+    for (auto xdrVar : tdmDatabase.getXdrVars()) {
+        TdmNet *net = xdrVar->getNet();
+        result.ratios.push_back({net->getParentNet()->id, net->getFromDevice(), net->getToDevice(), xdrVar->getVal()});
+    }
+    result.limitVio = tdmDatabase.getLimitVio();
+    return true;
+}
+
+}  // namespace larf
@@ -0,0 +1,140 @@
+#pragma once
+
+// Embeddable API of larf (liblarf.a / liblarf.so, see "make lib"): a design is given by arrays, a flow runs with the
+// options of its call, and the results are returned, so no file is read or written and no global is exposed.
+// Only the standard library is included here, the engine stays behind the functions. It keeps one design at a time,
+// so the calls of all threads are serialized, and a call starts from and leaves the engine empty. The calling process
+// is never forked (the seeds of a partition run one after another, unlike the child processes of larf -partSeeds).
+// The log of the engine goes to stdout as the one of larf.
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace larf {
+
+enum class PinDir { Input, Output, Clock, Ctrl };
+
+struct MasterPin {
+    std::string name;
+    PinDir dir;
+};
+
+// a cell of the library by its name of the ISPD 2016 architecture: LUT1..LUT6, FDRE, CARRY8, DSP48E2, RAMB36E2, IBUF,
+// OBUF or BUFGCE
+struct Master {
+    std::string name;
+    std::vector<MasterPin> pins;
+};
+
+struct Instance {
+    std::string name;
+    std::string master;
+    int device = 0;       // of optimizeTdm
+    double x = 0, y = 0;  // of optimizeTdm, the position in its device; the site of a fixed instance
+    int slot = 0;         // in the site of a fixed instance
+    bool fixed = false;   // e.g., IOs
+};
+
+struct PinRef {
+    int instance;     // in Design::instances
+    std::string pin;  // of the master of the instance
+};
+
+struct Net {
+    std::string name;
+    std::vector<PinRef> pins;
+};
+
+// architecture: resources and site types are of the ISPD 2016 architecture if empty (e.g., LUT: LUT1..LUT6, SLICE:
+// LUT 16, FF 16, CARRY8 1), the names are of its resources (LUT, FF, CARRY8, DSP48E2, RAMB36E2, IO) and site types
+// (SLICE, DSP, BRAM, IO); clock regions are not modeled
+struct Resource {
+    std::string name;
+    std::vector<std::string> masters;
+};
+
+struct SiteType {
+    std::string name;
+    std::vector<std::pair<std::string, int>> resources;  // and their slots
+};
+
+struct Site {
+    int x, y;
+    std::string type;
+};
+
+struct Arch {
+    std::vector<Resource> resources;
+    std::vector<SiteType> siteTypes;
+    int nx = 0, ny = 0;
+    std::vector<Site> sites;  // a site spans the empty cells above it, as a SITEMAP of a .scl file
+};
+
+struct Design {
+    std::vector<Master> masters;
+    std::vector<Instance> instances;
+    std::vector<Net> nets;
+    // the sites are needed by place, and by optimizeTdm for the wire delays (none from a LUT to a FF of its site)
+    Arch arch;
+};
+
+enum class Precond { Jacobi, IC, AMG };
+enum class Spreading { Spread, Electro };
+enum class ContMethod { Lag, LP, ILP };
+enum class Legalizer { MaxDisp, Disp, None };
+enum class LagUpdate { Geometric, Polyak, Momentum, Nesterov, Bundle };
+
+struct PartitionOptions {
+    int nDevices = 4;
+    int seeds = 1;         // independent partitions, the best cut is kept; they run one after another
+    int timingRounds = 0;  // of timing-driven net costs, 0 for unit costs
+    int nThreads = 8;
+};
+
+struct PlaceOptions {
+    Precond precond = Precond::Jacobi;
+    Spreading spreading = Spreading::Spread;
+    int nThreads = 2;  // as -gpThread
+};
+
+struct Connection {
+    int device1, device2;
+    int wires;
+};
+
+struct TdmOptions {
+    int nDevices = 4;
+    int wires = 20;                 // between the devices of a pair not in board, -1 if they are not connected
+    std::vector<Connection> board;  // wires of specific pairs of devices
+    int maxRatio = 1600;
+    ContMethod cont = ContMethod::Lag;
+    Legalizer lg = Legalizer::MaxDisp;
+    bool refine = false;
+    bool presolve = false;  // fix the vars far from critical before the optimization
+    int lagIter = 1000;
+    LagUpdate lagUpdate = LagUpdate::Geometric;
+    bool singlePrecision = false;  // of the Lagrangian iterations
+    int nThreads = 8;
+};
+
+// ratio of the TDM wires of a net from one device to another
+struct XdrRatio {
+    int net;  // in Design::nets
+    int fromDevice, toDevice;
+    double ratio;  // 1 or a multiple of 8 unless the legalizer is None
+};
+
+struct TdmResult {
+    double period = 0;            // arrival time of the design
+    std::vector<double> arrival;  // by instance, at its inputs
+    std::vector<XdrRatio> ratios;
+    int limitVio = 0;  // wires over the limits of the pairs of devices
+};
+
+// false (with the errors in the log) if the design is invalid or the flow fails
+bool partition(const Design &design, const PartitionOptions &options, std::vector<int> &devices);
+bool place(const Design &design, const PlaceOptions &options, std::vector<std::pair<double, double>> &positions);
+bool optimizeTdm(const Design &design, const TdmOptions &options, TdmResult &result);
+
+}  // namespace larf
@@ -8,10 +8,13 @@ using namespace db;
 #include "tdm/tdm_leg.h"
 #include "tdm/tdm_refine_lp.h"
 #include "tdm/tdm_refine_greedy.h"
+#include "tdm/tdm_sweep.h"
+#include "serve/serve.h"
 
 Setting setting;
 
-bool get_args(int argc, char **argv);
+vector<Group> tdmGroups;  // of tdm_time, referred by tdmDatabase
+bool tdmReady = false;
 
 int main(int argc, char **argv) {
     init_log(LOG_NORMAL);
@@ -22,21 +25,78 @@ int main(int argc, char **argv) {
     log() << "---------------------------------------------------------------------" << endl;
 
     if (!get_args(argc, argv)) return 1;
-    database.readAux(setting.io_aux);
-    database.readLib(setting.io_lib);
-    database.readNodes(setting.io_nodes);
-    database.readScl(setting.io_scl);
-    database.readPl(setting.io_pl);
-    database.readNets(setting.io_nets);
+    if (setting.io_serve != "") return serve(setting.io_serve);
 
-    database.setup();
-    database.print();
+    // the report is also of a failed run
+    int ret = readDesign() ? runFlow() : 1;
+    if (setting.io_report != "") prof::writeReport(setting.io_report);
+    if (ret != 0) return ret;
 
-    gpSetting.init();
+    log() << "-----------------------------------" << endl;
+    log() << "           terminating...          " << endl;
+    log() << "-----------------------------------" << endl;
+    return 0;
+}
 
+bool readDesign() {
+    {
+        PROF_SCOPE("read");
+        if (!database.readAux(setting.io_aux) || !database.readLib(setting.io_lib) ||
+            !database.readNodes(setting.io_nodes) || !database.readScl(setting.io_scl) ||
+            !database.readPl(setting.io_pl) || !database.readNets(setting.io_nets)) {
+            return false;
+        }
+    }
+    {
+        PROF_SCOPE("setup");
+        database.setup();
+        database.print();
+        gpSetting.init();
+    }
+    return true;
+}
+
+bool initTdm() {
+    PROF_SCOPE("tdm_init");
+    tdmGroups.assign(database.instances.size(), Group());
+    for (unsigned int i = 0; i < tdmGroups.size(); i++) {
+        tdmGroups[i].instances.push_back(database.instances[i]);
+        tdmGroups[i].id = i;
+    }
+    ifstream instPlFile("instance.pos");
+    for (unsigned int i = 0; i < tdmGroups.size(); i++) {
+        string instName;
+        double x, y;
+        instPlFile >> instName;
+        instPlFile >> x >> y;
+        Instance *instance = database.getInstance(instName);
+        if (instance == NULL) {
+            printlog(LOG_ERROR, "Instance not found: %s", instName.c_str());
+            continue;
+        }
+        tdmGroups[instance->id].x = x;
+        tdmGroups[instance->id].y = y;
+    }
+    instPlFile.close();
+
+    {
+        PROF_SCOPE("TdmDB::init");
+        if (setting.io_board != "" && !tdmDatabase.readBoard(setting.io_board, setting.nPartition)) return false;
+        if (!tdmDatabase.init(setting.nPartition, &tdmGroups)) return false;
+        tdmDatabase.getOptXdrVars();
+    }
+    tdmReady = true;
+    return true;
+}
+
+int runFlow() {
     if (setting.flow == Setting::Flow_Tdm_Part) {
+        PROF_SCOPE("tdm_part");
         vector<vector<int>> clusters;
-        partition(clusters, setting.nPartition);
+        {
+            PROF_SCOPE("partition");
+            if (!partition(clusters, setting.nPartition)) return 1;
+        }
 
         vector<int> instClusterIndex(database.instances.size());
         for (unsigned i = 0; i < clusters.size(); i++) {
@@ -46,59 +106,63 @@ int main(int argc, char **argv) {
         }
 
         vector<TdmNet *> tdmNets;
-        getTdmNets(instClusterIndex, tdmNets);
-        formPlSubproblem(clusters, tdmNets);
+        {
+            PROF_SCOPE("getTdmNets");
+            getTdmNets(instClusterIndex, tdmNets);
+        }
+        {
+            PROF_SCOPE("formPlSubproblem");
+            formPlSubproblem(clusters, tdmNets);
+        }
         log() << "finish generating sub problems" << endl;
     } else if (setting.flow == Setting::Flow_Tdm_Time) {
+        PROF_SCOPE("tdm_time");
         log() << "------------------------------------------------------" << endl;
         log() << "                begin TDM optimization                " << endl;
         log() << "------------------------------------------------------" << endl;
 
-        vector<Group> groups(database.instances.size());
-        for (unsigned int i = 0; i < groups.size(); i++) {
-            groups[i].instances.push_back(database.instances[i]);
-            groups[i].id = i;
+        if (!tdmReady && !initTdm()) return 1;
+        if (setting.io_eco != "") {
+            PROF_SCOPE("eco");
+            if (!tdmDatabase.readSol(setting.io_ecoBase) || !tdmDatabase.applyEco(setting.io_eco)) return 1;
         }
-        ifstream instPlFile("instance.pos");
-        unordered_map<string, int> nameToIndx;
-        for (unsigned int i = 0; i < groups.size(); i++) nameToIndx[groups[i].instances[0]->name] = i;
-
-        for (unsigned int i = 0; i < groups.size(); i++) {
-            string instName;
-            double x, y;
-            instPlFile >> instName;
-            instPlFile >> x >> y;
-            int idx = nameToIndx[instName];
-            groups[idx].x = x;
-            groups[idx].y = y;
+        if (setting.presolve) {
+            PROF_SCOPE("presolve");
+            tdmDatabase.presolve();
         }
-        instPlFile.close();
-
-        tdmDatabase.init(setting.nPartition, &groups);
-        tdmDatabase.getOptXdrVars();
 
         if (setting.cont == Setting::Tdm_LP) {
+            PROF_SCOPE("solveLP");
             TdmLpSolver tdmLpSolver(true);
             tdmLpSolver.solve();
         } else if (setting.cont == Setting::Tdm_ILP) {
+            PROF_SCOPE("solveILP");
             TdmLpSolver tdmLpSolver(false);
             tdmLpSolver.solve();
         } else if (setting.cont == Setting::Tdm_Lag) {
-            TdmLagSolver tdmLagSolver;
-            tdmLagSolver.solve();
+            PROF_SCOPE("solveLag");
+            string warmStartFile;
+            if (setting.io_eco != "") {
+                string baseName = setting.io_ecoBase.substr(0, setting.io_ecoBase.find_last_of('.'));
+                warmStartFile = baseName + "_lag.tdm";
+            }
+            solveLag(warmStartFile, setting.ecoSave ? database.bmName + "_lag.tdm" : "");
         } else if (setting.cont == Setting::Tdm_None) {
-            tdmDatabase.readSol(database.bmName + "_cont.tdm");
+            // an incremental run starts from the solution it is applied to
+            if (setting.io_eco == "" && !tdmDatabase.readSol(database.bmName + "_cont.tdm")) return 1;
         }
         tdmDatabase.writeSol(database.bmName + "_cont.tdm");
 
         if (setting.doRefine) {
+            PROF_SCOPE("refineLP");
             TdmRefineLP contRefiner(true);
             contRefiner.solve();
             tdmDatabase.writeSol(database.bmName + "_ref.tdm");
-            tdmDatabase.readSol(database.bmName + "_ref.tdm");
+            if (!tdmDatabase.readSol(database.bmName + "_ref.tdm")) return 1;
         }
 
         if (setting.lg != Setting::Lg_None) {
+            PROF_SCOPE("legalize");
             TdmLegalize legalizer;
             legalizer.solve();
         }
@@ -106,14 +170,26 @@ int main(int argc, char **argv) {
         // TdmRefineLP discRefiner(false);
         // discRefiner.solve();
 
-        TdmRefine greedyRefiner;
-        greedyRefiner.solve();
+        {
+            PROF_SCOPE("refineGreedy");
+            TdmRefine greedyRefiner;
+            greedyRefiner.solve();
+        }
 
         tdmDatabase.reportSol();
-        tdmDatabase.writeSol(setting.io_out);
+        if (setting.presolve) tdmDatabase.checkPresolve();
+        tdmDatabase.writeSol(setting.io_out, !setting.binSol);
 
         log() << "finish tdm optimization" << endl;
+    } else if (setting.flow == Setting::Flow_Tdm_Sweep) {
+        PROF_SCOPE("tdm_sweep");
+        if (!tdmReady && !initTdm()) return 1;
+        TdmSweep sweep;
+        if (!sweep.read(setting.io_sweep)) return 1;
+        sweep.solve();
+        sweep.writeTable(database.bmName + "_sweep.csv");
     } else if (setting.flow == Setting::Flow_Tdm_Place) {
+        PROF_SCOPE("tdm_place");
         vector<Group> groups(database.instances.size());
         for (unsigned int i = 0; i < groups.size(); i++) {
             groups[i].instances.push_back(database.instances[i]);
@@ -124,6 +200,7 @@ int main(int argc, char **argv) {
         gplace(groups);
         gpSetting.set3();
         gplace(groups);
+        prof::count("instances", groups.size());
 
         ofstream fs(setting.io_out);
         for (auto &group : groups) {
@@ -134,22 +211,32 @@ int main(int argc, char **argv) {
         log() << "finish placement for sub problem " << database.bmName << endl;
     }
 
-    log() << "-----------------------------------" << endl;
-    log() << "           terminating...          " << endl;
-    log() << "-----------------------------------" << endl;
     return 0;
 }
 
+// the value of the option at a is the next argument
+bool hasValue(int argc, char **argv, int a) {
+    if (a + 1 < argc) return true;
+    cerr << "missing value of " << argv[a] << endl;
+    return false;
+}
+
 bool get_args(int argc, char **argv) {
     bool valid = true;
     for (int a = 1; a < argc; a++) {
         if (strcmp(argv[a], "-out") == 0) {
+            if (!hasValue(argc, argv, a)) return false;
             setting.io_out.assign(argv[++a]);
             unsigned pos = setting.io_out.find_last_of('.');
             database.bmName = setting.io_out.substr(0, pos);
+        } else if (strcmp(argv[a], "-report") == 0) {
+            if (!hasValue(argc, argv, a)) return false;
+            setting.io_report.assign(argv[++a]);
         } else if (strcmp(argv[a], "-aux") == 0) {
+            if (!hasValue(argc, argv, a)) return false;
             setting.io_aux.assign(argv[++a]);
         } else if (strcmp(argv[a], "-flow") == 0) {
+            if (!hasValue(argc, argv, a)) return false;
             string flowname(argv[++a]);
             if (flowname == "tdm_part") {
                 setting.flow = Setting::Flow_Tdm_Part;
@@ -157,11 +244,14 @@ bool get_args(int argc, char **argv) {
                 setting.flow = Setting::Flow_Tdm_Place;
             } else if (flowname == "tdm_time") {
                 setting.flow = Setting::Flow_Tdm_Time;
+            } else if (flowname == "tdm_sweep") {
+                setting.flow = Setting::Flow_Tdm_Sweep;
             } else {
                 cerr << "unknown flow: " << flowname << endl;
                 valid = false;
             }
         } else if (strcmp(argv[a], "-cont") == 0) {
+            if (!hasValue(argc, argv, a)) return false;
             string methodname(argv[++a]);
             if (methodname == "ILP") {
                 setting.cont = Setting::Tdm_ILP;
@@ -176,6 +266,7 @@ bool get_args(int argc, char **argv) {
                 valid = false;
             }
         } else if (strcmp(argv[a], "-lg") == 0) {
+            if (!hasValue(argc, argv, a)) return false;
             string methodname(argv[++a]);
             if (methodname == "Disp") {
                 setting.lg = Setting::Lg_Disp;
@@ -187,22 +278,146 @@ bool get_args(int argc, char **argv) {
                 cerr << "unknown method: " << methodname << endl;
                 valid = false;
             }
+        } else if (strcmp(argv[a], "-precond") == 0) {
+            if (!hasValue(argc, argv, a)) return false;
+            string methodname(argv[++a]);
+            if (methodname == "Jacobi") {
+                setting.precond = Setting::Precond_Jacobi;
+            } else if (methodname == "IC") {
+                setting.precond = Setting::Precond_IC;
+            } else if (methodname == "AMG") {
+                setting.precond = Setting::Precond_AMG;
+            } else {
+                cerr << "unknown preconditioner: " << methodname << endl;
+                valid = false;
+            }
+        } else if (strcmp(argv[a], "-ub") == 0) {
+            if (!hasValue(argc, argv, a)) return false;
+            string methodname(argv[++a]);
+            if (methodname == "Spread") {
+                setting.ub = Setting::UB_Spread;
+            } else if (methodname == "Electro") {
+                setting.ub = Setting::UB_Electro;
+            } else {
+                cerr << "unknown method: " << methodname << endl;
+                valid = false;
+            }
+        } else if (strcmp(argv[a], "-precision") == 0) {
+            if (!hasValue(argc, argv, a)) return false;
+            string precisionname(argv[++a]);
+            if (precisionname == "double") {
+                setting.precision = Setting::Precision_Double;
+            } else if (precisionname == "float") {
+                setting.precision = Setting::Precision_Float;
+            } else {
+                cerr << "unknown precision: " << precisionname << endl;
+                valid = false;
+            }
+        } else if (strcmp(argv[a], "-simd") == 0) {
+            if (!hasValue(argc, argv, a)) return false;
+            string isaname(argv[++a]);
+            if (isaname == "auto") {
+                setting.simd = Setting::Simd_Auto;
+            } else if (isaname == "off") {
+                setting.simd = Setting::Simd_Off;
+            } else if (isaname == "scalar") {
+                setting.simd = Setting::Simd_Scalar;
+            } else if (isaname == "sse4.2") {
+                setting.simd = Setting::Simd_SSE42;
+            } else if (isaname == "avx2") {
+                setting.simd = Setting::Simd_AVX2;
+            } else if (isaname == "avx512") {
+                setting.simd = Setting::Simd_AVX512;
+            } else {
+                cerr << "unknown simd isa: " << isaname << endl;
+                valid = false;
+            }
         } else if (strcmp(argv[a], "-partition") == 0) {
+            if (!hasValue(argc, argv, a)) return false;
             setting.nPartition = atoi(string(argv[++a]).c_str());
         } else if (strcmp(argv[a], "-thread") == 0) {
+            if (!hasValue(argc, argv, a)) return false;
             setting.nThreads = atoi(string(argv[++a]).c_str());
+        } else if (strcmp(argv[a], "-gpThread") == 0) {
+            if (!hasValue(argc, argv, a)) return false;
+            setting.gpThreads = atoi(string(argv[++a]).c_str());
         } else if (strcmp(argv[a], "-refine") == 0) {
             setting.doRefine = true;
         } else if (strcmp(argv[a], "-lagIter") == 0) {
+            if (!hasValue(argc, argv, a)) return false;
             setting.lagIter = atoi(string(argv[++a]).c_str());
+        } else if (strcmp(argv[a], "-lagUpdate") == 0) {
+            if (!hasValue(argc, argv, a)) return false;
+            string schemename(argv[++a]);
+            if (schemename == "geometric") {
+                setting.lagUpdate = Setting::LagUpdate_Geometric;
+            } else if (schemename == "polyak") {
+                setting.lagUpdate = Setting::LagUpdate_Polyak;
+            } else if (schemename == "momentum") {
+                setting.lagUpdate = Setting::LagUpdate_Momentum;
+            } else if (schemename == "nesterov") {
+                setting.lagUpdate = Setting::LagUpdate_Nesterov;
+            } else if (schemename == "bundle") {
+                setting.lagUpdate = Setting::LagUpdate_Bundle;
+            } else {
+                cerr << "unknown multiplier update: " << schemename << endl;
+                valid = false;
+            }
+        } else if (strcmp(argv[a], "-partSeeds") == 0) {
+            if (!hasValue(argc, argv, a)) return false;
+            setting.partSeeds = atoi(string(argv[++a]).c_str());
+        } else if (strcmp(argv[a], "-partTiming") == 0) {
+            if (!hasValue(argc, argv, a)) return false;
+            setting.partTimingIter = atoi(string(argv[++a]).c_str());
         } else if (strcmp(argv[a], "-computeDual") == 0) {
             setting.computeDual = true;
+        } else if (strcmp(argv[a], "-eco") == 0) {
+            if (!hasValue(argc, argv, a)) return false;
+            setting.io_eco.assign(argv[++a]);
+        } else if (strcmp(argv[a], "-ecoBase") == 0) {
+            if (!hasValue(argc, argv, a)) return false;
+            setting.io_ecoBase.assign(argv[++a]);
+        } else if (strcmp(argv[a], "-ecoSave") == 0) {
+            setting.ecoSave = true;
+        } else if (strcmp(argv[a], "-binSol") == 0) {
+            setting.binSol = true;
+        } else if (strcmp(argv[a], "-presolve") == 0) {
+            setting.presolve = true;
+        } else if (strcmp(argv[a], "-board") == 0) {
+            if (!hasValue(argc, argv, a)) return false;
+            setting.io_board.assign(argv[++a]);
+        } else if (strcmp(argv[a], "-sweep") == 0) {
+            if (!hasValue(argc, argv, a)) return false;
+            setting.io_sweep.assign(argv[++a]);
+        } else if (strcmp(argv[a], "-serve") == 0 || strcmp(argv[a], "--serve") == 0) {
+            if (!hasValue(argc, argv, a)) return false;
+            setting.io_serve.assign(argv[++a]);
+        } else if (strcmp(argv[a], "-jobs") == 0) {
+            if (!hasValue(argc, argv, a)) return false;
+            setting.serveJobs = atoi(string(argv[++a]).c_str());
         } else {
             cerr << "unknown parameter: " << argv[a] << endl;
             valid = false;
         }
     }
-    if (valid && setting.io_aux == "") valid = false;
-    if (!valid) log() << "usage: " << argv[0] << " -aux <aux_file> [-out <output_file>]" << endl;
+    if (valid && setting.io_aux == "" && setting.io_serve == "") valid = false;
+    if (valid && setting.io_eco != "" && setting.io_ecoBase == "") {
+        cerr << "-eco requires -ecoBase <solution>" << endl;
+        valid = false;
+    }
+    if (valid && setting.flow == Setting::Flow_Tdm_Sweep && setting.io_sweep == "") {
+        cerr << "tdm_sweep requires -sweep <scenario_file>" << endl;
+        valid = false;
+    }
+    if (valid) {
+        string cmd = argv[0];
+        for (int a = 1; a < argc; a++) cmd += string(" ") + argv[a];
+        prof::info("command", cmd);
+        prof::info("threads", to_string(setting.nThreads));
+    }
+    if (!valid) {
+        log() << "usage: " << argv[0] << " -aux <aux_file> [-out <output_file>]" << endl;
+        log() << "       " << argv[0] << " -serve <socket> [-jobs <n>] [-thread <n>]" << endl;
+    }
     return valid;
 }
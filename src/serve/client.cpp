@@ -0,0 +1,111 @@
+// larf_client: sends a job to a larf server (larf -serve <socket>) and prints its log,
+// exiting with the status of the job
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "serve_msg.h"
+
+using namespace std;
+using namespace msg;
+
+bool isOption(const char* arg) {
+    if (arg[0] != '-' || arg[1] == '\0') return false;
+    char* end;
+    strtod(arg, &end);
+    return *end != '\0';  // not a negative number
+}
+
+int main(int argc, char** argv) {
+    string socketPath, dir = ".";
+    vector<Field> fields;
+    bool valid = true;
+    int a = 1;
+    for (; a < argc; a++) {
+        if (strcmp(argv[a], "-socket") == 0 && a + 1 < argc) {
+            socketPath = argv[++a];
+        } else if (strcmp(argv[a], "-dir") == 0 && a + 1 < argc) {
+            dir = argv[++a];
+        } else if (strcmp(argv[a], "-status") == 0) {
+            setField(fields, "cmd", "status");
+        } else if (strcmp(argv[a], "-shutdown") == 0) {
+            setField(fields, "cmd", "shutdown");
+        } else if (strcmp(argv[a], "--") == 0) {
+            a++;
+            break;
+        } else {
+            cerr << "unknown parameter: " << argv[a] << endl;
+            valid = false;
+        }
+    }
+    // the rest are options of larf, the ones without a value are flags
+    for (; a < argc; a++) {
+        if (!isOption(argv[a])) {
+            cerr << "not an option: " << argv[a] << endl;
+            valid = false;
+            continue;
+        }
+        Field field = {argv[a] + 1, "", true};
+        if (a + 1 < argc && !isOption(argv[a + 1])) {
+            field.value = argv[++a];
+            field.isFlag = false;
+        }
+        fields.push_back(field);
+    }
+    if (!valid || socketPath == "") {
+        cerr << "usage: " << argv[0] << " -socket <socket> [-dir <work_dir>] -- <larf options...>" << endl;
+        cerr << "       " << argv[0] << " -socket <socket> -status|-shutdown" << endl;
+        return 1;
+    }
+    if (getField(fields, "cmd") == "") {
+        char* cwd = getcwd(NULL, 0);
+        setField(fields, "dir", dir[0] == '/' ? dir : string(cwd) + "/" + dir);
+        free(cwd);
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        cerr << "cannot connect to " << socketPath << ": " << strerror(errno) << endl;
+        return 1;
+    }
+    if (!writeLine(fd, formatMsg(fields))) {
+        cerr << "cannot send the request" << endl;
+        return 1;
+    }
+
+    string buf, line;
+    vector<Field> reply;
+    while (readLine(fd, buf, line)) {
+        if (!parseMsg(line, reply)) {
+            cerr << "invalid reply: " << line << endl;
+            continue;
+        }
+        string type = getField(reply, "type");
+        if (type == "log") {
+            cout << getField(reply, "line") << endl;
+        } else if (type == "queued") {
+            cerr << "[larf_client] queued" << endl;
+        } else if (type == "start") {
+            cerr << "[larf_client] start, " << getField(reply, "resident") << endl;
+        } else if (type == "status") {
+            cout << line << endl;
+            return 0;
+        } else if (type == "error") {
+            cerr << "[larf_client] error: " << getField(reply, "message") << endl;
+            return 1;
+        } else if (type == "done") {
+            cerr << "[larf_client] done in " << getField(reply, "time", "0") << "s" << endl;
+            return atoi(getField(reply, "status", "1").c_str());
+        }
+    }
+    cerr << "[larf_client] the server closed the connection" << endl;
+    return 1;
+}
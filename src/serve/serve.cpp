@@ -0,0 +1,568 @@
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "serve.h"
+#include "serve_msg.h"
+#include "db/db.h"
+
+using namespace msg;
+
+// The settings and the databases are globals, so a resident state is a process rather than a cache of the server:
+//   level 0: the server, which accepts requests and routes them by the aux file
+//   level 1: a design read and set up, which routes tdm_time requests by partition, instance.device and instance.pos
+//   level 2: a timing graph with TdmDB initialized
+// A job is a fork of the state it is routed to, so it starts from the resident data and leaves it intact.
+// The client socket is passed down to the job with SCM_RIGHTS.
+
+namespace {
+
+const unsigned maxResident = 8;  // children of a state, the least recently used one is evicted
+const int maxMsgSize = 1 << 16;
+const int requestTimeout = 10;  // seconds for a client to send its request
+
+struct Resident {
+    string key;
+    int fd;
+    int lastUse;
+};
+
+struct Pending {
+    int fd;
+    string buf;
+    timer::timer time;
+};
+
+vector<Resident> residents;  // children of this state
+vector<Pending> pendings;    // clients of the server yet to send their request
+int useClock = 0;
+int listenFd = -1;
+int stateFd = -1;           // to the parent state
+int tokenFd[2] = {-1, -1};  // job slots shared by all processes of the server, a byte for each
+
+void reply(int clientFd, const string &type, const string &body = "") {
+    writeLine(clientFd, "{\"type\":\"" + type + "\"" + body + "}");
+}
+
+void replyError(int clientFd, const string &message) {
+    reply(clientFd, "error", ",\"message\":\"" + jsonEscape(message) + "\"");
+}
+
+bool sendJob(int fd, const string &msg, int clientFd) {
+    struct iovec iov;
+    iov.iov_base = (void *)msg.data();
+    iov.iov_len = msg.size();
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } ctrl;
+    memset(&ctrl, 0, sizeof(ctrl));
+
+    struct msghdr hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.msg_iov = &iov;
+    hdr.msg_iovlen = 1;
+    hdr.msg_control = ctrl.buf;
+    hdr.msg_controllen = sizeof(ctrl.buf);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&hdr);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &clientFd, sizeof(int));
+    return sendmsg(fd, &hdr, MSG_NOSIGNAL) == (ssize_t)msg.size();
+}
+
+// false if the parent is gone
+bool recvJob(int fd, string &msg, int &clientFd) {
+    vector<char> buf(maxMsgSize);
+    struct iovec iov;
+    iov.iov_base = buf.data();
+    iov.iov_len = buf.size();
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } ctrl;
+
+    struct msghdr hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.msg_iov = &iov;
+    hdr.msg_iovlen = 1;
+    hdr.msg_control = ctrl.buf;
+    hdr.msg_controllen = sizeof(ctrl.buf);
+    ssize_t ret;
+    do {
+        ret = recvmsg(fd, &hdr, 0);
+    } while (ret < 0 && errno == EINTR);
+    if (ret <= 0) return false;
+
+    clientFd = -1;
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&hdr); cmsg != NULL; cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            memcpy(&clientFd, CMSG_DATA(cmsg), sizeof(int));
+        }
+    }
+    msg.assign(buf.data(), ret);
+    return true;
+}
+
+// a forked child keeps none of the sockets of its parent, otherwise an evicted state would never see the end of its input
+void closeInherited() {
+    for (auto &resident : residents) close(resident.fd);
+    residents.clear();
+    for (auto &pending : pendings) {
+        if (pending.fd >= 0) close(pending.fd);
+    }
+    pendings.clear();
+    if (listenFd >= 0) close(listenFd);
+    if (stateFd >= 0) close(stateFd);
+    listenFd = stateFd = -1;
+}
+
+bool resolvePath(const string &path, const string &base, string &res) {
+    if (path == "") return false;
+    string full = (path[0] == '/') ? path : base + "/" + path;
+    char *real = realpath(full.c_str(), NULL);
+    if (real == NULL) return false;
+    res = real;
+    free(real);
+    return true;
+}
+
+string fileHash(const string &file) {
+    ifstream fs(file, ios::binary);
+    if (!fs.good()) return "none";
+    uint64_t hash = 14695981039346656037ULL;  // FNV-1a
+    char buf[1 << 16];
+    while (fs.read(buf, sizeof(buf)) || fs.gcount() > 0) {
+        for (streamsize i = 0; i < fs.gcount(); i++) {
+            hash ^= (unsigned char)buf[i];
+            hash *= 1099511628211ULL;
+        }
+    }
+    char str[20];
+    snprintf(str, sizeof(str), "%016llx", (unsigned long long)hash);
+    return str;
+}
+
+string fileStamp(const string &file) {
+    struct stat st;
+    if (stat(file.c_str(), &st) != 0) return "none";
+    return to_string((long long)st.st_size) + ':' + to_string((long long)st.st_mtim.tv_sec) + '.' +
+           to_string((long long)st.st_mtim.tv_nsec);
+}
+
+// the aux and the design files it lists by their size and modification time, as Database::readAux finds them, so a
+// changed design is read again rather than served from its resident state
+string designKey(const string &aux) {
+    string key = aux + '|' + fileStamp(aux);
+    string directory = aux.substr(0, aux.find_last_of('/') + 1);
+    ifstream fs(aux);
+    string buffer;
+    while (fs >> buffer) {
+        if (buffer == "#") {
+            fs.ignore(numeric_limits<streamsize>::max(), '\n');
+            continue;
+        }
+        size_t dot_pos = buffer.find_last_of(".");
+        if (dot_pos == string::npos) continue;
+        string ext = buffer.substr(dot_pos);
+        if (ext == ".nodes" || ext == ".nets" || ext == ".pl" || ext == ".wts" || ext == ".scl" || ext == ".lib") {
+            key += '|' + fileStamp(directory + buffer);
+        }
+    }
+    return key;
+}
+
+// the options of a request start from the defaults, except for the files given by the aux of the resident design
+bool applyRequest(const vector<Field> &fields, string &error) {
+    string dir = getField(fields, "dir");
+    if (chdir(dir.c_str()) != 0) {
+        error = "cannot enter " + dir;
+        return false;
+    }
+
+    Setting resident = setting;
+    setting = Setting();
+    setting.io_nodes = resident.io_nodes;
+    setting.io_nets = resident.io_nets;
+    setting.io_pl = resident.io_pl;
+    setting.io_wts = resident.io_wts;
+    setting.io_scl = resident.io_scl;
+    setting.io_lib = resident.io_lib;
+    db::database.bmName = "";
+
+    vector<string> args(1, "larf");
+    for (const auto &field : fields) {
+        if (field.key == "dir") continue;
+        args.push_back("-" + field.key);
+        if (!field.isFlag) args.push_back(field.value);
+    }
+    vector<char *> argv;
+    for (auto &arg : args) argv.push_back(&arg[0]);
+    argv.push_back(NULL);
+    if (!get_args(args.size(), argv.data()) || setting.io_serve != "") {
+        error = "invalid options, see the usage of larf";
+        return false;
+    }
+    return true;
+}
+
+void runState(int level);
+
+int spawnState(int level, const vector<Field> &fields, int clientFd) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) != 0) return -1;
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(sv[0]);
+        close(sv[1]);
+        return -1;
+    }
+    if (pid > 0) {
+        close(sv[1]);
+        return sv[0];
+    }
+
+    close(sv[0]);
+    close(clientFd);
+    closeInherited();
+    stateFd = sv[1];
+    string error;
+    if (!applyRequest(fields, error)) _exit(1);
+    if (level == 1 ? !readDesign() : !initTdm()) _exit(1);
+    printlog(LOG_INFO, "resident %s of %s", level == 1 ? "design" : "timing graph", getField(fields, "dir").c_str());
+    runState(level);
+    return -1;
+}
+
+// forward a request to the resident child of key, which is set up first if there is none
+void route(int level, const string &key, const string &tag, const vector<Field> &fields, int clientFd) {
+    string name = level == 0 ? "design" : "timing";
+    for (int attempt = 0; attempt < 2; attempt++) {
+        auto it = find_if(residents.begin(), residents.end(), [&](const Resident &r) { return r.key == key; });
+        bool hit = it != residents.end();
+        int fd;
+        if (hit) {
+            it->lastUse = ++useClock;
+            fd = it->fd;
+        } else {
+            if (residents.size() >= maxResident) {
+                auto lru = min_element(residents.begin(), residents.end(), [](const Resident &a, const Resident &b) {
+                    return a.lastUse < b.lastUse;
+                });
+                close(lru->fd);
+                residents.erase(lru);
+            }
+            fd = spawnState(level + 1, fields, clientFd);
+            if (fd < 0) break;
+            residents.push_back({key, fd, ++useClock});
+        }
+
+        string resident = tag + (tag == "" ? "" : " ") + name + (hit ? ":hit" : ":miss");
+        if (sendJob(fd, resident + '\n' + formatMsg(fields), clientFd)) {
+            close(clientFd);
+            return;
+        }
+
+        // the resident child is gone, e.g., it failed to set up
+        close(fd);
+        residents.erase(find_if(residents.begin(), residents.end(), [&](const Resident &r) { return r.key == key; }));
+        if (!hit) break;
+    }
+    replyError(clientFd, "cannot set up the resident " + name);
+    close(clientFd);
+}
+
+// stream the output of the worker line by line, and stop the worker once the client hangs up
+void relayLog(int outFd, int clientFd, pid_t worker) {
+    bool connected = true;
+    string buf;
+    while (true) {
+        struct pollfd pfds[2] = {{outFd, POLLIN, 0}, {clientFd, POLLRDHUP, 0}};
+        if (poll(pfds, connected ? 2 : 1, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (connected && (pfds[1].revents & (POLLRDHUP | POLLHUP | POLLERR))) {
+            // nobody waits for the result
+            connected = false;
+            kill(worker, SIGTERM);
+        }
+        if (pfds[0].revents == 0) continue;
+
+        char chunk[4096];
+        ssize_t ret = read(outFd, chunk, sizeof(chunk));
+        if (ret < 0 && errno == EINTR) continue;
+        if (ret > 0) buf.append(chunk, ret);
+        size_t begin = 0, end;
+        // the last line may be unterminated
+        while ((end = buf.find('\n', begin)) != string::npos || (ret <= 0 && begin < buf.size())) {
+            if (end == string::npos) end = buf.size();
+            string line = "{\"type\":\"log\",\"line\":\"" + jsonEscape(buf.substr(begin, end - begin)) + "\"}";
+            if (connected && !writeLine(clientFd, line)) {
+                connected = false;
+                kill(worker, SIGTERM);
+            }
+            begin = end + 1;
+        }
+        buf.erase(0, min(begin, buf.size()));
+        if (ret <= 0) break;
+    }
+}
+
+void runJob(const string &resident, const vector<Field> &fields, int clientFd) {
+    pid_t pid = fork();
+    if (pid != 0) {
+        if (pid < 0) replyError(clientFd, "cannot fork the job");
+        close(clientFd);
+        return;
+    }
+
+    signal(SIGCHLD, SIG_DFL);
+    closeInherited();
+
+    char token;
+    struct pollfd pfd = {tokenFd[0], POLLIN, 0};
+    if (poll(&pfd, 1, 0) <= 0) reply(clientFd, "queued");
+    while (read(tokenFd[0], &token, 1) != 1) {
+        if (errno != EINTR) _exit(1);
+    }
+    reply(clientFd, "start", ",\"resident\":\"" + jsonEscape(resident) + "\"");
+
+    timer::timer time;
+    int fd[2];
+    pid_t worker = pipe(fd) == 0 ? fork() : -1;
+    if (worker == 0) {
+        close(fd[0]);
+        close(clientFd);
+        close(tokenFd[0]);
+        close(tokenFd[1]);
+        dup2(fd[1], STDOUT_FILENO);
+        dup2(fd[1], STDERR_FILENO);
+        close(fd[1]);
+
+        int ret = 1;
+        string error;
+        prof::reset();  // the report is of the job, not of the setup of its resident state
+        if (applyRequest(fields, error)) {
+            ret = runFlow();
+            if (setting.io_report != "") prof::writeReport(setting.io_report);
+        } else {
+            cerr << error << endl;
+        }
+        cout.flush();
+        cerr.flush();
+        fflush(stdout);
+        _exit(ret);
+    }
+
+    int ret = -1;
+    if (worker > 0) {
+        close(fd[1]);
+        relayLog(fd[0], clientFd, worker);
+        int status;
+        while (waitpid(worker, &status, 0) < 0 && errno == EINTR) {
+        }
+        ret = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    }
+    while (write(tokenFd[1], &token, 1) != 1 && errno == EINTR) {
+    }
+
+    if (worker < 0) {
+        replyError(clientFd, "cannot fork the job");
+    } else {
+        char body[64];
+        snprintf(body, sizeof(body), ",\"status\":%d,\"time\":%.3lf", ret, time.elapsed());
+        reply(clientFd, "done", body);
+    }
+    _exit(0);
+}
+
+void runState(int level) {
+    string msg;
+    int clientFd;
+    while (recvJob(stateFd, msg, clientFd)) {
+        if (clientFd < 0) continue;
+        size_t pos = msg.find('\n');
+        vector<Field> fields;
+        if (pos == string::npos || !parseMsg(msg.substr(pos + 1), fields)) {
+            replyError(clientFd, "invalid request");
+            close(clientFd);
+            continue;
+        }
+        string resident = msg.substr(0, pos);
+
+        if (level == 1) {
+            string error;
+            if (!applyRequest(fields, error)) {
+                replyError(clientFd, error);
+                close(clientFd);
+                continue;
+            }
+            if (setting.flow == Setting::Flow_Tdm_Time || setting.flow == Setting::Flow_Tdm_Sweep) {
+                string key = getField(fields, "dir") + '|' + to_string(setting.nPartition) + '|' +
+                             fileHash("instance.device") + '|' + fileHash("instance.pos") + '|' +
+                             (setting.io_board == "" ? "" : fileHash(setting.io_board));
+                route(level, key, resident, fields, clientFd);
+                continue;
+            }
+        }
+        runJob(resident, fields, clientFd);
+    }
+    closeInherited();
+    _exit(0);
+}
+
+// false for a shutdown
+bool serveRequest(const string &request, int clientFd, const string &base, int nJobs) {
+    vector<Field> fields;
+    if (request.size() > (size_t)maxMsgSize || !parseMsg(request, fields)) {
+        replyError(clientFd, "invalid request");
+        close(clientFd);
+        return true;
+    }
+
+    string cmd = getField(fields, "cmd");
+    if (cmd == "shutdown") {
+        reply(clientFd, "done", ",\"status\":0");
+        close(clientFd);
+        return false;
+    } else if (cmd == "status") {
+        string designs;
+        for (const auto &resident : residents) {
+            designs += (designs == "" ? "" : " ") + resident.key.substr(0, resident.key.find('|'));
+        }
+        reply(clientFd, "status", ",\"jobs\":" + to_string(nJobs) + ",\"designs\":\"" + jsonEscape(designs) + "\"");
+        close(clientFd);
+        return true;
+    } else if (cmd != "") {
+        replyError(clientFd, "unknown cmd: " + cmd);
+        close(clientFd);
+        return true;
+    }
+
+    // the states and jobs see absolute paths only
+    string dir, aux;
+    if (!resolvePath(getField(fields, "dir", "."), base, dir)) {
+        replyError(clientFd, "cannot find dir " + getField(fields, "dir"));
+        close(clientFd);
+        return true;
+    }
+    if (!resolvePath(getField(fields, "aux"), dir, aux)) {
+        replyError(clientFd, "cannot find aux " + getField(fields, "aux"));
+        close(clientFd);
+        return true;
+    }
+    setField(fields, "dir", dir);
+    setField(fields, "aux", aux);
+    printlog(LOG_INFO, "request: %s", formatMsg(fields).c_str());
+    route(0, designKey(aux), "", fields, clientFd);
+    return true;
+}
+
+}  // namespace
+
+int serve(const string &socketPath) {
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGCHLD, SIG_IGN);  // states and jobs are not waited for
+
+    int nJobs = setting.serveJobs;
+    if (nJobs <= 0) nJobs = max(1, (int)thread::hardware_concurrency() / max(1, setting.nThreads));
+    if (pipe(tokenFd) != 0) {
+        printlog(LOG_ERROR, "cannot create the job slots");
+        return 1;
+    }
+    for (int i = 0; i < nJobs; i++) {
+        char token = 0;
+        if (write(tokenFd[1], &token, 1) != 1) return 1;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        printlog(LOG_ERROR, "socket path too long: %s", socketPath.c_str());
+        return 1;
+    }
+    strcpy(addr.sun_path, socketPath.c_str());
+    unlink(socketPath.c_str());
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0 || bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(listenFd, 64) != 0) {
+        printlog(LOG_ERROR, "cannot listen on %s: %s", socketPath.c_str(), strerror(errno));
+        return 1;
+    }
+    printlog(LOG_INFO, "serving on %s, %d jobs of %d threads at a time", socketPath.c_str(), nJobs, setting.nThreads);
+
+    char *cwd = getcwd(NULL, 0);
+    string base = cwd;
+    free(cwd);
+    // a client may be slow to send its request, so the requests are read as they come rather than one at a time
+    bool running = true;
+    while (running) {
+        vector<struct pollfd> pfds(1, {listenFd, POLLIN, 0});
+        int wait = -1;
+        for (const auto &pending : pendings) {
+            pfds.push_back({pending.fd, POLLIN, 0});
+            int left = max(0, (int)ceil((requestTimeout - pending.time.elapsed()) * 1000));
+            if (wait < 0 || left < wait) wait = left;
+        }
+        if (poll(pfds.data(), pfds.size(), wait) < 0) {
+            if (errno == EINTR) continue;
+            printlog(LOG_ERROR, "poll: %s", strerror(errno));
+            break;
+        }
+
+        // a pending client is done once its fd is -1, forks of the states close the others
+        for (unsigned i = 0; i < pendings.size(); i++) {
+            Pending &pending = pendings[i];
+            bool complete = false;
+            if (pfds[i + 1].revents != 0) {
+                char chunk[4096];
+                ssize_t ret = read(pending.fd, chunk, sizeof(chunk));
+                if (ret > 0) pending.buf.append(chunk, ret);
+                // the request may be unterminated
+                complete = pending.buf.find('\n') != string::npos || (ret == 0 && !pending.buf.empty());
+                if (!complete && (ret == 0 || (ret < 0 && errno != EINTR && errno != EAGAIN))) {
+                    close(pending.fd);
+                    pending.fd = -1;
+                    continue;
+                }
+            }
+            int clientFd = pending.fd;
+            if (!running) continue;
+            if (complete || pending.buf.size() > (size_t)maxMsgSize) {
+                running = serveRequest(pending.buf.substr(0, pending.buf.find('\n')), clientFd, base, nJobs);
+                pending.fd = -1;
+            } else if (pending.time.elapsed() >= requestTimeout) {
+                replyError(clientFd, "no request");
+                close(clientFd);
+                pending.fd = -1;
+            }
+        }
+        pendings.erase(remove_if(pendings.begin(), pendings.end(), [](const Pending &p) { return p.fd < 0; }),
+                       pendings.end());
+
+        if (running && (pfds[0].revents & POLLIN)) {
+            int clientFd = accept(listenFd, NULL, NULL);
+            if (clientFd >= 0) {
+                pendings.push_back({clientFd, "", timer::timer()});
+            } else if (errno != EINTR && errno != EAGAIN && errno != ECONNABORTED) {
+                printlog(LOG_ERROR, "accept: %s", strerror(errno));
+                break;
+            }
+        }
+    }
+
+    for (auto &pending : pendings) close(pending.fd);
+    pendings.clear();
+    for (auto &resident : residents) close(resident.fd);
+    residents.clear();
+    close(listenFd);
+    unlink(socketPath.c_str());
+    return 0;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "global.h"
+
+// flows of main.cpp, also run by the jobs of the server
+bool get_args(int argc, char **argv);
+bool readDesign();  // false if a file of the design cannot be read
+bool initTdm();  // tdm_time/tdm_sweep up to the timing graph
+int runFlow();
+
+// serve jobs (see serve_msg.h) on a unix socket until a shutdown request
+int serve(const string &socketPath);
@@ -0,0 +1,203 @@
+#include <cctype>
+#include <cstdio>
+#include <unistd.h>
+
+#include "serve_msg.h"
+
+using namespace std;
+
+namespace msg {
+
+bool parseString(const string& line, size_t& pos, string& str) {
+    if (pos >= line.size() || line[pos] != '"') return false;
+    str.clear();
+    for (pos++; pos < line.size(); pos++) {
+        char c = line[pos];
+        if (c == '"') {
+            pos++;
+            return true;
+        }
+        if (c != '\\') {
+            str += c;
+            continue;
+        }
+        if (++pos >= line.size()) return false;
+        switch (line[pos]) {
+            case 'n':
+                str += '\n';
+                break;
+            case 't':
+                str += '\t';
+                break;
+            case 'r':
+                str += '\r';
+                break;
+            case 'b':
+                str += '\b';
+                break;
+            case 'f':
+                str += '\f';
+                break;
+            case 'u': {
+                // only the ASCII range is expected
+                unsigned code;
+                if (pos + 4 >= line.size() || sscanf(line.c_str() + pos + 1, "%4x", &code) != 1) return false;
+                str += code < 0x80 ? (char)code : '?';
+                pos += 4;
+                break;
+            }
+            default:
+                str += line[pos];
+                break;
+        }
+    }
+    return false;
+}
+
+void skipSpaces(const string& line, size_t& pos) {
+    while (pos < line.size() && isspace((unsigned char)line[pos])) pos++;
+}
+
+bool parseMsg(const string& line, vector<Field>& fields) {
+    fields.clear();
+    size_t pos = 0;
+    skipSpaces(line, pos);
+    if (pos >= line.size() || line[pos++] != '{') return false;
+    skipSpaces(line, pos);
+    if (pos < line.size() && line[pos] == '}') return true;
+    while (pos < line.size()) {
+        Field field;
+        skipSpaces(line, pos);
+        if (!parseString(line, pos, field.key)) return false;
+        skipSpaces(line, pos);
+        if (pos >= line.size() || line[pos++] != ':') return false;
+        skipSpaces(line, pos);
+        if (pos >= line.size()) return false;
+
+        field.isFlag = false;
+        bool skip = false;
+        if (line[pos] == '"') {
+            if (!parseString(line, pos, field.value)) return false;
+        } else {
+            size_t end = pos;
+            while (end < line.size() && line[end] != ',' && line[end] != '}' && !isspace((unsigned char)line[end])) {
+                end++;
+            }
+            field.value = line.substr(pos, end - pos);
+            pos = end;
+            if (field.value == "true") {
+                field.isFlag = true;
+                field.value.clear();
+            } else if (field.value == "false" || field.value == "null") {
+                skip = true;
+            } else if (field.value.empty() || field.value[0] == '{' || field.value[0] == '[') {
+                return false;
+            }
+        }
+        if (!skip) fields.push_back(field);
+
+        skipSpaces(line, pos);
+        if (pos >= line.size()) return false;
+        if (line[pos] == '}') return true;
+        if (line[pos++] != ',') return false;
+    }
+    return false;
+}
+
+string formatMsg(const vector<Field>& fields) {
+    string line = "{";
+    for (const auto& field : fields) {
+        if (line.size() > 1) line += ',';
+        line += '"' + jsonEscape(field.key) + "\":";
+        line += field.isFlag ? "true" : '"' + jsonEscape(field.value) + '"';
+    }
+    return line + '}';
+}
+
+string getField(const vector<Field>& fields, const string& key, const string& def) {
+    for (const auto& field : fields) {
+        if (field.key == key) return field.value;
+    }
+    return def;
+}
+
+void setField(vector<Field>& fields, const string& key, const string& value) {
+    for (auto& field : fields) {
+        if (field.key == key) {
+            field.value = value;
+            field.isFlag = false;
+            return;
+        }
+    }
+    fields.push_back({key, value, false});
+}
+
+string jsonEscape(const string& str) {
+    string res;
+    res.reserve(str.size() + 2);
+    for (char c : str) {
+        switch (c) {
+            case '"':
+                res += "\\\"";
+                break;
+            case '\\':
+                res += "\\\\";
+                break;
+            case '\n':
+                res += "\\n";
+                break;
+            case '\t':
+                res += "\\t";
+                break;
+            case '\r':
+                res += "\\r";
+                break;
+            default:
+                if ((unsigned char)c < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", (unsigned char)c);
+                    res += buf;
+                } else {
+                    res += c;
+                }
+                break;
+        }
+    }
+    return res;
+}
+
+bool writeLine(int fd, const string& line) {
+    string buf = line + '\n';
+    const char* p = buf.data();
+    size_t size = buf.size();
+    while (size > 0) {
+        ssize_t ret = write(fd, p, size);
+        if (ret <= 0) return false;
+        p += ret;
+        size -= ret;
+    }
+    return true;
+}
+
+bool readLine(int fd, string& buf, string& line) {
+    while (true) {
+        size_t end = buf.find('\n');
+        if (end != string::npos) {
+            line = buf.substr(0, end);
+            buf.erase(0, end + 1);
+            return true;
+        }
+        char chunk[4096];
+        ssize_t ret = read(fd, chunk, sizeof(chunk));
+        if (ret <= 0) {
+            // the last line may be unterminated
+            if (buf.empty()) return false;
+            line.swap(buf);
+            buf.clear();
+            return true;
+        }
+        buf.append(chunk, ret);
+    }
+}
+
+}  // namespace msg
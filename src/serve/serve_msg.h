@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Messages of the server are lines of flat JSON objects (string, number and boolean values only).
+// A request is sent by the client, e.g.,
+//   {"dir":"bin/f01","aux":"design.aux","flow":"tdm_time","out":"f01.tdm","partition":5,"refine":true}
+// where "dir" is the work directory and every other key is a command-line option of larf.
+// The replies are
+//   {"type":"queued"}                                 waiting for a free job slot
+//   {"type":"start","resident":"design:hit timing:miss"}
+//   {"type":"log","line":"..."}                       a line of stdout/stderr of the job
+//   {"type":"done","status":0,"time":1.234}           exit status and wall time of the job
+//   {"type":"error","message":"..."}                  the request is not run
+
+namespace msg {
+
+struct Field {
+    std::string key;
+    std::string value;
+    bool isFlag;  // a boolean true, given as a bare option
+};
+
+bool parseMsg(const std::string& line, std::vector<Field>& fields);
+std::string formatMsg(const std::vector<Field>& fields);
+std::string getField(const std::vector<Field>& fields, const std::string& key, const std::string& def = "");
+void setField(std::vector<Field>& fields, const std::string& key, const std::string& value);
+std::string jsonEscape(const std::string& str);
+
+bool writeLine(int fd, const std::string& line);        // appends '\n'
+bool readLine(int fd, std::string& buf, std::string& line);  // buf keeps the bytes after the line
+
+}  // namespace msg
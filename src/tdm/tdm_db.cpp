@@ -1,3 +1,8 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "tdm_db.h"
 #include "db/db.h"
 #include "db/group.h"
@@ -8,97 +13,574 @@
 vector<int> TdmDB::_xdrChoices;
 TdmDB tdmDatabase;
 
-void TdmDB::init(int nDevice, vector<db::Group>* groups) {
-    _nDevice = nDevice;
-    _groups = groups;
-
+bool TdmDB::init(int nDevice, vector<db::Group>* groups) {
     // gen mapping from inst to device
-    _instToDevice.resize(_groups->size());
-    ifstream instDeviceFile("instance.device");
-    for (unsigned i = 0; i < _groups->size(); i++) {
-        string name;
-        instDeviceFile >> name >> _instToDevice[i];
+    vector<int> instToDevice(groups->size());
+    {
+        PROF_SCOPE("readDevice");
+        ifstream instDeviceFile("instance.device");
+        for (unsigned i = 0; i < groups->size(); i++) {
+            string name;
+            instDeviceFile >> name >> instToDevice[i];
+        }
+        instDeviceFile.close();
     }
-    instDeviceFile.close();
+    return init(nDevice, groups, instToDevice);
+}
+
+bool TdmDB::init(int nDevice, vector<db::Group>* groups, const vector<int>& instToDevice) {
+    _nDevice = nDevice;
+    _groups = groups;
+    _instToDevice = instToDevice;
 
     // gen all the tdm nets
-    getTdmNets(_instToDevice, _nets);
+    {
+        PROF_SCOPE("getTdmNets");
+        getTdmNets(_instToDevice, _nets);
+    }
 
     // gen troncon, xdr var
-    _troncons.resize(_nDevice, vector<Troncon*>(_nDevice, NULL));
-    for (int i = 0; i < _nDevice; i++) {
-        for (int j = i + 1; j < _nDevice; j++) {
-            _troncons[i][j] = new Troncon(i, j, _tronconLimit);
+    if (!buildTroncons()) return false;
+    prof::count("nets", _nets.size());
+    prof::count("troncons", _nTroncon);
+
+    // gen xdr choices
+    _xdrChoices = {1};
+    for (int i = 1; i * 8 <= _maxChoice; i++) _xdrChoices.push_back(i * 8);
+
+    // gen xdrVar need to be optimized
+    selectOptXdrVars();
+
+    // construct timing graph
+    if (!constructTimingGraph()) return false;
+
+    // report();
+    return true;
+}
+
+bool TdmDB::readBoard(const string& filename, int nDevice) {
+    ifstream fs(filename);
+    if (!fs.good()) {
+        printlog(LOG_ERROR, "Cannot open %s to read", filename.c_str());
+        return false;
+    }
+    vector<array<int, 3>> boardWires;
+    unordered_set<long> pairs;
+    int boardDefault = -1;
+    string line;
+    for (int lineNo = 1; getline(fs, line); lineNo++) {
+        istringstream ss(line.substr(0, line.find('#')));
+        string first;
+        if (!(ss >> first)) continue;
+        int wires;
+        if (first == "default") {
+            if (!(ss >> wires) || wires < 0) {
+                printlog(LOG_ERROR, "%s:%d: invalid default", filename.c_str(), lineNo);
+                return false;
+            }
+            boardDefault = wires;
+            continue;
+        }
+        int device1 = atoi(first.c_str()), device2;
+        if (!(ss >> device2 >> wires) || device1 < 0 || device2 < 0 || device1 == device2 || wires < 0) {
+            printlog(LOG_ERROR, "%s:%d: invalid connection", filename.c_str(), lineNo);
+            return false;
+        }
+        if (device1 >= nDevice || device2 >= nDevice) {
+            printlog(LOG_ERROR,
+                     "%s:%d: device of connection %d-%d out of [0, %d)",
+                     filename.c_str(),
+                     lineNo,
+                     device1,
+                     device2,
+                     nDevice);
+            return false;
         }
+        if (!pairs.insert(getTronconKey(device1, device2)).second) {
+            printlog(LOG_ERROR, "%s:%d: duplicate connection %d-%d", filename.c_str(), lineNo, device1, device2);
+            return false;
+        }
+        boardWires.push_back({{device1, device2, wires}});
     }
+    setBoard(boardWires, boardDefault);
+    return true;
+}
+
+void TdmDB::setBoard(const vector<array<int, 3>>& wires, int defaultWires) {
+    _boardWires.clear();
+    for (auto& connection : wires) _boardWires[getTronconKey(connection[0], connection[1])] = connection[2];
+    _boardDefault = defaultWires;
+    _hasBoard = true;
+    printlog(LOG_INFO, "board: #connections=%lu, default=%d", _boardWires.size(), _boardDefault);
+}
+
+// the tdm nets are of the pool of getTdmNets, see clearTdmNets
+void TdmDB::clear() {
+    delete _timingGraph;
+    for (auto var : _xdrVars) delete var;
+    for (auto& pair : _keyToTroncon) delete pair.second;
+    *this = TdmDB();
+}
+
+int TdmDB::getNumWires(int device1, int device2) const {
+    if (!_hasBoard) return _tronconLimit;
+    auto iter = _boardWires.find(getTronconKey(device1, device2));
+    return iter == _boardWires.end() ? _boardDefault : iter->second;
+}
+
+void TdmDB::selectOptXdrVars() {
+    _optXdrVars.clear();
+    _fixedXdrVars.clear();
+    _fixedVals.clear();
+    for (int i = 0; i < _nTroncon; i++) {
+        Troncon* troncon = getTroncon(i);
+        if (troncon->getNumNets() > troncon->_limit) {
+            for (auto net : troncon->getNets()) _optXdrVars.push_back(net->getXdrVar());
+        } else {
+            for (auto net : troncon->getNets()) net->getXdrVar()->setVal(1);
+        }
+    }
+    buildOptTroncons();
+}
+
+void TdmDB::buildOptTroncons() {
+    _isOptVar.assign(_xdrVars.size(), false);
+    _optTronconIdx.assign(_nTroncon, -1);
+    _optTroncons.clear();
+    for (int i = 0, sz = _optXdrVars.size(); i < sz; i++) {
+        _isOptVar[_optXdrVars[i]->_id] = true;
+        Troncon* troncon = _optXdrVars[i]->getNet()->_troncon;
+        int& idx = _optTronconIdx[troncon->_id];
+        if (idx < 0) {
+            idx = _optTroncons.size();
+            _optTroncons.emplace_back(troncon, vector<int>());
+        }
+        _optTroncons[idx].second.push_back(i);
+    }
+}
+
+int TdmDB::getOptTronconIdx(const Troncon* troncon) const {
+    return troncon && troncon->_id < (int)_optTronconIdx.size() ? _optTronconIdx[troncon->_id] : -1;
+}
+
+// the variables keep their values as a warm start, except for the ones no longer optimized
+void TdmDB::setTronconLimit(int limit) {
+    _tronconLimit = limit;
+    for (int i = 0; i < _nTroncon; i++) getTroncon(i)->_limit = limit;
+    selectOptXdrVars();
+    updateTiming();
+}
+
+// the ratios above the new maximum are clamped to it
+void TdmDB::setMaxChoice(int maxChoice) {
+    _maxChoice = maxChoice;
+    _xdrChoices = {1};
+    for (int i = 1; i * 8 <= _maxChoice; i++) _xdrChoices.push_back(i * 8);
+    for (auto var : _xdrVars) var->setVal(min(var->getVal(), (double)_xdrChoices.back()));
+    updateTiming();
+}
+
+// All the optimized vars at 1 give a lower bound of the period, and all at the max choice the longest paths whatever
+// the solution. A var whose paths (without its own delay) are the same at both bounds has no other optimized var on
+// them, so the largest choice keeping them within the lower bound never makes the period longer. Only the full wires
+// of such vars are fixed, as long as the other vars of the troncon still fit at the max choice; a partial wire is
+// better shared with the optimized vars. A troncon whose other vars then fit at 1 is no longer optimized.
+void TdmDB::presolve() {
+    timer::timer time;
+    int nOptVars = _optXdrVars.size(), nOptTroncons = _optTroncons.size();
+    vector<double> sol;
+    saveSol(sol);
+
+    auto updateBound = [&](double val) {
+        for (auto var : _optXdrVars) var->setVal(val);
+        updateTiming();
+        return getArrivalTime();
+    };
+    // the longest path through an edge, without the tdm delay
+    auto getPath = [&](Edge* edge) {
+        return getArrivalTime() -
+               (edge->_fanout->getRequireTime() - edge->_driver->getArrivalTime() - edge->_constDelay);
+    };
+
+    vector<double> lowPaths(_timingGraph->getNumEdges());  // by edge id
+    double lowAT = updateBound(1);
+    for (auto var : _optXdrVars)
+        for (auto edge : _timingGraph->getEdges(var)) lowPaths[edge->_id] = getPath(edge);
+    double highAT = updateBound(_maxChoice);
+    vector<int> fixedVals(nOptVars, 0);  // 0 if optimized
+    for (int i = 0; i < nOptVars; i++) {
+        double bound = _maxChoice;
+        for (auto edge : _timingGraph->getEdges(_optXdrVars[i])) {
+            double path = lowPaths[edge->_id];
+            if (getPath(edge) > path + 1e-6 * lowAT) bound = 0;
+            if (edge->_tdmCoef > 0) bound = min(bound, (lowAT - path) / edge->_tdmCoef);
+        }
+        if (bound >= getXdrChoice(1)) fixedVals[i] = getFloorChoice(bound);
+    }
+    recoverSol(sol);
+    _presolveBound = lowAT;
+
+    // the vars of a direction fill wires in the order of their choices, each wire at its smallest choice
+    int nReleased = 0;
+    for (auto& optTroncon : _optTroncons) {
+        Troncon* troncon = optTroncon.first;
+        vector<vector<int>> wires;
+        int nFree[2] = {0, 0};  // by direction
+        for (int forward = 0; forward < 2; forward++) {
+            vector<int> vars;
+            for (auto i : optTroncon.second) {
+                if (_optXdrVars[i]->isForward() != (forward == 1)) continue;
+                if (fixedVals[i] == 0)
+                    nFree[forward]++;
+                else
+                    vars.push_back(i);
+            }
+            stable_sort(vars.begin(), vars.end(), [&](int i, int j) { return fixedVals[i] > fixedVals[j]; });
+            for (int i = 0, sz = vars.size(), begin = wires.size(); i < sz; i++) {
+                if ((int)wires.size() == begin || (int)wires.back().size() >= fixedVals[vars[i]])
+                    wires.emplace_back();
+                wires.back().push_back(vars[i]);
+            }
+        }
+        for (auto& wire : wires)
+            for (auto i : wire) fixedVals[i] = fixedVals[wire.back()];
+        for (int w = wires.size() - 1; w >= 0; w--) {
+            if ((int)wires[w].size() == fixedVals[wires[w].back()]) continue;
+            for (auto i : wires[w]) {
+                nFree[_optXdrVars[i]->isForward()]++;
+                fixedVals[i] = 0;
+            }
+            wires.erase(wires.begin() + w);
+        }
+
+        // the free vars need the max choice at least
+        auto getNumWires = [&](int maxChoice) {
+            return (int)wires.size() + (nFree[0] + maxChoice - 1) / maxChoice + (nFree[1] + maxChoice - 1) / maxChoice;
+        };
+        while (!wires.empty() && getNumWires(_maxChoice) > troncon->_limit) {
+            auto wire = min_element(wires.begin(), wires.end(), [&](const vector<int>& a, const vector<int>& b) {
+                return fixedVals[a.back()] < fixedVals[b.back()];
+            });
+            for (auto i : *wire) {
+                nFree[_optXdrVars[i]->isForward()]++;
+                fixedVals[i] = 0;
+            }
+            wires.erase(wire);
+        }
+        if (wires.empty() || getNumWires(1) > troncon->_limit) continue;
+        for (auto i : optTroncon.second) {
+            if (fixedVals[i] != 0) continue;
+            fixedVals[i] = 1;
+            nReleased++;
+        }
+    }
+
+    vector<XdrVar*> optXdrVars;
+    for (int i = 0; i < nOptVars; i++) {
+        XdrVar* var = _optXdrVars[i];
+        if (fixedVals[i] == 0) {
+            optXdrVars.push_back(var);
+        } else {
+            var->setVal(fixedVals[i]);
+            _fixedXdrVars.push_back(var);
+            _fixedVals.push_back(fixedVals[i]);
+        }
+    }
+    _optXdrVars.swap(optXdrVars);
+    buildOptTroncons();
+    updateTiming();
+
+    printlog(LOG_INFO,
+             "presolve: at(low/high)=%.3f/%.3f, #fixedVars=%lu (%d at 1), #optVars=%d->%lu, #optTroncons=%d->%lu, "
+             "time=%.3f",
+             lowAT,
+             highAT,
+             _fixedXdrVars.size(),
+             nReleased,
+             nOptVars,
+             _optXdrVars.size(),
+             nOptTroncons,
+             _optTroncons.size(),
+             time.elapsed());
+}
+
+void TdmDB::checkPresolve() {
+    if (_fixedXdrVars.empty()) return;
+    updateTiming();
+    double at = getArrivalTime();
+    int nMoved = 0, nViolated = 0;
+    for (int i = 0, sz = _fixedXdrVars.size(); i < sz; i++) {
+        XdrVar* var = _fixedXdrVars[i];
+        if (var->getVal() != _fixedVals[i]) nMoved++;
+        for (auto edge : _timingGraph->getEdges(var)) {
+            double slack = edge->_fanout->getRequireTime() - edge->_driver->getArrivalTime() - edge->getDelay();
+            if (at - slack > _presolveBound * (1 + 1e-6)) {
+                nViolated++;
+                break;
+            }
+        }
+    }
+    printlog(nViolated == 0 ? LOG_INFO : LOG_WARN,
+             "presolve check: #fixedVars=%lu, #moved=%d, #beyondBound=%d, at/bound=%.3f/%.3f",
+             _fixedXdrVars.size(),
+             nMoved,
+             nViolated,
+             at,
+             _presolveBound);
+}
+
+double TdmDB::getFixedContUsage(const Troncon* troncon) const {
+    double usage = 0;
+    for (int i = 0, sz = troncon->getNumNets(); i < sz; i++) {
+        XdrVar* var = troncon->getNet(i)->getXdrVar();
+        if (!isOptVar(var)) usage += 1 / var->getVal();
+    }
+    return usage;
+}
+
+int TdmDB::getNumFixedVars(const Troncon* troncon, bool forward, int choice) const {
+    int nVars = 0;
+    for (int i = 0, sz = troncon->getNumNets(); i < sz; i++) {
+        XdrVar* var = troncon->getNet(i)->getXdrVar();
+        if (!isOptVar(var) && var->isForward() == forward && var->getVal() == choice) nVars++;
+    }
+    return nVars;
+}
+
+// troncons of the inter nets (only the pairs of devices with nets, in the order of the pairs), where an inter net
+// keeps its xdr var (if any) and the xdr vars are in the order of _nets
+bool TdmDB::buildTroncons() {
+    for (auto& pair : _keyToTroncon) pair.second->clearNets();
+    _xdrVars.clear();
     for (auto net : _nets) {
         if (net->isInterNet()) {
             int fromDevice = net->getFromDevice();
             int toDevice = net->getToDevice();
 
-            Troncon* troncon = getTroncon(fromDevice, toDevice);
+            Troncon*& troncon = _keyToTroncon[getTronconKey(fromDevice, toDevice)];
+            if (!troncon) {
+                troncon = new Troncon(
+                    min(fromDevice, toDevice), max(fromDevice, toDevice), getNumWires(fromDevice, toDevice));
+            }
             troncon->addNet(net);
 
-            XdrVar* xdrVar = new XdrVar(net, fromDevice < toDevice, _xdrVars.size());
+            XdrVar* xdrVar = net->getXdrVar();
+            if (xdrVar)
+                xdrVar->_id = _xdrVars.size();
+            else
+                xdrVar = new XdrVar(net, fromDevice < toDevice, _xdrVars.size());
             _xdrVars.push_back(xdrVar);
         }
     }
-    for (int i = 0; i < _nDevice; i++) {
-        for (int j = i + 1; j < _nDevice; j++) {
-            if (_troncons[i][j]->getNumNets() > 0) {
-                _troncons[i][j]->_id = _idxToTroncon.size();
-                _idxToTroncon.emplace_back(i, j);
-            } else {
-                delete _troncons[i][j];
-                _troncons[i][j] = NULL;
+
+    _troncons.clear();
+    for (auto iter = _keyToTroncon.begin(); iter != _keyToTroncon.end();) {
+        if (iter->second->getNumNets() > 0) {
+            _troncons.push_back(iter->second);
+            ++iter;
+        } else {
+            delete iter->second;
+            iter = _keyToTroncon.erase(iter);
+        }
+    }
+    sort(_troncons.begin(), _troncons.end(), [](const Troncon* a, const Troncon* b) { return a->_devices < b->_devices; });
+    _nTroncon = _troncons.size();
+
+    bool ok = true;
+    for (int i = 0; i < _nTroncon; i++) {
+        Troncon* troncon = _troncons[i];
+        troncon->_id = i;
+        if (troncon->_limit < 0) {
+            printlog(LOG_ERROR,
+                     "devices %d and %d are not connected on the board, but %d nets are in between",
+                     troncon->_devices.first,
+                     troncon->_devices.second,
+                     troncon->getNumNets());
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+bool TdmDB::applyEco(const string& filename) {
+    timer::timer time;
+    ifstream fs(filename);
+    if (!fs.good()) {
+        printlog(LOG_ERROR, "Cannot open %s", filename.c_str());
+        return false;
+    }
+
+    // the whole file is checked before any move, so that an invalid change leaves the database as it is
+    struct Move {
+        int id;
+        int device;  // -1 for a move of the position
+        double x, y;
+    };
+    vector<Move> moves;
+    string line;
+    for (int lineNo = 1; getline(fs, line); lineNo++) {
+        istringstream ss(line);
+        string type, name;
+        if (!(ss >> type) || type[0] == '#') continue;
+        ss >> name;
+        db::Instance* instance = db::database.getInstance(name);
+        if (instance == NULL) {
+            printlog(LOG_ERROR, "%s:%d: instance not found: %s", filename.c_str(), lineNo, name.c_str());
+            return false;
+        }
+        Move move = {instance->id, -1, 0, 0};
+        if (type == "device") {
+            if (!(ss >> move.device) || move.device < 0 || move.device >= _nDevice) {
+                printlog(LOG_ERROR, "%s:%d: invalid device", filename.c_str(), lineNo);
+                return false;
             }
+        } else if (type == "pos") {
+            if (!(ss >> move.x >> move.y)) {
+                printlog(LOG_ERROR, "%s:%d: invalid position", filename.c_str(), lineNo);
+                return false;
+            }
+        } else {
+            printlog(LOG_ERROR, "%s:%d: unknown change: %s", filename.c_str(), lineNo, type.c_str());
+            return false;
         }
+        moves.push_back(move);
     }
-    _nTroncon = _idxToTroncon.size();
 
-    // gen xdr choices
-    _xdrChoices = {1};
-    for (int i = 1; i * 8 <= _maxChoice; i++) _xdrChoices.push_back(i * 8);
+    // moved instances
+    vector<bool> isDevMoved(_groups->size(), false), isPosMoved(_groups->size(), false);
+    int nDevMoves = 0, nPosMoves = 0;
+    for (auto& move : moves) {
+        if (move.device < 0) {
+            (*_groups)[move.id].x = move.x;
+            (*_groups)[move.id].y = move.y;
+            isPosMoved[move.id] = true;
+            nPosMoves++;
+        } else if (_instToDevice[move.id] != move.device) {
+            _instToDevice[move.id] = move.device;
+            isDevMoved[move.id] = true;
+            nDevMoves++;
+        }
+    }
 
-    // gen xdrVar need to be optimized
+    vector<bool> isNetChanged(db::database.nets.size(), false);
+    for (unsigned i = 0; i < _groups->size(); i++) {
+        if (!isDevMoved[i]) continue;
+        for (auto pin : db::database.instances[i]->pins)
+            if (pin->net) isNetChanged[pin->net->id] = true;
+    }
+
+    // replace the tdm nets of the changed nets in place, so that _nets (and the xdr vars) are in the same order as
+    // of a fresh run, and remember the old xdr values as warm start
+    auto tronconKey = [&](TdmNet* net) { return getTronconKey(net->getFromDevice(), net->getToDevice()); };
+    unordered_set<long> changedTroncons;
+    unordered_map<long, double> oldVals;  // by net id and sink device
+    vector<int> newBeg(db::database.nets.size(), -1);
+    vector<TdmNet*> nets, newNets;
+    nets.reserve(_nets.size());
+    int nOldNets = 0;
+    for (unsigned i = 0; i < _nets.size();) {
+        db::Net* parent = _nets[i]->getParentNet();
+        if (!isNetChanged[parent->id]) {
+            nets.push_back(_nets[i++]);
+            continue;
+        }
+        for (; i < _nets.size() && _nets[i]->getParentNet() == parent; i++, nOldNets++) {
+            TdmNet* net = _nets[i];
+            if (!net->isInterNet()) continue;
+            changedTroncons.insert(tronconKey(net));
+            oldVals[(long)parent->id * _nDevice + net->getToDevice()] = net->getXdrVar()->getVal();
+            delete net->getXdrVar();
+        }
+        newBeg[parent->id] = nets.size();
+        getTdmNets(parent, _instToDevice, nets);
+        for (unsigned j = newBeg[parent->id]; j < nets.size(); j++) {
+            newNets.push_back(nets[j]);
+            if (nets[j]->isInterNet()) changedTroncons.insert(tronconKey(nets[j]));
+        }
+    }
+    _nets.swap(nets);
+
+    if (!buildTroncons()) return false;
+    for (auto net : newNets) {
+        if (!net->isInterNet()) continue;
+        auto iter = oldVals.find((long)net->getParentNet()->id * _nDevice + net->getToDevice());
+        if (iter != oldVals.end()) net->getXdrVar()->setVal(iter->second);
+    }
+
+    // only the changed troncons are optimized, and the others keep their (legal) values
+    int nChangedTroncons = 0;
+    _optXdrVars.clear();
+    _fixedXdrVars.clear();
+    _fixedVals.clear();
     for (int i = 0; i < _nTroncon; i++) {
         Troncon* troncon = getTroncon(i);
+        if (!changedTroncons.count(getTronconKey(troncon->_devices.first, troncon->_devices.second))) continue;
+        nChangedTroncons++;
         if (troncon->getNumNets() > troncon->_limit) {
             for (auto net : troncon->getNets()) _optXdrVars.push_back(net->getXdrVar());
         } else {
             for (auto net : troncon->getNets()) net->getXdrVar()->setVal(1);
         }
     }
-    _isOptVar.assign(_xdrVars.size(), false);
-    for (auto var : _optXdrVars) _isOptVar[var->_id] = true;
-
-    // construct timing graph
-    constructTimingGraph();
+    buildOptTroncons();
+
+    // the timing graph is the same, only the tdm nets and the const delays of the edges change
+    int nPatchedEdges = 0;
+    _timingGraph->resetMapping(_xdrVars.size());
+    for (int e = 0, sz = _timingGraph->getNumEdges(); e < sz; e++) {
+        Edge* edge = _timingGraph->getEdge(e);
+        if (!edge->_net) continue;
+        int netId = edge->_net->getParentNet()->id;
+        if (isNetChanged[netId]) {
+            int device = _instToDevice[edge->_fanout->_instance->id];
+            for (int j = newBeg[netId]; j < (int)_nets.size() && _nets[j]->getParentNet()->id == netId; j++) {
+                if (_nets[j]->getToDevice() == device) {
+                    edge->_net = _nets[j];
+                    break;
+                }
+            }
+        }
+        if (isNetChanged[netId] || isPosMoved[edge->_driver->_instance->id] || isPosMoved[edge->_fanout->_instance->id]) {
+            _timingGraph->updateConstDelay(edge);
+            nPatchedEdges++;
+        }
+        if (edge->_net->isInterNet()) _timingGraph->addMapping(edge->_net->getXdrVar(), edge);
+    }
 
-    // report();
+    printlog(LOG_INFO,
+             "eco: #moves(device/pos)=%d/%d, #tdmNets=-%d/+%d, #changedTroncons=%d, #optVars=%lu, #patchedEdges=%d, "
+             "time=%.3f",
+             nDevMoves,
+             nPosMoves,
+             nOldNets,
+             (int)newNets.size(),
+             nChangedTroncons,
+             _optXdrVars.size(),
+             nPatchedEdges,
+             time.elapsed());
+    return true;
 }
 
 void TdmDB::report() const {
     log() << "---- reprot TdmDB ----" << endl;
 
     int maxXdrNum = INT_MIN, minXdrNum = INT_MAX;
-    for (auto pair : _idxToTroncon) {
-        Troncon* troncon = getTroncon(pair.first, pair.second);
+    for (auto troncon : _troncons) {
         maxXdrNum = max(maxXdrNum, troncon->getNumNets());
         minXdrNum = min(minXdrNum, troncon->getNumNets());
     }
 
     printlog(LOG_INFO,
              "#troncon=%lu, avgXdrNum=%f, maxXdrNum=%d, minXdrNum=%d",
-             _idxToTroncon.size(),
-             _xdrVars.size() * 1.0 / _idxToTroncon.size(),
+             _troncons.size(),
+             _xdrVars.size() * 1.0 / _troncons.size(),
              maxXdrNum,
              minXdrNum);
 
     int nOptimalTroncon = 0;
     for (int i = 0; i < _nTroncon; i++)
         if (getTroncon(i)->getNumNets() <= getTroncon(i)->_limit) nOptimalTroncon++;
-    printlog(LOG_INFO, "active_troncon=%d, varNeedOpt=%lu", _idxToTroncon.size() - nOptimalTroncon, _optXdrVars.size());
+    printlog(LOG_INFO, "active_troncon=%d, varNeedOpt=%lu", _nTroncon - nOptimalTroncon, _optXdrVars.size());
 
     _timingGraph->report();
     reportTronconUsage();
@@ -121,33 +603,108 @@ void TdmDB::reportSol() {
 
 Troncon* TdmDB::getTroncon(XdrVar* xdrVar) const { return getTroncon(xdrVar->getNet()); }
 
-Troncon* TdmDB::getTroncon(TdmNet* tdmNet) const { return getTroncon(tdmNet->getFromDevice(), tdmNet->getToDevice()); }
+Troncon* TdmDB::getTroncon(TdmNet* tdmNet) const { return tdmNet->_troncon; }
 
-void TdmDB::constructTimingGraph() {
-    _timingGraph = new TimingGraph();
-    for (auto& group : *_groups) {
-        _timingGraph->addNode(group.instances[0]);
-    }
+Troncon* TdmDB::getTroncon(int device1, int device2) const {
+    auto iter = _keyToTroncon.find(getTronconKey(device1, device2));
+    return iter == _keyToTroncon.end() ? NULL : iter->second;
+}
 
-    for (auto net : _nets) {
-        db::Instance* driver = net->getPin(net->getDriverIdx())->instance;
+bool TdmDB::constructTimingGraph() {
+    PROF_SCOPE("constructTimingGraph");
+    timer::timer time;
+    double stepTime[6];
+    int nNets = _nets.size();
+
+    // distinct fanout instances of each net, sorted by id
+    vector<int> sinkOffsets(nNets + 1, 0);
+    for (int i = 0; i < nNets; i++) sinkOffsets[i + 1] = sinkOffsets[i] + _nets[i]->getNumPins();
+    vector<int> sinks(sinkOffsets[nNets]);
+    vector<int> nSinks(nNets);
+    {
+        PROF_SCOPE("collectSinks");
+        parallelFor(nNets, setting.nThreads, 1024, [&](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                TdmNet* net = _nets[i];
+                int driver = net->getPin(net->getDriverIdx())->instance->id;
+                int* ids = sinks.data() + sinkOffsets[i];
+                int n = 0;
+                for (auto pin : net->getPins())
+                    if (pin->instance->id != driver) ids[n++] = pin->instance->id;
+                sort(ids, ids + n);
+                nSinks[i] = unique(ids, ids + n) - ids;
+            }
+        });
+    }
+    stepTime[0] = time.elapsed();
+
+    {
+        PROF_SCOPE("addEdges");
+        int nEdges = 0;
+        vector<int> nFanouts(_groups->size(), 0), nDrivers(_groups->size(), 0);
+        for (int i = 0; i < nNets; i++) {
+            nEdges += nSinks[i];
+            nFanouts[_nets[i]->getPin(_nets[i]->getDriverIdx())->instance->id] += nSinks[i];
+            for (int j = 0; j < nSinks[i]; j++) nDrivers[sinks[sinkOffsets[i] + j]]++;
+        }
 
-        set<db::Instance*> instances;
-        for (auto pin : net->getPins()) instances.insert(pin->instance);
+        // pseudo nodes of breakCycle, source and sink
+        _timingGraph = new TimingGraph();
+        _timingGraph->reserve(2 * _groups->size() + 2, nEdges + 2 * _groups->size(), _xdrVars.size());
+        for (auto& group : *_groups) {
+            Node* node = _timingGraph->addNode(group.instances[0]);
+            node->_fanouts.reserve(nFanouts[node->_id]);
+            node->_drivers.reserve(nDrivers[node->_id]);
+        }
 
-        for (auto instance : instances) {
-            if (instance == driver) continue;
-            Edge* edge = _timingGraph->addEdge(driver->id, instance->id, net);
+        for (int i = 0; i < nNets; i++) {
+            TdmNet* net = _nets[i];
+            int driver = net->getPin(net->getDriverIdx())->instance->id;
+            for (int j = 0; j < nSinks[i]; j++) {
+                Edge* edge = _timingGraph->addEdge(driver, sinks[sinkOffsets[i] + j], net);
+                if (net->isInterNet()) _timingGraph->addMapping(net->getXdrVar(), edge);
+            }
+        }
+    }
+    stepTime[1] = time.elapsed();
 
-            if (net->isInterNet()) _timingGraph->addMapping(net->getXdrVar(), edge);
+    {
+        PROF_SCOPE("breakCycle");
+        _timingGraph->breakCycle();
+    }
+    stepTime[2] = time.elapsed();
+    {
+        PROF_SCOPE("setConstDelay");
+        _timingGraph->setConstDelay();
+        _timingGraph->setSrcSink();
+    }
+    stepTime[3] = time.elapsed();
+    {
+        PROF_SCOPE("levelize");
+        if (!_timingGraph->levelize()) {
+            printlog(LOG_ERROR, "cannot remove all cycle by breaking the current set of instances");
+            return false;
         }
     }
+    stepTime[4] = time.elapsed();
+    {
+        PROF_SCOPE("removeAbnEdges");
+        _timingGraph->removeAbnEdges();
+    }
+    stepTime[5] = time.elapsed();
 
-    _timingGraph->breakCycle();
-    _timingGraph->setConstDelay();
-    _timingGraph->setSrcSink();
-    _timingGraph->levelize();
-    _timingGraph->removeAbnEdges();
+    printlog(LOG_INFO,
+             "timing graph: #nodes=%d, #edges=%d, time: sinks/edges/breakCycle/delay/levelize/abnEdges="
+             "%.3f/%.3f/%.3f/%.3f/%.3f/%.3f",
+             _timingGraph->getNumNodes(),
+             _timingGraph->getNumEdges(),
+             stepTime[0],
+             stepTime[1] - stepTime[0],
+             stepTime[2] - stepTime[1],
+             stepTime[3] - stepTime[2],
+             stepTime[4] - stepTime[3],
+             stepTime[5] - stepTime[4]);
+    return true;
 }
 
 void TdmDB::updateTiming() {
@@ -290,12 +847,7 @@ void TdmDB::reportTdmAssignment() const {
 bool TdmDB::isOptVar(XdrVar* xdrVar) const { return isOptVar(xdrVar->_id); }
 
 void TdmDB::checkFeasibility(int& nChoice) {
-    map<Troncon*, vector<int>> tronconToXdrVar;
-    for (int i = 0, sz = _optXdrVars.size(); i < sz; i++) {
-        Troncon* troncon = _optXdrVars[i]->getNet()->_troncon;
-        tronconToXdrVar[troncon].push_back(i);
-    }
-    for (auto& pair : tronconToXdrVar) {
+    for (auto& pair : _optTroncons) {
         int numForwVars = 0, numBackVars = 0;
         for (auto i : pair.second) {
             if (_optXdrVars[i]->isForward())
@@ -317,7 +869,7 @@ void TdmDB::checkFeasibility(int& nChoice) {
                      backUsage,
                      limit);
             int idx = nChoice - 1;
-            for (; nChoice * 8 <= 1600; nChoice++) {
+            for (; nChoice * 8 <= _maxChoice; nChoice++) {
                 _xdrChoices.push_back(nChoice * 8);
                 forwUsage = ceil(numForwVars * 1.0 / _xdrChoices[nChoice]);
                 backUsage = ceil(numBackVars * 1.0 / _xdrChoices[nChoice]);
@@ -333,13 +885,7 @@ void TdmDB::checkFeasibility(int& nChoice) {
 
 void TdmDB::reportTronconUsage() const {
     log() << "---- report troncon vars ----" << endl;
-    map<Troncon*, vector<int>> tronconToXdrVar;
-    for (int i = 0, sz = _optXdrVars.size(); i < sz; i++) {
-        Troncon* troncon = _optXdrVars[i]->getNet()->_troncon;
-        tronconToXdrVar[troncon].push_back(i);
-    }
-
-    for (auto& pair : tronconToXdrVar) {
+    for (auto& pair : _optTroncons) {
         int numForwVars = 0, numBackVars = 0;
         for (auto i : pair.second) {
             if (_optXdrVars[i]->isForward())
@@ -369,18 +915,136 @@ void TdmDB::recoverSol(vector<double>& sol) {
     for (int i = 0, sz = _xdrVars.size(); i < sz; i++) _xdrVars[i]->setVal(sol[i]);
 }
 
-void TdmDB::writeSol(string filename) const {
-    ofstream file(filename);
-    for (int i = 0, sz = _xdrVars.size(); i < sz; i++) file << _xdrVars[i]->getVal() << endl;
-    file.close();
+// binary solution: header, XDR choices, then one double per XDR var
+struct TdmSolHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t nChoices;
+    uint64_t nVars;
+    uint64_t fingerprint;
+};
+
+const char TdmSolMagic[8] = {'L', 'A', 'R', 'F', 'S', 'O', 'L', '\0'};
+
+// FNV-1a over the XDR vars (net, devices) and the timing graph size, so that a solution is not read into another
+// design or partition
+uint64_t TdmDB::getFingerprint() const {
+    uint64_t hash = 14695981039346656037ULL;
+    auto add = [&](const void* data, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            hash ^= ((const unsigned char*)data)[i];
+            hash *= 1099511628211ULL;
+        }
+    };
+    int nNodes = _timingGraph->getNumNodes(), nEdges = _timingGraph->getNumEdges();
+    add(&_nDevice, sizeof(_nDevice));
+    add(&nNodes, sizeof(nNodes));
+    add(&nEdges, sizeof(nEdges));
+    for (auto var : _xdrVars) {
+        TdmNet* net = var->getNet();
+        string name = net->getName();
+        int devices[2] = {net->getFromDevice(), net->getToDevice()};
+        add(name.data(), name.size());
+        add(devices, sizeof(devices));
+    }
+    return hash;
+}
+
+void TdmDB::writeSol(string filename, bool text) const {
+    FILE* fp = fopen(filename.c_str(), "wb");
+    if (fp == NULL) {
+        printlog(LOG_ERROR, "Cannot open %s to write", filename.c_str());
+        return;
+    }
+
+    vector<char> buf;
+    if (text) {
+        // same format as ostream << double
+        buf.resize(_xdrVars.size() * 16);
+        size_t len = 0;
+        for (auto var : _xdrVars) {
+            if (buf.size() - len < 32) buf.resize(buf.size() * 2);
+            len += snprintf(buf.data() + len, buf.size() - len, "%g\n", var->getVal());
+        }
+        buf.resize(len);
+    } else {
+        TdmSolHeader header;
+        memcpy(header.magic, TdmSolMagic, sizeof(TdmSolMagic));
+        header.version = 1;
+        header.nChoices = _xdrChoices.size();
+        header.nVars = _xdrVars.size();
+        header.fingerprint = getFingerprint();
+        size_t choiceBytes = header.nChoices * sizeof(int32_t);
+        buf.resize(sizeof(header) + choiceBytes + header.nVars * sizeof(double));
+        memcpy(buf.data(), &header, sizeof(header));
+        int32_t* choices = (int32_t*)(buf.data() + sizeof(header));
+        for (unsigned i = 0; i < header.nChoices; i++) choices[i] = _xdrChoices[i];
+        double* vals = (double*)(buf.data() + sizeof(header) + choiceBytes);
+        for (unsigned i = 0; i < header.nVars; i++) vals[i] = _xdrVars[i]->getVal();
+    }
+
+    if (fwrite(buf.data(), 1, buf.size(), fp) != buf.size()) printlog(LOG_ERROR, "Cannot write %s", filename.c_str());
+    fclose(fp);
 }
 
-void TdmDB::readSol(string filename) {
-    ifstream file(filename);
-    for (int i = 0, sz = _xdrVars.size(); i < sz; i++) {
-        double val;
-        file >> val;
-        _xdrVars[i]->setVal(val);
+bool TdmDB::readSol(string filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) close(fd);
+        printlog(LOG_ERROR, "Cannot open %s to read", filename.c_str());
+        return false;
+    }
+    size_t size = st.st_size;
+    const char* data = NULL;
+    if (size > 0) {
+        void* addr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) data = (const char*)addr;
+    }
+    close(fd);
+    if (data == NULL) {
+        printlog(LOG_ERROR, "Cannot read %s", filename.c_str());
+        return false;
+    }
+
+    bool ok = true;
+    if (size >= sizeof(TdmSolHeader) && memcmp(data, TdmSolMagic, sizeof(TdmSolMagic)) == 0) {
+        TdmSolHeader header;
+        memcpy(&header, data, sizeof(header));
+        size_t choiceBytes = header.nChoices * sizeof(int32_t);
+        if (header.version != 1 || size != sizeof(header) + choiceBytes + header.nVars * sizeof(double)) {
+            printlog(LOG_ERROR, "%s is corrupted", filename.c_str());
+            ok = false;
+        } else if (header.nVars != _xdrVars.size() || header.fingerprint != getFingerprint()) {
+            printlog(LOG_ERROR, "%s is a solution of another design or partition", filename.c_str());
+            ok = false;
+        } else {
+            const int32_t* choices = (const int32_t*)(data + sizeof(header));
+            if (header.nChoices != _xdrChoices.size() || !equal(_xdrChoices.begin(), _xdrChoices.end(), choices))
+                printlog(LOG_WARN, "%s is solved with different XDR choices", filename.c_str());
+            const char* vals = data + sizeof(header) + choiceBytes;
+            for (unsigned i = 0; i < header.nVars; i++) {
+                double val;
+                memcpy(&val, vals + i * sizeof(double), sizeof(double));
+                _xdrVars[i]->setVal(val);
+            }
+        }
+    } else {
+        // text, one value per line
+        string text(data, size);
+        const char* ptr = text.c_str();
+        for (int i = 0, sz = _xdrVars.size(); i < sz && ok; i++) {
+            char* end;
+            double val = strtod(ptr, &end);
+            if (end == ptr) {
+                printlog(LOG_ERROR, "%s has %d of %d values", filename.c_str(), i, sz);
+                ok = false;
+            } else {
+                _xdrVars[i]->setVal(val);
+                ptr = end;
+            }
+        }
     }
-    file.close();
+    munmap((void*)data, size);
+    return ok;
 }
@@ -3,7 +3,9 @@
 #include "global.h"
 
 class TdmNet;
-class TimingGraph;
+template <typename T>
+class TimingGraphT;
+using TimingGraph = TimingGraphT<double>;
 class XdrVar;
 class Troncon;
 
@@ -13,17 +15,41 @@ class Group;
 
 class TdmDB {
 public:
-    void init(int nDevice, vector<db::Group> *groups);
+    bool init(int nDevice, vector<db::Group> *groups);  // false if devices without wires in between share a net
+    bool init(int nDevice, vector<db::Group> *groups, const vector<int> &instToDevice);  // devices not of a file
+    void clear();  // frees the troncons, the xdr vars and the timing graph for another design
+    // wires between pairs of devices ("<device1> <device2> <wires>", and "default <wires>" for the unlisted pairs),
+    // otherwise every pair has the default limit
+    bool readBoard(const string &filename, int nDevice);
+    void setBoard(const vector<array<int, 3>> &wires, int defaultWires);  // by {device1, device2, wires}, -1 if none
+    // move instances to other devices/positions by a delta file ("device <inst> <device>" or "pos <inst> <x> <y>"),
+    // only the changed troncons are re-optimized starting from the current solution; the moves are not written back
+    // to instance.device and instance.pos, so a delta is cumulative against them
+    bool applyEco(const string &filename);
 
     void updateTiming();
     double getArrivalTime() const;
     TimingGraph *getTimingGraph() const { return _timingGraph; }
 
+    // what-if scenarios, the troncons within the limit get ratio 1 and the others are optimized
+    void setTronconLimit(int limit);  // of all troncons, overriding the board
+    void setMaxChoice(int maxChoice);
+    int getTronconLimit() const { return _tronconLimit; }
+    bool hasBoard() const { return _hasBoard; }
+    int getMaxChoice() const { return _maxChoice; }
+
+    // fix the optimized vars that cannot make the period longer than its lower bound (all the ratios at 1), found by
+    // timing at both bounds of the ratios, the others stay optimized
+    void presolve();
+    void checkPresolve();  // whether the fixed vars kept their values and their paths stay within the bound
+    // the vars of a troncon that are not optimized: their usage, and their count in a direction at a choice
+    double getFixedContUsage(const Troncon *troncon) const;
+    int getNumFixedVars(const Troncon *troncon, bool forward, int choice) const;
+
+    int getNumDevices() const { return _nDevice; }
     int getNumTroncon() const { return _nTroncon; }
-    Troncon *getTroncon(int i) const { return getTroncon(_idxToTroncon[i].first, _idxToTroncon[i].second); }
-    Troncon *getTroncon(int device1, int device2) const {
-        return _troncons[min(device1, device2)][max(device1, device2)];
-    }
+    Troncon *getTroncon(int i) const { return _troncons[i]; }
+    Troncon *getTroncon(int device1, int device2) const;  // NULL if no net is in between
     Troncon *getTroncon(XdrVar *xdrVar) const;
     Troncon *getTroncon(TdmNet *tdmNet) const;
 
@@ -37,6 +63,9 @@ public:
     vector<XdrVar *> &getXdrVars() { return _xdrVars; }
     vector<XdrVar *> &getOptXdrVars() { return _optXdrVars; }
     bool isOptVar(XdrVar *xdrVar) const;
+    // the troncons of the optimized vars, each with the indices of its vars in getOptXdrVars()
+    vector<pair<Troncon *, vector<int>>> &getOptTroncons() { return _optTroncons; }
+    int getOptTronconIdx(const Troncon *troncon) const;  // in getOptTroncons(), -1 if it has no optimized var
 
     static vector<int> &getXdrChoices() { return _xdrChoices; }
     static int getXdrChoice(int i) { return _xdrChoices[i]; }
@@ -59,28 +88,46 @@ public:
 
     void saveSol(vector<double> &sol) const;
     void recoverSol(vector<double> &sol);
-    void writeSol(string filename) const;
-    void readSol(string filename);
+    void writeSol(string filename, bool text = false) const;  // binary unless text is requested
+    bool readSol(string filename);                            // binary (checked against the design) or text
 
 private:
-    void constructTimingGraph();
+    static long getTronconKey(int device1, int device2) {
+        return ((long)min(device1, device2) << 32) | max(device1, device2);
+    }
+    int getNumWires(int device1, int device2) const;  // -1 if not connected
+    bool buildTroncons();
+    void selectOptXdrVars();
+    void buildOptTroncons();
+    bool constructTimingGraph();  // false if the cycles cannot be broken
+    uint64_t getFingerprint() const;
     bool isOptVar(int idx) const { return _isOptVar[idx]; };
 
-    int _nDevice;
-    int _nTroncon;
+    int _nDevice = 0;
+    int _nTroncon = 0;
     vector<int> _instToDevice;
     vector<TdmNet *> _nets;
-    vector<db::Group> *_groups;
-    TimingGraph *_timingGraph;
+    vector<db::Group> *_groups = NULL;
+    TimingGraph *_timingGraph = NULL;
     vector<XdrVar *> _xdrVars;
     vector<XdrVar *> _optXdrVars;
     vector<bool> _isOptVar;
-    vector<vector<Troncon *>> _troncons;
-    vector<pair<int, int>> _idxToTroncon;
+    vector<Troncon *> _troncons;                   // with nets, by device pair
+    unordered_map<long, Troncon *> _keyToTroncon;  // by getTronconKey
+    vector<pair<Troncon *, vector<int>>> _optTroncons;
+    vector<int> _optTronconIdx;  // by troncon id
+    vector<XdrVar *> _fixedXdrVars;  // by presolve
+    vector<int> _fixedVals;
+    double _presolveBound = 0;  // the period at all the optimized vars at 1, the paths of the fixed vars stay within
+
+    // board
+    unordered_map<long, int> _boardWires;  // by getTronconKey
+    int _boardDefault = -1;
+    bool _hasBoard = false;
 
     static vector<int> _xdrChoices;
-    const int _tronconLimit = 20;
-    const int _maxChoice = 1600;
+    int _tronconLimit = 20;
+    int _maxChoice = 1600;
 };
 
 class XdrVar {
@@ -103,6 +150,7 @@ private:
 class Troncon {
 public:
     void addNet(TdmNet *net);
+    void clearNets() { _nets.clear(); }
     TdmNet *getNet(int i) const { return _nets[i]; }
     int getNumNets() const { return _nets.size(); }
     vector<TdmNet *> &getNets() { return _nets; }
@@ -3,17 +3,14 @@
 #include "tdm_net.h"
 #include "timing_graph.h"
 
-TdmLegalize::TdmLegalize() : _optXdrVars(tdmDatabase.getOptXdrVars()) {
-    _flow = setting.lg;
-    _timingGraph = tdmDatabase.getTimingGraph();
-    for (unsigned i = 0; i < _optXdrVars.size(); i++) {
-        _varToOptIdx[_optXdrVars[i]] = i;
-        Troncon *troncon = _optXdrVars[i]->getNet()->_troncon;
-        _tronconToXdrVar[troncon].push_back(i);
-    }
+const double bndEps = 1e-6;  // tolerance of a max displacement bound
 
-    int cnt = 0;
-    for (auto &pair : _tronconToXdrVar) _tronconToIdx[pair.first] = cnt++;
+TdmLegalize::TdmLegalize()
+    : _timingGraph(tdmDatabase.getTimingGraph()),
+      _optXdrVars(tdmDatabase.getOptXdrVars()),
+      _tronconToXdrVar(tdmDatabase.getOptTroncons()) {
+    _flow = setting.lg;
+    for (unsigned i = 0; i < _optXdrVars.size(); i++) _varToOptIdx[_optXdrVars[i]] = i;
 }
 
 void TdmLegalize::solve(bool writeDB, vector<double> *result) {
@@ -30,6 +27,7 @@ void TdmLegalize::solve(bool writeDB, vector<double> *result) {
     double begAT = tdmDatabase.getArrivalTime();
 
     updateWireData();
+    prof::count("troncons", _wireData.size());
 
     sort(_wireData.begin(), _wireData.end(), [&](const WireData &data1, const WireData &data2) {
         return data1._vars.size() > data2._vars.size();
@@ -40,17 +38,9 @@ void TdmLegalize::solve(bool writeDB, vector<double> *result) {
     double avgMaxDisp = 0;
 
     std::mutex idx_mutex;
-    int vIdx = 0;
-    auto threadFunc = [&]() {
-        while (true) {
-            int idx;
-            idx_mutex.lock();
-            idx = vIdx++;
-            idx_mutex.unlock();
-
-            if (idx >= (int)_wireData.size()) break;
-
-            auto data = _wireData[idx];
+    parallelFor(_wireData.size(), setting.nThreads, 1, [&](int begin, int end) {
+        for (int idx = begin; idx < end; idx++) {
+            auto &data = _wireData[idx];
 
             double choiceVio = tdmDatabase.getChoiceVio(data._troncon);
             double limitVio = tdmDatabase.getContLimitVio(data._troncon);
@@ -86,12 +76,7 @@ void TdmLegalize::solve(bool writeDB, vector<double> *result) {
             //          data._maxDisp);
             idx_mutex.unlock();
         }
-    };
-
-    int nThreads = max(1, setting.nThreads);
-    std::thread threads[nThreads];
-    for (int i = 0; i < nThreads; i++) threads[i] = std::thread(threadFunc);
-    for (int i = 0; i < nThreads; i++) threads[i].join();
+    });
 
     tdmDatabase.updateTiming();
     double endAT = tdmDatabase.getArrivalTime();
@@ -130,12 +115,15 @@ void WireData::sortByDisp() {
 
 void TdmLegalize::updateWireData() {
     _wireData.resize(_tronconToXdrVar.size());
-    for (auto &pair : _tronconToXdrVar) {
-        Troncon *troncon = pair.first;
-        int idx = _tronconToIdx[troncon];
-
-        _wireData[idx]._troncon = troncon;
-        for (auto var : pair.second) _wireData[idx]._vars.push_back(new OneWireData(_optXdrVars[var]));
+    for (unsigned idx = 0; idx < _tronconToXdrVar.size(); idx++) {
+        _wireData[idx]._troncon = _tronconToXdrVar[idx].first;
+        for (auto var : _tronconToXdrVar[idx].second) _wireData[idx]._vars.push_back(new OneWireData(_optXdrVars[var]));
+        // the fixed vars (see TdmDB::presolve) share the wires with the optimized ones
+        Troncon *troncon = _wireData[idx]._troncon;
+        for (auto net : troncon->getNets()) {
+            XdrVar *var = net->getXdrVar();
+            if (!tdmDatabase.isOptVar(var)) _wireData[idx]._vars.push_back(new OneWireData(var));
+        }
     }
 
     for (auto &data : _wireData) data.sortVars(_flow);
@@ -401,7 +389,7 @@ double WireData::legalizeTronconDispPrune(unsigned idx,
     int bestChoice = -1;
     int bestEndIdx = -1;
 
-    if (getMinWireRequire(idx, choiceRanges) > p) {
+    if (minWire[idx] > p) {
         memorization.saveBest(idx, p, bestCost, bestChoice, bestEndIdx);
         return bestCost;
     }
@@ -462,54 +450,91 @@ double WireData::legalizeTronconDispPrune(unsigned idx,
     return bestCost;
 }
 
+void WireData::setChoiceRanges(double bnd, vector<pair<int, int>> &choiceRanges) const {
+    choiceRanges.resize(_vars.size());
+    for (int i = 0, sz = _vars.size(); i < sz; i++) {
+        choiceRanges[i].first = TdmDB::getCeilChoiceIdx(_vars[i]->getVal() - bnd - bndEps);
+        choiceRanges[i].second = TdmDB::getFloorChoiceIdx(_vars[i]->getVal() + bnd + bndEps);
+    }
+}
+
+// calcEndIdx(i, the largest choice of var i) for all i by two pointers, as the vars are sorted by value in each
+// direction and so are the ends of their choice ranges
+void WireData::calcGreedyEnds(const vector<pair<int, int>> &choiceRanges, vector<int> &ends) const {
+    ends.resize(_vars.size());
+    int groupEnds[2] = {(int)_numForwardVars, (int)_vars.size()};
+    for (int g = 0, beg = 0; g < 2; beg = groupEnds[g++]) {
+        // j: the first var after i that cannot take the largest choice of i
+        for (int i = beg, j = beg; i < groupEnds[g]; i++) {
+            j = max(j, i + 1);
+            while (j < groupEnds[g] && choiceRanges[j].first <= choiceRanges[i].second) j++;
+            ends[i] = min(j, i + TdmDB::getXdrChoice(choiceRanges[i].second));
+        }
+    }
+}
+
 double WireData::legalizeTronconMaxDisp(Memorization &memorization) const {
+    int nVars = _vars.size();
     double maxMinDisp = 0;
     for (auto var : _vars) {
         maxMinDisp = max(maxMinDisp, abs(TdmDB::getClosestChoice(var->getVal()) - var->getVal()));
     }
 
-    double bnd = maxMinDisp;
-    double loBnd = maxMinDisp;
-    double hiBnd = -1;
-
-    vector<int> minWire(_vars.size(), 0);
+    vector<pair<int, int>> choiceRanges;
+    vector<int> ends;
+    auto isFeasible = [&](double bnd) {
+        setChoiceRanges(bnd, choiceRanges);
+        calcGreedyEnds(choiceRanges, ends);
+        int nWires = 0;
+        for (int i = 0; i < nVars; i = ends[i]) nWires++;
+        return nWires <= _troncon->_limit;
+    };
 
-    while (true) {
-        vector<pair<int, int>> choiceRanges(_vars.size());
-        for (int i = 0, sz = _vars.size(); i < sz; i++) {
-            choiceRanges[i].first = TdmDB::getCeilChoiceIdx(_vars[i]->getVal() - bnd);
-            choiceRanges[i].second = TdmDB::getFloorChoiceIdx(_vars[i]->getVal() + bnd);
+    // exponential search for a feasible bound, then binary search over the breakpoints |val - choice| in between,
+    // which are the only bounds where the choice ranges change
+    double loBnd = maxMinDisp;
+    double hiBnd = maxMinDisp;
+    double maxBnd = TdmDB::getXdrChoices().back();  // all choices are in range
+    if (!isFeasible(hiBnd)) {
+        while (hiBnd < maxBnd) {
+            loBnd = hiBnd;
+            hiBnd = min(maxBnd, max(hiBnd * 2, 1.0));
+            if (isFeasible(hiBnd)) break;
         }
 
-        if (getMinWireRequire(0, choiceRanges) > _troncon->_limit) {
-            loBnd = bnd;
-            if (hiBnd == -1) {
-                bnd = bnd * 2;
-            } else {
-                bnd = (bnd + hiBnd) / 2;
+        vector<double> cands;
+        for (auto var : _vars) {
+            double val = var->getVal();
+            int candBeg = TdmDB::getCeilChoiceIdx(val - hiBnd), candEnd = TdmDB::getFloorChoiceIdx(val + hiBnd);
+            for (int c = candBeg; c <= candEnd; c++) {
+                double disp = abs(val - TdmDB::getXdrChoice(c));
+                if (disp > loBnd && disp < hiBnd) cands.push_back(disp);
             }
-        } else {
-            if (abs(loBnd - hiBnd) < 0.01) break;
-
-            hiBnd = bnd;
-            bnd = (loBnd + hiBnd) / 2;
         }
+        sort(cands.begin(), cands.end());
+        cands.erase(unique(cands.begin(), cands.end()), cands.end());
+
+        int lo = 0, hi = cands.size();  // the first feasible candidate is in [lo, hi], hi for hiBnd
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (isFeasible(cands[mid]))
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        if (hi < (int)cands.size()) hiBnd = cands[hi];
     }
 
-    vector<pair<int, int>> choiceRanges(_vars.size());
-    for (int i = 0, sz = _vars.size(); i < sz; i++) {
-        choiceRanges[i].first = TdmDB::getCeilChoiceIdx(_vars[i]->getVal() - hiBnd);
-        choiceRanges[i].second = TdmDB::getFloorChoiceIdx(_vars[i]->getVal() + hiBnd);
-    }
-
-    for (unsigned i = 0; i < _vars.size(); i++) {
-        minWire[i] = getMinWireRequire(i, choiceRanges);
-    }
+    // the min number of wires from each var
+    setChoiceRanges(hiBnd, choiceRanges);
+    calcGreedyEnds(choiceRanges, ends);
+    vector<int> minWire(nVars + 1, 0);
+    for (int i = nVars - 1; i >= 0; i--) minWire[i] = minWire[ends[i]] + 1;
 
-    for (int i = 0, sz = _vars.size(); i < sz; i++) {
+    for (int i = 0; i < nVars; i++) {
         double val = _vars[i]->getVal();
-        assert(abs(val - TdmDB::getXdrChoice(choiceRanges[i].first)) <= hiBnd);
-        assert(abs(val - TdmDB::getXdrChoice(choiceRanges[i].second)) <= hiBnd);
+        assert(abs(val - TdmDB::getXdrChoice(choiceRanges[i].first)) <= hiBnd + bndEps);
+        assert(abs(val - TdmDB::getXdrChoice(choiceRanges[i].second)) <= hiBnd + bndEps);
     }
 
     return legalizeTronconDispPrune(0, _troncon->_limit, memorization, choiceRanges, minWire);
@@ -534,7 +559,7 @@ void WireData::dumpSol(vector<double> &result,
         int choice = memorization.getBestChoice(i, limit);
         for (int j = i; j < endIdx; j++) {
             const auto iter = varToOptIdx.find(_vars[j]->_var);
-            result[iter->second] = choice;
+            if (iter != varToOptIdx.end()) result[iter->second] = choice;
         }
         i = endIdx;
         limit--;
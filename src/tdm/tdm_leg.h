@@ -3,16 +3,22 @@
 #include "global.h"
 
 class TdmDB;
-class Edge;
+template <typename T>
+class EdgeT;
+using Edge = EdgeT<double>;
 class Troncon;
 class XdrVar;
-class TimingGraph;
+template <typename T>
+class TimingGraphT;
+using TimingGraph = TimingGraphT<double>;
 
 class Memorization;
 class TdmLegalize;
 class WireData;
 
 class TdmLegalize {
+    friend class TdmBench;
+
 public:
     TdmLegalize();
     void solve(bool writeDB = true, vector<double> *result = NULL);
@@ -21,8 +27,7 @@ private:
     TimingGraph *_timingGraph;
     vector<XdrVar *> &_optXdrVars;
 
-    map<Troncon *, vector<int>> _tronconToXdrVar;
-    map<Troncon *, int> _tronconToIdx;
+    vector<pair<Troncon *, vector<int>>> &_tronconToXdrVar;  // indexed as _wireData
     map<XdrVar *, int> _varToOptIdx;
 
     vector<WireData> _wireData;
@@ -58,6 +63,8 @@ public:
     int calcEndIdx(unsigned idx, int choice, const vector<pair<int, int>> &choiceRanges) const;
     int getMinWireRequire(unsigned idx) const;
     int getMinWireRequire(unsigned idx, const vector<pair<int, int>> &choiceRanges) const;
+    void setChoiceRanges(double bnd, vector<pair<int, int>> &choiceRanges) const;
+    void calcGreedyEnds(const vector<pair<int, int>> &choiceRanges, vector<int> &ends) const;
     void calcDisp(const Memorization &memorization);
     void sortVars(Setting::LgMethod flow);
 
@@ -24,6 +24,7 @@ public:
     int getToDevice() { return _toDeviceIdx; }
     int getNumDevices() { return _fromDeviceIdx == _toDeviceIdx ? 1 : 0; }
 
+    void reservePins(int n) { _pins.reserve(n); }
     void addPins(vector<db::Pin*>& pins);
     void addPin(db::Pin* pin);
     vector<db::Pin*>& getPins();
@@ -32,6 +33,7 @@ public:
     int getNumPins();
 
     string getName();
+    db::Net* getParentNet() { return _parentNet; }
     XdrVar* getXdrVar() { return _xdrVar; }
 
     XdrVar* _xdrVar;
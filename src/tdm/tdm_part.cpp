@@ -5,20 +5,321 @@ using namespace db;
 
 #include "gp/gp.h"
 #include "tdm_net.h"
+#include "timing_graph.h"
+#include "utils/pool.h"
 
-void partition(vector<vector<int>> &clusters, int k) {
+#include <dirent.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+const double partImbal = 0.05;
+
+struct PartResult {
+    int seed;
+    int cut = -1;  // -1 if the run fails
+    double imbal;
+    double time;  // seconds
+    vector<int> partvec;
+    vector<int> partweights;
+};
+
+void runPatoh(int c, int n, int *cwghts, int *nwghts, int *xpins, int *pins, int k, int seed, PartResult &res) {
+    timer::timer time;
+    PaToH_Parameters args;
+    PaToH_Initialize_Parameters(&args, PATOH_CONPART, PATOH_SUGPARAM_QUALITY);
+    args.seed = seed;
+    args._k = k;
+    args.final_imbal = partImbal;
+    res.partvec.resize(c);
+    res.partweights.resize(k);
+    PaToH_Check_User_Parameters(&args, true);
+    PaToH_Alloc(&args, c, n, 1, cwghts, nwghts, xpins, pins);
+    PaToH_Part(&args, c, n, 1, 0, cwghts, nwghts, xpins, pins, NULL, res.partvec.data(), res.partweights.data(), &res.cut);
+    PaToH_Free();
+
+    int totWeight = 0;
+    for (int i = 0; i < c; i++) totWeight += cwghts[i];
+    res.seed = seed;
+    res.imbal = *max_element(res.partweights.begin(), res.partweights.end()) * k / (double)totWeight - 1;
+    res.time = time.elapsed();
+}
+
+bool writeAll(int fd, const void *buf, size_t size) {
+    const char *p = (const char *)buf;
+    while (size > 0) {
+        ssize_t ret = write(fd, p, size);
+        if (ret <= 0) return false;
+        p += ret;
+        size -= ret;
+    }
+    return true;
+}
+
+bool readAll(int fd, void *buf, size_t size) {
+    char *p = (char *)buf;
+    while (size > 0) {
+        ssize_t ret = read(fd, p, size);
+        if (ret <= 0) return false;
+        p += ret;
+        size -= ret;
+    }
+    return true;
+}
+
+// PaToH keeps global state, so concurrent runs are in child processes (at most setting.nThreads at a time),
+// each sending its result back through a pipe
+void runPatohSeeds(
+    int c, int n, int *cwghts, int *nwghts, int *xpins, int *pins, int k, int nSeeds, vector<PartResult> &results) {
+    timer::timer wallTime;
+    results.assign(nSeeds, PartResult());
+    vector<pid_t> pids(nSeeds, -1);
+    vector<int> fds(nSeeds, -1);
+    int nWorkers = max(1, min(setting.nThreads, nSeeds));
+
+    auto launch = [&](int seed) {
+        results[seed].seed = seed;
+        int fd[2];
+        if (pipe(fd) != 0) {
+            printlog(LOG_ERROR, "pipe fails for partition seed %d", seed);
+            return;
+        }
+        cout.flush();
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(fd[0]);
+            PartResult res;
+            runPatoh(c, n, cwghts, nwghts, xpins, pins, k, seed, res);
+            bool ok = writeAll(fd[1], &res.cut, sizeof(res.cut)) && writeAll(fd[1], &res.imbal, sizeof(res.imbal)) &&
+                      writeAll(fd[1], &res.time, sizeof(res.time)) &&
+                      writeAll(fd[1], res.partweights.data(), k * sizeof(int)) &&
+                      writeAll(fd[1], res.partvec.data(), c * sizeof(int));
+            _exit(ok ? 0 : 1);
+        }
+        close(fd[1]);
+        if (pid < 0) {
+            printlog(LOG_ERROR, "fork fails for partition seed %d", seed);
+            close(fd[0]);
+            return;
+        }
+        pids[seed] = pid;
+        fds[seed] = fd[0];
+    };
+
+    int nLaunched = 0;
+    for (; nLaunched < nWorkers; nLaunched++) launch(nLaunched);
+    for (int seed = 0; seed < nSeeds; seed++) {
+        PartResult &res = results[seed];
+        if (fds[seed] >= 0) {
+            res.partweights.resize(k);
+            res.partvec.resize(c);
+            bool ok = readAll(fds[seed], &res.cut, sizeof(res.cut)) && readAll(fds[seed], &res.imbal, sizeof(res.imbal)) &&
+                      readAll(fds[seed], &res.time, sizeof(res.time)) &&
+                      readAll(fds[seed], res.partweights.data(), k * sizeof(int)) &&
+                      readAll(fds[seed], res.partvec.data(), c * sizeof(int));
+            close(fds[seed]);
+            int status;
+            if (waitpid(pids[seed], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) ok = false;
+            if (!ok) {
+                printlog(LOG_ERROR, "partition with seed %d fails", seed);
+                res.cut = -1;
+            }
+        }
+        if (nLaunched < nSeeds) launch(nLaunched++);
+    }
+
+    vector<int> cuts;
+    double serialTime = 0;
+    for (auto &res : results) {
+        if (res.cut < 0) continue;
+        cuts.push_back(res.cut);
+        serialTime += res.time;
+    }
+    if (cuts.empty()) {
+        printlog(LOG_ERROR, "all %d partitions fail", nSeeds);
+        return;
+    }
+    sort(cuts.begin(), cuts.end());
+    double time = wallTime.elapsed();
+    printlog(LOG_INFO,
+             "%d seeds on %d workers: cut min/median/max=%d/%d/%d, time=%.2fs (serial %.2fs, saved %.2fs)",
+             nSeeds,
+             nWorkers,
+             cuts.front(),
+             cuts[cuts.size() / 2],
+             cuts.back(),
+             time,
+             serialTime,
+             serialTime - time);
+    prof::count("partSeeds", nSeeds);
+}
+
+// the smallest cut within the imbalance limit (the smallest cut of all if no one satisfies it), -1 if all fail
+int selectPartition(const vector<PartResult> &results) {
+    int best = -1, bestAny = -1;
+    for (unsigned i = 0; i < results.size(); i++) {
+        const PartResult &res = results[i];
+        if (res.cut < 0) continue;
+        if (bestAny < 0 || res.cut < results[bestAny].cut) bestAny = i;
+        if (res.imbal <= partImbal + 1e-9 && (best < 0 || res.cut < results[best].cut)) best = i;
+    }
+    if (bestAny < 0) return -1;
+    if (best < 0) {
+        printlog(LOG_WARN, "no partition within imbalance %.2f, use seed %d (imbalance %.3f)", partImbal, results[bestAny].seed, results[bestAny].imbal);
+        return bestAny;
+    }
+    if (results.size() > 1) printlog(LOG_INFO, "best partition: seed %d, imbalance %.3f", results[best].seed, results[best].imbal);
+    return best;
+}
+
+bool runPartition(int c, int n, int *cwghts, int *nwghts, int *xpins, int *pins, int k, PartResult &res) {
+    vector<PartResult> results;
+    if (setting.partSeeds <= 1) {
+        results.resize(1);
+        runPatoh(c, n, cwghts, nwghts, xpins, pins, k, 0, results[0]);
+    } else if (!setting.partFork) {
+        results.resize(setting.partSeeds);
+        for (int seed = 0; seed < setting.partSeeds; seed++) {
+            runPatoh(c, n, cwghts, nwghts, xpins, pins, k, seed, results[seed]);
+        }
+    } else {
+        runPatohSeeds(c, n, cwghts, nwghts, xpins, pins, k, setting.partSeeds, results);
+    }
+    int best = selectPartition(results);
+    if (best < 0) return false;
+    res = move(results[best]);
+    return true;
+}
+
+// STA of the unpartitioned netlist for timing-driven partitioning, where an edge has the delay of its driver and a
+// unit wire delay, plus the delay of the smallest TDM ratio above 1 if it is cut
+class PartTiming {
+public:
+    PartTiming();
+    double update(const vector<int> *partvec);  // sink arrival time, no edge is cut if partvec is NULL
+    void getNetCosts(const vector<bool> &isCsdNet, vector<int> &nwghts) const;
+    int getNumCutNets() const { return _nCutNets; }
+    int getNumCritCutNets() const { return _nCritCutNets; }
+
+private:
+    TimingGraph _graph;
+    Pool<TdmNet> _netPool;
+    vector<int> _edgeNet;       // db net id by edge id, -1 for the edges of source and sink
+    vector<double> _baseDelay;  // by edge id
+    vector<double> _netCrit;    // by db net id, averaged over the updates
+    bool _valid;
+    int _nUpdates = 0;
+    int _nCutNets = 0;
+    int _nCritCutNets = 0;
+
+    const int cutRatio = 8;
+    const double critThreshold = 0.9;
+    const double critWeight = 10;
+    const double critExp = 2;
+};
+
+PartTiming::PartTiming() {
+    PROF_SCOPE("partTiming");
+    for (auto instance : database.instances) _graph.addNode(instance);
+    vector<int> sinks;
+    for (auto net : database.nets) {
+        if (net->isClk) continue;
+        int driver = -1;
+        for (auto pin : net->pins)
+            if (pin->type->type == 'o') driver = pin->instance->id;
+        if (driver == -1) continue;
+
+        sinks.clear();
+        for (auto pin : net->pins)
+            if (pin->instance->id != driver) sinks.push_back(pin->instance->id);
+        sort(sinks.begin(), sinks.end());
+        sinks.erase(unique(sinks.begin(), sinks.end()), sinks.end());
+
+        TdmNet *tdmNet = _netPool.create(net);
+        tdmNet->setIntraNet(true);
+        for (auto sink : sinks) {
+            _graph.addEdge(driver, sink, tdmNet);
+            _edgeNet.push_back(net->id);
+        }
+    }
+    _graph.breakCycle();
+    _graph.setSrcSink();
+    _edgeNet.resize(_graph.getNumEdges(), -1);
+    _valid = _graph.levelize();
+    if (!_valid) printlog(LOG_WARN, "cannot levelize the netlist, use unit net costs for partitioning");
+
+    _baseDelay.resize(_graph.getNumEdges(), 0);
+    for (int i = 0; i < _graph.getNumEdges(); i++)
+        if (_edgeNet[i] != -1) _baseDelay[i] = _graph.getEdge(i)->_constDelay + 1;
+    _netCrit.assign(database.nets.size(), 0);
+}
+
+double PartTiming::update(const vector<int> *partvec) {
+    if (!_valid) return 0;
+
+    vector<bool> isCut(database.nets.size(), false);
+    for (int i = 0; i < _graph.getNumEdges(); i++) {
+        if (_edgeNet[i] == -1) continue;
+        Edge *edge = _graph.getEdge(i);
+        edge->_constDelay = _baseDelay[i];
+        if (partvec && (*partvec)[edge->_driver->_instance->id] != (*partvec)[edge->_fanout->_instance->id]) {
+            edge->_constDelay += edge->_tdmCoef * cutRatio;
+            isCut[_edgeNet[i]] = true;
+        }
+    }
+    _graph.invalidateDelays();
+    _graph.updateArrivalTime();
+    _graph.updateRequireTime();
+    double at = _graph.getSinkAT();
+
+    vector<double> crit(database.nets.size(), 0);
+    for (int i = 0; i < _graph.getNumEdges(); i++) {
+        if (_edgeNet[i] == -1) continue;
+        Edge *edge = _graph.getEdge(i);
+        double slack = edge->_fanout->getRequireTime() - edge->getArrivalTimeAlongEdge();
+        crit[_edgeNet[i]] = max(crit[_edgeNet[i]], min(1.0, 1 - slack / at));
+    }
+
+    _nCutNets = _nCritCutNets = 0;
+    for (unsigned i = 0; i < database.nets.size(); i++) {
+        _netCrit[i] = _nUpdates == 0 ? crit[i] : (_netCrit[i] + crit[i]) / 2;
+        if (isCut[i]) {
+            _nCutNets++;
+            if (crit[i] >= critThreshold) _nCritCutNets++;
+        }
+    }
+    _nUpdates++;
+    return at;
+}
+
+void PartTiming::getNetCosts(const vector<bool> &isCsdNet, vector<int> &nwghts) const {
+    int in = 0, maxCost = 0;
+    long sumCost = 0;
+    for (auto net : database.nets) {
+        if (!isCsdNet[net->id]) continue;
+        int cost = 1 + (int)round(critWeight * pow(_netCrit[net->id], critExp));
+        nwghts[in++] = cost;
+        maxCost = max(maxCost, cost);
+        sumCost += cost;
+    }
+    printlog(LOG_INFO, "net costs: max=%d, avg=%.2f", maxCost, in ? sumCost * 1.0 / in : 0.0);
+}
+
+bool partition(vector<vector<int>> &clusters, int k) {
     vector<int> inputCluster(database.instances.size());
     for (unsigned i = 0; i < inputCluster.size(); ++i) inputCluster[i] = i;
 
     if (k == 1) {
         clusters.push_back(inputCluster);
-        return;
+        return true;
     }
 
     clusters.resize(k);
 
     // Preprocessing
-    PaToH_Parameters args;
     // cell/instance
     int c = 0;  // num of cells
     vector<int> inst2cell(database.instances.size(), -1);
@@ -54,101 +355,182 @@ void partition(vector<vector<int>> &clusters, int k) {
         }
     assert(ip == p && in == n);
 
-    // Init
-    PaToH_Initialize_Parameters(&args, PATOH_CONPART, PATOH_SUGPARAM_QUALITY);
-    args.seed = 0;
-    args._k = k;
-    args.final_imbal = 0.05;
-    int *partvec = new int[c];
-    int *partweights = new int[args._k];
-    int cut;
-    PaToH_Check_User_Parameters(&args, true);
-    PaToH_Alloc(&args, c, n, 1, cwghts, NULL, xpins, pins);
-
-    // Processing
-    PaToH_Part(&args, c, n, 1, 0, cwghts, NULL, xpins, pins, NULL, partvec, partweights, &cut);
+    PartResult best;
+    bool ok = true;
+    if (setting.partTimingIter <= 0) {
+        ok = runPartition(c, n, cwghts, NULL, xpins, pins, k, best);
+    } else {
+        // partition, time, re-weight, re-partition, and keep the partition of the best estimated arrival time
+        // (cells are the instances in order, so partvec is by instance id)
+        PartTiming timing;
+        PartResult last;
+        vector<int> nwghts(n, 1);
+        double bestAT = DBL_MAX;
+        for (int iter = 0;; iter++) {
+            double at = timing.update(iter == 0 ? NULL : &last.partvec);
+            if (iter > 0) {
+                printlog(LOG_INFO,
+                         "timing-driven partition iter %d: cut=%d, #cutNets=%d, #critCutNets=%d, estimated at=%.1f",
+                         iter,
+                         last.cut,
+                         timing.getNumCutNets(),
+                         timing.getNumCritCutNets(),
+                         at);
+                if (at <= bestAT) {
+                    bestAT = at;
+                    best = last;
+                }
+            }
+            if (iter == setting.partTimingIter) break;
+            timing.getNetCosts(isCsdNet, nwghts);
+            ok = runPartition(c, n, cwghts, nwghts.data(), xpins, pins, k, last);
+            if (!ok) break;
+        }
+    }
+    if (!ok) {
+        delete[] cwghts;
+        delete[] xpins;
+        delete[] pins;
+        return false;
+    }
 
     // Postprocessing
-    for (int i = 0; i < c; ++i) clusters[partvec[i]].push_back(inputCluster[i]);
+    for (int i = 0; i < c; ++i) clusters[best.partvec[i]].push_back(inputCluster[i]);
 
-    printlog(LOG_INFO, "cut size: %d, n: %d, c: %d", cut, n, c);
+    printlog(LOG_INFO, "cut size: %d, n: %d, c: %d", best.cut, n, c);
 
-    for (int i = 0; i < k; i++) printlog(LOG_INFO, "%d: weight=%d", i, partweights[i]);
+    for (int i = 0; i < k; i++) printlog(LOG_INFO, "%d: weight=%d", i, best.partweights[i]);
 
     delete[] cwghts;
     delete[] xpins;
     delete[] pins;
-    delete[] partweights;
-    delete[] partvec;
-    PaToH_Free();
+    return true;
 }
 
-void getTdmNets(vector<int> &instDeviceIdx, vector<TdmNet *> &tdmNets) {
-    vector<set<int>> netDeviceIdxs(database.nets.size());
-    for (unsigned i = 0; i < database.nets.size(); i++) {
-        for (auto pin : database.nets[i]->pins) {
-            netDeviceIdxs[i].insert(instDeviceIdx[pin->instance->id]);
-        }
+Pool<TdmNet> tdmNetPool;
+
+void clearTdmNets() { tdmNetPool.clear(); }
+
+// sorted distinct devices of the net in devs (of size #pins), returns the number of tdm nets it is decomposed into
+int getNetDevices(Net *net, vector<int> &instDeviceIdx, int *devs, int &devCnt) {
+    int driverDev = -1, nDriverDevPins = 0;
+    for (unsigned j = 0; j < net->pins.size(); j++) {
+        devs[j] = instDeviceIdx[net->pins[j]->instance->id];
+        if (net->pins[j]->type->type == 'o') driverDev = devs[j];
     }
+    for (unsigned j = 0; j < net->pins.size(); j++) nDriverDevPins += (devs[j] == driverDev);
+    sort(devs, devs + net->pins.size());
+    devCnt = unique(devs, devs + net->pins.size()) - devs;
 
-    map<int, vector<int>> crossDevCnt;
-    for (unsigned i = 0; i < database.nets.size(); i++) {
-        int devCnt = netDeviceIdxs[i].size();
-        crossDevCnt[devCnt].push_back(i);
+    // the subnet of the driver device is ignored if it only contains the driver pin
+    if (net->isClk)
+        return 0;
+    else if (devCnt == 1)
+        return 1;
+    else
+        return devCnt - (nDriverDevPins == 1);
+}
+
+// construct the nSubnets tdm nets of the net in subnets and list them in out, in the order of their sink devices
+void decomposeNet(
+    Net *net, vector<int> &instDeviceIdx, const int *devs, int devCnt, int nSubnets, TdmNet *subnets, TdmNet **out) {
+    if (devCnt == 1) {
+        TdmNet *tdmNet = new (subnets) TdmNet(net);
+        tdmNet->setIntraNet(true);
+        tdmNet->reservePins(net->pins.size());
+        for (auto pin : net->pins) tdmNet->addPin(pin);
+        tdmNet->setFromDevice(devs[0]);
+        tdmNet->setToDevice(devs[0]);
+        out[0] = tdmNet;
+        return;
     }
-    log() << "cross device net cnt" << endl;
-    log() << "#device\t#net" << endl;
-    for (auto &pair : crossDevCnt) log() << pair.first << "\t\t" << pair.second.size() << endl;
 
-    for (unsigned i = 0; i < database.nets.size(); i++) {
-        if (database.nets[i]->isClk) continue;
-
-        int devCnt = netDeviceIdxs[i].size();
-        if (devCnt == 1) {
-            TdmNet *tdmNet = new TdmNet(database.nets[i]);
-            tdmNet->setIntraNet(true);
-            for (auto pin : database.nets[i]->pins) tdmNet->addPin(pin);
-
-            tdmNet->setFromDevice(*netDeviceIdxs[i].begin());
-            tdmNet->setToDevice(*netDeviceIdxs[i].begin());
-            tdmNets.push_back(tdmNet);
-        } else {
-            // decomposite into 2-pin net
-            vector<TdmNet *> subnets(devCnt, NULL);
-
-            unordered_map<int, int> deviceIdxToSubnets;
-            int cnt = 0;
-            for (auto idx : netDeviceIdxs[i]) {
-                subnets[cnt] = new TdmNet(database.nets[i]);
-                subnets[cnt]->setToDevice(idx);
-                deviceIdxToSubnets[idx] = cnt;
-                cnt++;
-            }
+    // decomposite into 2-pin net
+    Pin *driverPin = NULL;
+    for (auto pin : net->pins)
+        if (pin->type->type == 'o') driverPin = pin;
+    int driverDev = instDeviceIdx[driverPin->instance->id];
+    int driverIdx = lower_bound(devs, devs + devCnt, driverDev) - devs;
+    int skipIdx = nSubnets < devCnt ? driverIdx : -1;
 
-            int driverIdx = -1;
-            int driverDeviceIdx = -1;
-            for (auto pin : database.nets[i]->pins) {
-                int idx = deviceIdxToSubnets[instDeviceIdx[pin->instance->id]];
-                if (pin->type->type == 'o') {
-                    driverIdx = idx;
-                    driverDeviceIdx = instDeviceIdx[pin->instance->id];
-                }
-                subnets[idx]->addPin(pin);
-            }
+    for (int j = 0, k = 0; j < devCnt; j++) {
+        if (j == skipIdx) continue;
+        out[k] = new (subnets + k) TdmNet(net);
+        out[k]->setIntraNet(j == driverIdx);
+        out[k]->setFromDevice(driverDev);
+        out[k]->setToDevice(devs[j]);
+        k++;
+    }
+    for (auto pin : net->pins) {
+        int j = lower_bound(devs, devs + devCnt, instDeviceIdx[pin->instance->id]) - devs;
+        if (j == skipIdx) continue;
+        out[j - (skipIdx != -1 && j > skipIdx)]->addPin(pin);
+    }
+    for (int j = 0, k = 0; j < devCnt; j++) {
+        if (j == skipIdx) continue;
+        if (j != driverIdx) out[k]->addPin(driverPin);
+        k++;
+    }
+}
 
-            Pin *driverPin = subnets[driverIdx]->getPin(subnets[driverIdx]->getDriverIdx());
-            for (int j = 0; j < devCnt; j++) {
-                subnets[j]->setIntraNet(j == driverIdx);
-                if (j != driverIdx) {
-                    subnets[j]->addPin(driverPin);
-                }
-                subnets[j]->setFromDevice(driverDeviceIdx);
+void getTdmNets(Net *net, vector<int> &instDeviceIdx, vector<TdmNet *> &tdmNets) {
+    vector<int> devs(net->pins.size());
+    int devCnt;
+    int nSubnets = getNetDevices(net, instDeviceIdx, devs.data(), devCnt);
+    if (nSubnets == 0) return;
+
+    int base = tdmNets.size();
+    tdmNets.resize(base + nSubnets);
+    decomposeNet(net, instDeviceIdx, devs.data(), devCnt, nSubnets, tdmNetPool.alloc(nSubnets), tdmNets.data() + base);
+}
+
+void getTdmNets(vector<int> &instDeviceIdx, vector<TdmNet *> &tdmNets) {
+    int nNets = database.nets.size();
+
+    // sorted distinct devices of each net, and the number of tdm nets it is decomposed into
+    vector<int> devOffsets(nNets + 1, 0);
+    for (int i = 0; i < nNets; i++) devOffsets[i + 1] = devOffsets[i] + database.nets[i]->pins.size();
+    vector<int> netDevices(devOffsets[nNets]);
+    vector<int> devCnts(nNets), nSubnets(nNets);
+    {
+        PROF_SCOPE("collectDevices");
+        parallelFor(nNets, setting.nThreads, 1024, [&](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                nSubnets[i] = getNetDevices(database.nets[i], instDeviceIdx, netDevices.data() + devOffsets[i], devCnts[i]);
             }
+        });
+    }
 
-            // ignore the intranet if it only contain the driver pin
-            for (auto tdmNet : subnets)
-                if (tdmNet->getNumPins() != 1) tdmNets.push_back(tdmNet);
-        }
+    vector<int> crossDevCnt;
+    for (int i = 0; i < nNets; i++) {
+        if (devCnts[i] >= (int)crossDevCnt.size()) crossDevCnt.resize(devCnts[i] + 1, 0);
+        crossDevCnt[devCnts[i]]++;
+    }
+    log() << "cross device net cnt" << endl;
+    log() << "#device\t#net" << endl;
+    for (unsigned i = 0; i < crossDevCnt.size(); i++)
+        if (crossDevCnt[i] > 0) log() << i << "\t\t" << crossDevCnt[i] << endl;
+
+    // tdm nets of net i are [netOffsets[i], netOffsets[i + 1]), in the order of their sink devices
+    vector<int> netOffsets(nNets + 1, 0);
+    for (int i = 0; i < nNets; i++) netOffsets[i + 1] = netOffsets[i] + nSubnets[i];
+    int base = tdmNets.size();
+    tdmNets.resize(base + netOffsets[nNets]);
+    TdmNet *pool = tdmNetPool.alloc(netOffsets[nNets]);
+    {
+        PROF_SCOPE("decompose");
+        parallelFor(nNets, setting.nThreads, 1024, [&](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                if (nSubnets[i] == 0) continue;
+                decomposeNet(database.nets[i],
+                             instDeviceIdx,
+                             netDevices.data() + devOffsets[i],
+                             devCnts[i],
+                             nSubnets[i],
+                             pool + netOffsets[i],
+                             tdmNets.data() + base + netOffsets[i]);
+            }
+        });
     }
 
     int cnt = 0;
@@ -157,15 +539,93 @@ void getTdmNets(vector<int> &instDeviceIdx, vector<TdmNet *> &tdmNets) {
     log() << "#tdmNet=" << tdmNets.size() << ", #inter-Net=" << cnt << endl;
 }
 
+// buffered output file of the sub problems, written in large chunks
+class SubFile {
+public:
+    SubFile(const string &file) : _file(file) {
+        _fd = open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (_fd < 0) printlog(LOG_ERROR, "Cannot open %s to write", file.c_str());
+        _buf.reserve(bufSize + 4096);
+    }
+    ~SubFile() {
+        flush();
+        if (_fd >= 0) close(_fd);
+    }
+    SubFile &operator<<(const char *str) {
+        _buf += str;
+        if (_buf.size() >= bufSize) flush();
+        return *this;
+    }
+    SubFile &operator<<(const string &str) { return *this << str.c_str(); }
+    SubFile &operator<<(int val) {
+        char str[16];
+        snprintf(str, sizeof(str), "%d", val);
+        return *this << str;
+    }
+
+private:
+    string _file;
+    int _fd;
+    string _buf;
+    const size_t bufSize = 1 << 22;
+
+    void flush() {
+        if (_fd >= 0 && !writeAll(_fd, _buf.data(), _buf.size())) printlog(LOG_ERROR, "Cannot write %s", _file.c_str());
+        _buf.clear();
+    }
+};
+
+// mkdir -p
+void makeDirs(const string &dir) {
+    for (size_t pos = dir.find('/', 1);; pos = dir.find('/', pos + 1)) {
+        string prefix = dir.substr(0, pos);
+        if (mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) printlog(LOG_ERROR, "Cannot create %s", prefix.c_str());
+        if (pos == string::npos) break;
+    }
+}
+
+// rm -rf dir/*
+void removeEntries(const string &dir) {
+    DIR *dp = opendir(dir.c_str());
+    if (dp == NULL) return;
+    vector<string> entries;
+    while (struct dirent *entry = readdir(dp))
+        if (entry->d_name[0] != '.') entries.push_back(dir + "/" + entry->d_name);
+    closedir(dp);
+    auto removeFile = [](const char *path, const struct stat *, int, struct FTW *) { return remove(path); };
+    for (auto &path : entries)
+        if (nftw(path.c_str(), removeFile, 64, FTW_DEPTH | FTW_PHYS) != 0) printlog(LOG_ERROR, "Cannot remove %s", path.c_str());
+}
+
+// hard link of the file in dir, or a copy if it cannot be linked (e.g., on another file system)
+void linkFile(const string &file, const string &dir) {
+    size_t pos = file.find_last_of('/');
+    string target = dir + "/" + (pos == string::npos ? file : file.substr(pos + 1));
+    if (link(file.c_str(), target.c_str()) == 0) return;
+
+    int in = open(file.c_str(), O_RDONLY);
+    int out = in < 0 ? -1 : open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool ok = out >= 0;
+    char buf[1 << 16];
+    ssize_t len;
+    while (ok && (len = read(in, buf, sizeof(buf))) > 0) ok = writeAll(out, buf, len);
+    if (in >= 0) close(in);
+    if (out >= 0) close(out);
+    if (!ok) printlog(LOG_ERROR, "Cannot copy %s to %s", file.c_str(), dir.c_str());
+}
+
+void writeTdmNet(SubFile &file, const char *prefix, int id, TdmNet *tdmNet) {
+    file << "net " << prefix << id << " " << tdmNet->getNumPins() << "\n";
+    for (auto pin : tdmNet->getPins()) file << "\t" << pin->instance->name << " " << pin->type->name << "\n";
+    file << "endnet\n";
+}
+
 void formPlSubproblem(vector<vector<int>> &clusters, vector<TdmNet *> &tdmNets) {
     int nClusters = clusters.size();
     string parentFolder = database.bmName;
-    string rmCommand = "rm -rf ./";
-    string mkdirCommand = "mkdir -p ./";
-    string cpCommand = "cp ";
-    int code;
-    code = system((rmCommand + parentFolder + "/*").c_str());
-    code = system((mkdirCommand + parentFolder).c_str());
+    string folder = "./" + parentFolder;
+    removeEntries(folder);
+    makeDirs(folder);
 
     vector<vector<TdmNet *>> clusterToNet(nClusters);
     for (auto tdmNet : tdmNets) {
@@ -173,67 +633,52 @@ void formPlSubproblem(vector<vector<int>> &clusters, vector<TdmNet *> &tdmNets)
             clusterToNet[tdmNet->getFromDevice()].push_back(tdmNet);
         }
     }
+    // intra nets are numbered over the clusters in order
+    vector<int> intraNetOffsets(nClusters + 1, 0);
+    for (int c = 0; c < nClusters; c++) intraNetOffsets[c + 1] = intraNetOffsets[c] + clusterToNet[c].size();
 
-    int intraNetCnt = 0;
-    for (int c = 0; c < nClusters; c++) {
-        code = system((mkdirCommand + parentFolder + "/" + to_string(c)).c_str());
-
-        code = system((cpCommand + setting.io_aux + " ./" + parentFolder + "/" + to_string(c)).c_str());
-        code = system((cpCommand + setting.io_wts + " ./" + parentFolder + "/" + to_string(c)).c_str());
-        code = system((cpCommand + setting.io_lib + " ./" + parentFolder + "/" + to_string(c)).c_str());
-        code = system((cpCommand + setting.io_scl + " ./" + parentFolder + "/" + to_string(c)).c_str());
-
-        ofstream plFile("./" + parentFolder + "/" + to_string(c) + "/design.pl");
-        ofstream nodeFile("./" + parentFolder + "/" + to_string(c) + "/design.nodes");
-        for (auto idx : clusters[c]) {
-            nodeFile << database.instances[idx]->name << " "
-                     << Master::NameEnum2String(database.instances[idx]->master->name) << endl;
-            if (database.instances[idx]->fixed) {
-                int x = database.instances[idx]->pack->site->x;
-                int y = database.instances[idx]->pack->site->y;
-                int slot = database.instances[idx]->slot;
-                plFile << database.instances[idx]->name << " " << x << " " << y << " " << slot << " FIXED" << endl;
-            }
-        }
-        plFile.close();
-        nodeFile.close();
-
-        ofstream intraNetFile("./" + parentFolder + "/" + to_string(c) + "/design.nets");
-        for (auto tdmNet : clusterToNet[c]) {
-            intraNetFile << "net intranet_" << to_string(intraNetCnt) << " " << tdmNet->getNumPins() << endl;
-            for (auto pin : tdmNet->getPins()) {
-                intraNetFile << "\t" << pin->instance->name << " " << pin->type->name << endl;
+    // a task per cluster, and the last one for the inter nets and the device of instances
+    parallelFor(nClusters + 1, setting.nThreads, 1, [&](int begin, int end) {
+        for (int c = begin; c < end; c++) {
+            if (c == nClusters) {
+                SubFile interNetFile(folder + "/design_inter.nets");
+                int interNetCnt = 0;
+                for (auto tdmNet : tdmNets)
+                    if (tdmNet->isInterNet()) writeTdmNet(interNetFile, "internet_", interNetCnt++, tdmNet);
+
+                vector<int> instClusterIndex(database.instances.size());
+                for (unsigned i = 0; i < clusters.size(); i++) {
+                    for (auto instId : clusters[i]) {
+                        instClusterIndex[instId] = i;
+                    }
+                }
+                SubFile instDeviceFile(folder + "/instance.device");
+                for (unsigned i = 0; i < database.instances.size(); i++)
+                    instDeviceFile << database.instances[i]->name << " " << instClusterIndex[i] << "\n";
+                continue;
             }
-            intraNetFile << "endnet" << endl;
-            intraNetCnt++;
-        }
 
-        intraNetFile.close();
-    }
+            string dir = folder + "/" + to_string(c);
+            makeDirs(dir);
+            linkFile(setting.io_aux, dir);
+            linkFile(setting.io_wts, dir);
+            linkFile(setting.io_lib, dir);
+            linkFile(setting.io_scl, dir);
 
-    ofstream interNetFile("./" + parentFolder + "/design_inter.nets");
-    int interNetCnt = 0;
-    for (auto tdmNet : tdmNets) {
-        if (tdmNet->isInterNet()) {
-            interNetFile << "net internet_" << to_string(interNetCnt) << " " << tdmNet->getNumPins() << endl;
-            for (auto pin : tdmNet->getPins()) {
-                interNetFile << "\t" << pin->instance->name << " " << pin->type->name << endl;
+            SubFile plFile(dir + "/design.pl");
+            SubFile nodeFile(dir + "/design.nodes");
+            for (auto idx : clusters[c]) {
+                Instance *instance = database.instances[idx];
+                nodeFile << instance->name << " " << Master::NameEnum2String(instance->master->name) << "\n";
+                if (instance->fixed) {
+                    plFile << instance->name << " " << instance->pack->site->x << " " << instance->pack->site->y << " "
+                           << instance->slot << " FIXED\n";
+                }
             }
-            interNetFile << "endnet" << endl;
-            interNetCnt++;
-        }
-    }
-    interNetFile.close();
 
-    vector<int> instClusterIndex(database.instances.size());
-    for (unsigned i = 0; i < clusters.size(); i++) {
-        for (auto instId : clusters[i]) {
-            instClusterIndex[instId] = i;
+            SubFile intraNetFile(dir + "/design.nets");
+            for (unsigned i = 0; i < clusterToNet[c].size(); i++)
+                writeTdmNet(intraNetFile, "intranet_", intraNetOffsets[c] + i, clusterToNet[c][i]);
         }
-    }
-    ofstream instDeviceFile("./" + parentFolder + "/instance.device");
-    for (unsigned i = 0; i < database.instances.size(); i++) {
-        instDeviceFile << database.instances[i]->name << " " << instClusterIndex[i] << endl;
-    }
-    instDeviceFile.close();
-}
\ No newline at end of file
+    });
+}
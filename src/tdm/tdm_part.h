@@ -2,7 +2,12 @@
 #include "global.h"
 
 class TdmNet;
+namespace db {
+class Net;
+}
 
-void partition(vector<vector<int>> &outputClusters, int k);
+bool partition(vector<vector<int>> &outputClusters, int k);  // false if the partitioner fails
 void getTdmNets(vector<int> &instClusterIndex, vector<TdmNet *> &tdmNets);
+void getTdmNets(db::Net *net, vector<int> &instClusterIndex, vector<TdmNet *> &tdmNets);  // appended
+void clearTdmNets();  // frees all the tdm nets of getTdmNets
 void formPlSubproblem(vector<vector<int>> &outputClusters, vector<TdmNet *> &nets);
\ No newline at end of file
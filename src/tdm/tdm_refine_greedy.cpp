@@ -25,6 +25,7 @@ void TdmRefine::solve() {
         criticalPath = timingGraph->getCriticalPath();
         iter++;
     }
+    prof::count("iterations", iter);
 
     tdmDatabase.reportSol();
     log() << "---------------- finish TDM refinement ----------------" << endl;
@@ -2,7 +2,9 @@
 
 #include "global.h"
 
-class Edge;
+template <typename T>
+class EdgeT;
+using Edge = EdgeT<double>;
 class XdrVar;
 
 class SwapHist {
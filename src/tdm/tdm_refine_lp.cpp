@@ -46,14 +46,13 @@ void TdmRefineLP::getResult() {
 }
 
 TdmRefineLP::TdmRefineLP(bool genContSol)
-    : _model(_env), _optXdrVars(tdmDatabase.getOptXdrVars()), _genContSol(genContSol) {
+    : _model(_env),
+      _optXdrVars(tdmDatabase.getOptXdrVars()),
+      _tronconToXdrVar(tdmDatabase.getOptTroncons()),
+      _genContSol(genContSol) {
     _nVar = _optXdrVars.size();
 
     _timingGraph = tdmDatabase.getTimingGraph();
-    for (int i = 0; i < _nVar; i++) {
-        Troncon *troncon = _optXdrVars[i]->getNet()->_troncon;
-        _tronconToXdrVar[troncon].push_back(i);
-    }
 
     _choiceRanges.resize(_optXdrVars.size());
     for (int i = 0, sz = _optXdrVars.size(); i < sz; i++) {
@@ -145,7 +144,8 @@ void TdmRefineLP::addLimitConstraint() {
                 }
             }
         }
-        _model.addConstr(expr <= pair.first->_limit);
+        // the fixed vars of the troncon (see TdmDB::presolve) take their wires first
+        _model.addConstr(expr <= pair.first->_limit - tdmDatabase.getFixedContUsage(pair.first));
     }
 }
 
@@ -164,6 +164,8 @@ void TdmRefineLP::addExactLimitConstraint() {
                     }
                 }
             }
+            expr1 += tdmDatabase.getNumFixedVars(pair.first, true, TdmDB::getXdrChoice(j));
+            expr2 += tdmDatabase.getNumFixedVars(pair.first, false, TdmDB::getXdrChoice(j));
             _model.addConstr(expr1 <= _usageVar[cnt * nChoice * 2 + 2 * j] * TdmDB::getXdrChoice(j));
             _model.addConstr(expr2 <= _usageVar[cnt * nChoice * 2 + 2 * j + 1] * TdmDB::getXdrChoice(j));
         }
@@ -5,7 +5,9 @@
 
 class TdmDB;
 class XdrVar;
-class TimingGraph;
+template <typename T>
+class TimingGraphT;
+using TimingGraph = TimingGraphT<double>;
 class Troncon;
 
 class TdmRefineLP {
@@ -25,7 +27,7 @@ private:
 
     TimingGraph *_timingGraph;
     vector<XdrVar *> &_optXdrVars;
-    map<Troncon *, vector<int>> _tronconToXdrVar;
+    vector<pair<Troncon *, vector<int>>> &_tronconToXdrVar;
     int _nVar;
 
     vector<pair<int, int>> _choiceRanges;
@@ -4,32 +4,76 @@
 #include "timing_graph.h"
 #include "db/db.h"
 
-void TdmLagSolver::solve() {
+// tdmDatabase keeps the graph in double, other precisions work on a copy of it
+template <typename T>
+TimingGraphT<T> *TdmLagSolverT<T>::getTimingGraph(TimingGraph *&copy) {
+    copy = new TimingGraph;
+    copy->copyFrom(*tdmDatabase.getTimingGraph());
+    return copy;
+}
+
+template <>
+TimingGraph *TdmLagSolverT<double>::getTimingGraph(TimingGraph *&copy) {
+    copy = NULL;
+    return tdmDatabase.getTimingGraph();
+}
+
+template <typename T>
+TdmLagSolverT<T>::TdmLagSolverT() : _tdmLagData(getTimingGraph(_copy)) {}
+
+template <typename T>
+TdmLagSolverT<T>::~TdmLagSolverT() {
+    delete _copy;
+}
+
+template <typename T>
+void TdmLagSolverT<T>::solve() {
     log() << "==================== begin TDM analytical solving ====================" << endl;
     TimingGraph *timingGraph = _tdmLagData._timingGraph;
 
-    ofstream convergeFile(db::database.bmName + ".curve");
+    // the curve is also kept in _curve, the file is of a named run only
+    ofstream convergeFile;
+    if (db::database.bmName != "") convergeFile.open(db::database.bmName + ".curve");
     convergeFile << _nIter << endl;
 
     vector<double> bestSol;
     int bestIter = -1;
     double bestCost = DBL_MAX;
 
+    // the warm start solution is the one of iter#-1
+    if (_warmStart) {
+        timingGraph->updateArrivalTime();
+        tdmDatabase.saveSol(bestSol);
+        bestCost = timingGraph->getSinkAT();
+    }
+
     vector<int> bestVals(_nIter, 0);
     for (int i = 0; i < _nIter; i++) {
         // log() << "======== iter " << i << " ========" << endl;
 
-        if (i == 0)
+        prof::count("iterations");
+        if (i == 0 && _warmStart) {
+            // multipliers are read
+        } else if (i == 0) {
+            PROF_SCOPE("initMultiplier");
             initLagMultiplier();
-        else
+        } else {
+            PROF_SCOPE("updateMultiplier");
             updateMultiplier(i);
+        }
 
         // reportLagMultiplier();
 
-        solveLRS();
+        {
+            PROF_SCOPE("solveLRS");
+            solveLRS();
+        }
 
-        double dualVal = computeDual(setting.computeDual);
+        // polyak and bundle steps follow the dual
+        double dualVal = computeDual(setting.computeDual || setting.lagUpdate == Setting::LagUpdate_Polyak ||
+                                     setting.lagUpdate == Setting::LagUpdate_Bundle);
         double primVal = timingGraph->getSinkAT();
+        _curve.emplace_back(primVal, dualVal);
 
         // log() << "primal:" << primVal << ", dual:" << dualVal << endl;
         convergeFile << primVal << " " << dualVal << endl;
@@ -48,6 +92,9 @@ void TdmLagSolver::solve() {
             bestCost = timingGraph->getSinkAT();
         }
         bestVals[i] = bestCost;
+        _tdmLagData._primal = primVal;
+        _tdmLagData._dual = dualVal;
+        _tdmLagData._bestPrimal = bestCost;
     }
 
     convergeFile.close();
@@ -64,12 +111,104 @@ void TdmLagSolver::solve() {
              primal,
              dual,
              (primal - dual) / dual);
+    if (_copy) {
+        // reporting and legalization work on the solution in double
+        tdmDatabase.getTimingGraph()->updateArrivalTime();
+        double verified = tdmDatabase.getArrivalTime();
+        printlog(LOG_INFO, "verify in double: primal=%f, diff=%g", verified, verified - primal);
+    }
 
     log() << "---------------- finish TDM analytical solving ----------------" << endl;
 }
 
-double TdmLagSolver::computeDual(bool computeDual) {
+// binary multipliers: header, mu by edge id, then the lambda of each troncon by its devices
+struct TdmLagHeader {
+    char magic[8];
+    uint64_t nEdges;
+    uint64_t nLambdas;
+};
+struct TdmLagLambda {
+    int32_t device1;
+    int32_t device2;
+    double lambda;
+};
+static const char TdmLagMagic[8] = {'L', 'A', 'R', 'F', 'L', 'A', 'G', '\0'};
+
+template <typename T>
+void TdmLagSolverT<T>::writeMultipliers(const string &filename) const {
+    FILE *fp = fopen(filename.c_str(), "wb");
+    if (fp == NULL) {
+        printlog(LOG_ERROR, "Cannot open %s to write", filename.c_str());
+        return;
+    }
+
+    TdmLagHeader header;
+    memcpy(header.magic, TdmLagMagic, sizeof(TdmLagMagic));
+    header.nEdges = _tdmLagData._mu.size();
+    header.nLambdas = _tdmLagData._tronconToXdrVar.size();
+    vector<double> mu(_tdmLagData._mu.begin(), _tdmLagData._mu.end());
+    vector<TdmLagLambda> lambdas;
+    for (unsigned i = 0; i < header.nLambdas; i++) {
+        Troncon *troncon = _tdmLagData._tronconToXdrVar[i].first;
+        lambdas.push_back({troncon->_devices.first, troncon->_devices.second, _tdmLagData._lambda[i]});
+    }
+
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+              fwrite(mu.data(), sizeof(double), header.nEdges, fp) == header.nEdges &&
+              fwrite(lambdas.data(), sizeof(TdmLagLambda), header.nLambdas, fp) == header.nLambdas;
+    if (!ok) printlog(LOG_ERROR, "Cannot write %s", filename.c_str());
+    fclose(fp);
+}
+
+template <typename T>
+bool TdmLagSolverT<T>::readMultipliers(const string &filename) {
+    FILE *fp = fopen(filename.c_str(), "rb");
+    if (fp == NULL) {
+        printlog(LOG_WARN, "Cannot open %s, multipliers are initialized", filename.c_str());
+        return false;
+    }
+
+    TdmLagHeader header;
+    vector<double> mu;
+    vector<TdmLagLambda> lambdas;
+    bool ok = fread(&header, sizeof(header), 1, fp) == 1 && memcmp(header.magic, TdmLagMagic, sizeof(TdmLagMagic)) == 0 &&
+              header.nEdges == _tdmLagData._mu.size();
+    if (ok) {
+        mu.resize(header.nEdges);
+        lambdas.resize(header.nLambdas);
+        ok = fread(mu.data(), sizeof(double), header.nEdges, fp) == header.nEdges &&
+             fread(lambdas.data(), sizeof(TdmLagLambda), header.nLambdas, fp) == header.nLambdas;
+    }
+    fclose(fp);
+    if (!ok) {
+        printlog(LOG_WARN, "%s is not of the timing graph, multipliers are initialized", filename.c_str());
+        return false;
+    }
+
+    // troncons new to the optimization get the initial lambda of the read mu
+    _tdmLagData._mu.assign(mu.begin(), mu.end());
+    TdmLagMultiplierInitializerT<T>(_tdmLagData).initLambda();
+    int nRead = 0;
+    for (auto &lambda : lambdas) {
+        int idx = tdmDatabase.getOptTronconIdx(tdmDatabase.getTroncon(lambda.device1, lambda.device2));
+        if (idx < 0) continue;
+        _tdmLagData._lambda[idx] = lambda.lambda;
+        nRead++;
+    }
+    printlog(LOG_INFO,
+             "warm start from %s: #mu=%lu, #lambda=%d/%lu",
+             filename.c_str(),
+             mu.size(),
+             nRead,
+             _tdmLagData._lambda.size());
+    _warmStart = true;
+    return true;
+}
+
+template <typename T>
+double TdmLagSolverT<T>::computeDual(bool computeDual) {
     if (!computeDual) return 0;
+    PROF_SCOPE("computeDual");
     TimingGraph *timingGraph = _tdmLagData._timingGraph;
 
     double result = 0;
@@ -83,7 +222,7 @@ double TdmLagSolver::computeDual(bool computeDual) {
 
     for (int e = 0, sz = timingGraph->getNumEdges(); e < sz; e++) {
         Edge *edge = timingGraph->getEdge(e);
-        double &mu = _tdmLagData.getMu(edge);
+        T &mu = _tdmLagData.getMu(edge);
 
         result += mu * (edge->getArrivalTimeAlongEdge() - edge->_fanout->getArrivalTime());
     }
@@ -91,17 +230,20 @@ double TdmLagSolver::computeDual(bool computeDual) {
     return result;
 }
 
-void TdmLagSolver::initLagMultiplier() {
-    TdmLagMultiplierInitializer initializer(_tdmLagData);
+template <typename T>
+void TdmLagSolverT<T>::initLagMultiplier() {
+    TdmLagMultiplierInitializerT<T> initializer(_tdmLagData);
     initializer.run();
 }
 
-void TdmLagSolver::updateMultiplier(int iter) {
-    TdmLagMultiplierUpdater updater(_tdmLagData);
+template <typename T>
+void TdmLagSolverT<T>::updateMultiplier(int iter) {
+    TdmLagMultiplierUpdaterT<T> updater(_tdmLagData);
     updater.run(iter);
 }
 
-void TdmLagSolver::solveLRS() {
+template <typename T>
+void TdmLagSolverT<T>::solveLRS() {
     auto &optXdrVars = _tdmLagData._optXdrVars;
     auto *timingGraph = _tdmLagData._timingGraph;
 
@@ -109,7 +251,7 @@ void TdmLagSolver::solveLRS() {
 
     for (auto var : optXdrVars) {
         Troncon *troncon = tdmDatabase.getTroncon(var);
-        double &lambda = _tdmLagData.getLambda(troncon);
+        T &lambda = _tdmLagData.getLambda(troncon);
 
         double sum = 0;
         for (auto edge : timingGraph->getEdges(var)) sum += edge->_tdmCoef * _tdmLagData.getMu(edge);
@@ -147,3 +289,21 @@ void TdmLagSolver::solveLRS() {
 
     timingGraph->updateArrivalTime();
 }
+
+template <typename T>
+static void runLagSolver(const string &warmStartFile, const string &multiplierFile) {
+    TdmLagSolverT<T> tdmLagSolver;
+    if (warmStartFile != "") tdmLagSolver.readMultipliers(warmStartFile);
+    tdmLagSolver.solve();
+    if (multiplierFile != "") tdmLagSolver.writeMultipliers(multiplierFile);
+}
+
+void solveLag(const string &warmStartFile, const string &multiplierFile) {
+    if (setting.precision == Setting::Precision_Float)
+        runLagSolver<float>(warmStartFile, multiplierFile);
+    else
+        runLagSolver<double>(warmStartFile, multiplierFile);
+}
+
+template class TdmLagSolverT<double>;
+template class TdmLagSolverT<float>;
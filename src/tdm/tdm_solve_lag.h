@@ -3,33 +3,51 @@
 #include "global.h"
 
 class TdmDB;
-class Edge;
 class Troncon;
 class XdrVar;
-class TimingGraph;
-class TdmLagMultiplierUpdater;
-class TdmLagMultiplierInitializer;
-class Node;
-
-class TdmLagData {
+template <typename T>
+class NodeT;
+template <typename T>
+class EdgeT;
+template <typename T>
+class TimingGraphT;
+
+// the multipliers and the timing graph are in the precision T, the XDR vars are shared
+template <typename T>
+class TdmLagDataT {
 public:
-    TdmLagData();
+    using Node = NodeT<T>;
+    using Edge = EdgeT<T>;
+    using TimingGraph = TimingGraphT<T>;
+
+    TdmLagDataT(TimingGraph *timingGraph);
 
-    map<Troncon *, vector<int>> _tronconToXdrVar;
-    map<Troncon *, int> _tronconToIdx;
+    vector<pair<Troncon *, vector<int>>> &_tronconToXdrVar;  // indexed as _lambda
     TimingGraph *_timingGraph;
     vector<XdrVar *> &_optXdrVars;
 
-    vector<double> _lambda;
-    vector<double> _mu;
-    vector<double> _lastMu;
+    vector<T> _lambda;
+    vector<T> _mu;
+    vector<T> _lastMu;  // of the last momentum/nesterov update, before the extrapolation
     const double _epsilon = 0.00001;  // cannot be too small due to precision of cplex
     double _maxChoice;
 
-    double &getMu(Edge *edge);
-    double &getLambda(Troncon *troncon);
-    double getMuVal(Edge *edge) const;
-    double getLambdaVal(Troncon *troncon) const;
+    // the state of the update schemes (setting.lagUpdate) across the iterations
+    double _primal = 0;             // of the last iteration
+    double _dual = 0;
+    double _bestPrimal = DBL_MAX;   // the incumbent
+    double _bestDual = -DBL_MAX;    // polyak
+    double _stepScale = 1;          // polyak and bundle
+    int _nStall = 0;                // iterations without a better dual, or null steps of the bundle
+    // bundle: the stability center and its primal and dual
+    vector<T> _centerMu, _centerLambda;
+    double _centerPrimal = DBL_MAX;
+    double _centerDual = -DBL_MAX;
+
+    T &getMu(Edge *edge);
+    T &getLambda(Troncon *troncon);
+    T getMuVal(Edge *edge) const;
+    T getLambdaVal(Troncon *troncon) const;
 
     void reportLagMultiplier();
     bool isLagMultiplierLegal();
@@ -38,13 +56,29 @@ public:
     double getLambdaGrad(Troncon *troncon);
 };
 
-class TdmLagSolver {
+template <typename T>
+class TdmLagSolverT {
+    friend class TdmBench;
+
 public:
+    using Edge = EdgeT<T>;
+    using TimingGraph = TimingGraphT<T>;
+
+    TdmLagSolverT();
+    ~TdmLagSolverT();
+
     void solve();
+    bool readMultipliers(const string &filename);  // warm start, false if they are not of the same timing graph
+    void writeMultipliers(const string &filename) const;
 
 private:
     const int _nIter = setting.lagIter;
-    TdmLagData _tdmLagData;
+    TimingGraph *_copy;  // of the graph of tdmDatabase if T is not double, NULL otherwise
+    TdmLagDataT<T> _tdmLagData;
+    bool _warmStart = false;
+    vector<pair<double, double>> _curve;  // primal and dual by iteration
+
+    static TimingGraph *getTimingGraph(TimingGraph *&copy);
 
     void initLagMultiplier();
     void updateMultiplier(int iter);
@@ -54,19 +88,29 @@ private:
     double computeDual(bool computeDual);
 };
 
-class TdmLagMultiplierUpdater {
+template <typename T>
+class TdmLagMultiplierUpdaterT {
+    friend class TdmBench;
+
 public:
-    TdmLagMultiplierUpdater(TdmLagData &tdmLagData);
+    using Node = NodeT<T>;
+    using Edge = EdgeT<T>;
+
+    TdmLagMultiplierUpdaterT(TdmLagDataT<T> &tdmLagData);
     void run(int iter);
 
 private:
-    TdmLagData &_tdmLagData;
+    TdmLagDataT<T> &_tdmLagData;
 
     vector<bool> _preserve;
 
     double getMuStepSize();
     double getLambdaStepSize();
     void getRatio(int iter);
+    void getPolyakRatio();
+    void moveCenter();
+    void extrapolate(double beta);
+    void repairFlow();
 
     void updateMu();
     void updateLambda();
@@ -74,10 +118,10 @@ private:
     void removeAccIssue(Node *node);
     void critFlow(Node *node, double driverSum, double fanoutSum);
     void decreaseFlow(double driverSum,
-                       double fanoutSum,
-                       vector<pair<Edge *, double>> &gradients,
-                       int startIdx = 0,
-                       Node *node = NULL);
+                      double fanoutSum,
+                      vector<pair<Edge *, double>> &gradients,
+                      int startIdx = 0,
+                      Node *node = NULL);
     void increaseFlow(Node *node, double driverSum, double fanoutSum);
     void sinkFlow(double driverSum, double fanoutSum, vector<pair<Edge *, double>> &gradients);
 
@@ -85,16 +129,31 @@ private:
 
     const double _changeRate = 0.01;
     const double _baseRate = 0.2;
+    const int _maxStall = 10;  // iterations without a better dual (polyak) or null steps (bundle) before the scale changes
+    const double _momentumBeta = 0.5;
 };
 
-class TdmLagMultiplierInitializer {
+template <typename T>
+class TdmLagMultiplierInitializerT {
 public:
-    TdmLagMultiplierInitializer(TdmLagData &tdmLagData) : _tdmLagData(tdmLagData) {}
+    using Node = NodeT<T>;
+    using TimingGraph = TimingGraphT<T>;
+
+    TdmLagMultiplierInitializerT(TdmLagDataT<T> &tdmLagData) : _tdmLagData(tdmLagData) {}
     void run();
+    void initLambda();
 
 private:
-    TdmLagData &_tdmLagData;
+    TdmLagDataT<T> &_tdmLagData;
 
     void initMu();
-    void initLambda();
 };
+
+using TdmLagData = TdmLagDataT<double>;
+using TdmLagSolver = TdmLagSolverT<double>;
+using TdmLagMultiplierUpdater = TdmLagMultiplierUpdaterT<double>;
+using TdmLagMultiplierInitializer = TdmLagMultiplierInitializerT<double>;
+
+// a Lagrangian solve in setting.precision, warm-started from the multipliers in warmStartFile and saving them to
+// multiplierFile (none if empty); either way, the arrival times of tdmDatabase are of the solution in double at the end
+void solveLag(const string &warmStartFile, const string &multiplierFile);
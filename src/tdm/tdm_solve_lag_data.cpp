@@ -3,23 +3,28 @@
 #include "tdm_net.h"
 #include "timing_graph.h"
 
-double &TdmLagData::getMu(Edge *edge) { return _mu[edge->_id]; }
-
-double &TdmLagData::getLambda(Troncon *troncon) {
-    auto iter = _tronconToIdx.find(troncon);
-    assert(iter != _tronconToIdx.end());
-    return _lambda[iter->second];
+template <typename T>
+T &TdmLagDataT<T>::getMu(Edge *edge) { return _mu[edge->_id]; }
+
+template <typename T>
+T &TdmLagDataT<T>::getLambda(Troncon *troncon) {
+    int idx = tdmDatabase.getOptTronconIdx(troncon);
+    assert(idx >= 0);
+    return _lambda[idx];
 }
 
-double TdmLagData::getMuVal(Edge *edge) const { return _mu[edge->_id]; }
+template <typename T>
+T TdmLagDataT<T>::getMuVal(Edge *edge) const { return _mu[edge->_id]; }
 
-double TdmLagData::getLambdaVal(Troncon *troncon) const {
-    auto iter = _tronconToIdx.find(troncon);
-    assert(iter != _tronconToIdx.end());
-    return _lambda[iter->second];
+template <typename T>
+T TdmLagDataT<T>::getLambdaVal(Troncon *troncon) const {
+    int idx = tdmDatabase.getOptTronconIdx(troncon);
+    assert(idx >= 0);
+    return _lambda[idx];
 }
 
-void TdmLagData::reportLagMultiplier() {
+template <typename T>
+void TdmLagDataT<T>::reportLagMultiplier() {
     cout << "mu:";
     for (unsigned i = 0; i < _mu.size(); i++)
         if (_mu[i] != 0) cout << _mu[i] << " ";
@@ -35,11 +40,16 @@ void TdmLagData::reportLagMultiplier() {
     cout << endl;
 }
 
-double TdmLagData::getMuGrad(Edge *edge) { return edge->getArrivalTimeAlongEdge() - edge->_fanout->getArrivalTime(); }
+template <typename T>
+double TdmLagDataT<T>::getMuGrad(Edge *edge) {
+    return edge->getArrivalTimeAlongEdge() - edge->_fanout->getArrivalTime();
+}
 
-double TdmLagData::getLambdaGrad(Troncon *troncon) { return troncon->getContUsage() - troncon->_limit; }
+template <typename T>
+double TdmLagDataT<T>::getLambdaGrad(Troncon *troncon) { return troncon->getContUsage() - troncon->_limit; }
 
-bool TdmLagData::isLagMultiplierLegal() {
+template <typename T>
+bool TdmLagDataT<T>::isLagMultiplierLegal() {
     for (int i = 0, sz = _timingGraph->getNumNodes(); i < sz; i++) {
         Node *node = _timingGraph->getNode(i);
 
@@ -57,18 +67,15 @@ bool TdmLagData::isLagMultiplierLegal() {
     return true;
 }
 
-TdmLagData::TdmLagData() : _optXdrVars(tdmDatabase.getOptXdrVars()) {
-    _timingGraph = tdmDatabase.getTimingGraph();
-    for (unsigned i = 0; i < _optXdrVars.size(); i++) {
-        Troncon *troncon = _optXdrVars[i]->getNet()->_troncon;
-        _tronconToXdrVar[troncon].push_back(i);
-    }
-
-    int cnt = 0;
-    for (auto &pair : _tronconToXdrVar) _tronconToIdx[pair.first] = cnt++;
-
+template <typename T>
+TdmLagDataT<T>::TdmLagDataT(TimingGraph *timingGraph)
+    : _tronconToXdrVar(tdmDatabase.getOptTroncons()), _optXdrVars(tdmDatabase.getOptXdrVars()) {
+    _timingGraph = timingGraph;
     _mu.assign(_timingGraph->getNumEdges(), 0);
     _lambda.assign(_tronconToXdrVar.size(), 0);
 
     _maxChoice = tdmDatabase.getXdrChoices().back();
-}
\ No newline at end of file
+}
+
+template class TdmLagDataT<double>;
+template class TdmLagDataT<float>;
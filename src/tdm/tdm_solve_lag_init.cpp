@@ -3,7 +3,8 @@
 #include "tdm_net.h"
 #include "timing_graph.h"
 
-void TdmLagMultiplierInitializer::initMu() {
+template <typename T>
+void TdmLagMultiplierInitializerT<T>::initMu() {
     // averaging the flow related to xdr edge
     TimingGraph *timingGraph = _tdmLagData._timingGraph;
     vector<vector<Node *>> &levels = timingGraph->getLevels();
@@ -43,7 +44,8 @@ void TdmLagMultiplierInitializer::initMu() {
     }
 }
 
-void TdmLagMultiplierInitializer::initLambda() {
+template <typename T>
+void TdmLagMultiplierInitializerT<T>::initLambda() {
     // init to troncon limit
     auto &tronconToXdrVar = _tdmLagData._tronconToXdrVar;
     TimingGraph *timingGraph = _tdmLagData._timingGraph;
@@ -58,13 +60,14 @@ void TdmLagMultiplierInitializer::initLambda() {
             sum += sqrt(tmpSum);
             maxTmpSum = max(maxTmpSum, tmpSum);
         }
-        double &lambda = _tdmLagData.getLambda(troncon);
+        T &lambda = _tdmLagData.getLambda(troncon);
         lambda = pow(sum / troncon->_limit, 2);
-        lambda = max(lambda, maxTmpSum);
+        lambda = max<double>(lambda, maxTmpSum);
     }
 }
 
-void TdmLagMultiplierInitializer::run() {
+template <typename T>
+void TdmLagMultiplierInitializerT<T>::run() {
     initMu();
     initLambda();
 
@@ -84,3 +87,6 @@ void TdmLagMultiplierInitializer::run() {
              cnt2,
              lambda.size());
 }
+
+template class TdmLagMultiplierInitializerT<double>;
+template class TdmLagMultiplierInitializerT<float>;
@@ -4,7 +4,8 @@
 #include "timing_graph.h"
 #include "gurobi_c++.h"
 
-void TdmLagMultiplierUpdater::removeAccIssue(Node *node) {
+template <typename T>
+void TdmLagMultiplierUpdaterT<T>::removeAccIssue(Node *node) {
     auto *timingGraph = _tdmLagData._timingGraph;
 
     double driverSum = 0, fanoutSum = 0;
@@ -27,13 +28,14 @@ void TdmLagMultiplierUpdater::removeAccIssue(Node *node) {
                 maxDriver = driver;
             }
         }
-        double &mu = _tdmLagData.getMu(maxDriver);
+        T &mu = _tdmLagData.getMu(maxDriver);
         mu += diff;
         if (mu < 0) mu = 0;
     }
 }
 
-void TdmLagMultiplierUpdater::critFlow(Node *node, double driverSum, double fanoutSum) {
+template <typename T>
+void TdmLagMultiplierUpdaterT<T>::critFlow(Node *node, double driverSum, double fanoutSum) {
     int driverSize = node->_drivers.size();
 
     auto sortedDrivers = node->_drivers;
@@ -43,7 +45,7 @@ void TdmLagMultiplierUpdater::critFlow(Node *node, double driverSum, double fano
 
     double diff = fanoutSum - driverSum;
     for (int d = 0; d < driverSize; d++) {
-        double &mu = _tdmLagData.getMu(sortedDrivers[d]);
+        T &mu = _tdmLagData.getMu(sortedDrivers[d]);
         if (driverSum != 0) {
             mu = mu + diff * (mu / driverSum);
         } else {
@@ -57,7 +59,8 @@ void TdmLagMultiplierUpdater::critFlow(Node *node, double driverSum, double fano
     }
 }
 
-void TdmLagMultiplierUpdater::decreaseFlow(
+template <typename T>
+void TdmLagMultiplierUpdaterT<T>::decreaseFlow(
     double driverSum, double fanoutSum, vector<pair<Edge *, double>> &gradients, int startIdx, Node *node) {
     int driverSize = gradients.size();
 
@@ -96,10 +99,10 @@ void TdmLagMultiplierUpdater::decreaseFlow(
 
     if (lastIdx == startIdx) {
         for (int d = startIdx; d < driverSize; d++) {
-            double &mu = _tdmLagData.getMu(gradients[d].first);
+            T &mu = _tdmLagData.getMu(gradients[d].first);
 
             mu += diff * (mu / muSum);
-            mu = max(mu, 0.0);
+            mu = max(mu, (T)0);
         }
         return;
     }
@@ -107,7 +110,7 @@ void TdmLagMultiplierUpdater::decreaseFlow(
     double ratio = abs(diff) / sum;
     int curIdx = startIdx;
     while (ratio > 1) {
-        double &mu = _tdmLagData.getMu(gradients[curIdx].first);
+        T &mu = _tdmLagData.getMu(gradients[curIdx].first);
         diff += mu;
         sum -= mu;
         muSum -= mu;
@@ -118,9 +121,9 @@ void TdmLagMultiplierUpdater::decreaseFlow(
 
         if (curIdx == lastIdx) {
             for (int d = curIdx; d < driverSize; d++) {
-                double &mu = _tdmLagData.getMu(gradients[d].first);
+                T &mu = _tdmLagData.getMu(gradients[d].first);
                 mu += diff * (mu / muSum);
-                mu = max(mu, 0.0);
+                mu = max(mu, (T)0);
             }
             return;
         }
@@ -133,13 +136,14 @@ void TdmLagMultiplierUpdater::decreaseFlow(
     }
 
     for (int d = curIdx; d < driverSize; d++) {
-        double &mu = _tdmLagData.getMu(gradients[d].first);
+        T &mu = _tdmLagData.getMu(gradients[d].first);
         mu += mu * ratio * (gradients[d].second / maxAbsGradient);
-        mu = max(mu, 0.0);
+        mu = max(mu, (T)0);
     }
 }
 
-void TdmLagMultiplierUpdater::increaseFlow(Node *node, double driverSum, double fanoutSum) {
+template <typename T>
+void TdmLagMultiplierUpdaterT<T>::increaseFlow(Node *node, double driverSum, double fanoutSum) {
     double diff = fanoutSum - driverSum;
     double critSum = 0;
     int numCritMu = 0;
@@ -162,7 +166,7 @@ void TdmLagMultiplierUpdater::increaseFlow(Node *node, double driverSum, double
 
     for (auto driver : node->_drivers) {
         if (driver->getArrivalTimeAlongEdge() >= threshold) {
-            double &mu = _tdmLagData.getMu(driver);
+            T &mu = _tdmLagData.getMu(driver);
             if (critSum != 0) {
                 mu = mu + diff * (mu / critSum);
             } else {
@@ -174,7 +178,10 @@ void TdmLagMultiplierUpdater::increaseFlow(Node *node, double driverSum, double
     }
 }
 
-void TdmLagMultiplierUpdater::sinkFlow(double driverSum, double fanoutSum, vector<pair<Edge *, double>> &gradients) {
+template <typename T>
+void TdmLagMultiplierUpdaterT<T>::sinkFlow(double driverSum,
+                                           double fanoutSum,
+                                           vector<pair<Edge *, double>> &gradients) {
     const double maxDiffRatio = 0.05;
     const double maxNumRatio = 0.01;
     const double maxMuIncr2SumRatio = 0.002;
@@ -214,7 +221,7 @@ void TdmLagMultiplierUpdater::sinkFlow(double driverSum, double fanoutSum, vecto
     int nIncr = 0;
     for (int d = 0; d <= lastIncrIdx; d++) {
         Edge *e = gradients[d].first;
-        double &mu = _tdmLagData.getMu(e);
+        T &mu = _tdmLagData.getMu(e);
         double delta = mu * _ratio;
 
         if (delta > 0) nIncr++;
@@ -227,7 +234,8 @@ void TdmLagMultiplierUpdater::sinkFlow(double driverSum, double fanoutSum, vecto
     decreaseFlow(driverSum, fanoutSum, gradients, lastIncrIdx + 1);
 }
 
-void TdmLagMultiplierUpdater::updateMu() {
+template <typename T>
+void TdmLagMultiplierUpdaterT<T>::updateMu() {
     auto *timingGraph = _tdmLagData._timingGraph;
 
     vector<vector<Node *>> &revLevels = timingGraph->getRevLevels();
@@ -303,7 +311,8 @@ void TdmLagMultiplierUpdater::updateMu() {
     }
 }
 
-void TdmLagMultiplierUpdater::updateLambda() {
+template <typename T>
+void TdmLagMultiplierUpdaterT<T>::updateLambda() {
     // update lambda such that the xdr use up all the resources
     for (auto &pair : _tdmLagData._tronconToXdrVar) {
         vector<double> muVec;
@@ -338,16 +347,97 @@ void TdmLagMultiplierUpdater::updateLambda() {
             break;
         }
 
-        double &lambda = _tdmLagData.getLambda(troncon);
+        T &lambda = _tdmLagData.getLambda(troncon);
         lambda = pow(sum / troncon->_limit, 2);
         // cout << troncon->_id << " " << lambda << " " << muVec.back() << endl;
-        lambda = max(lambda, muVec.back());
+        lambda = max<double>(lambda, muVec.back());
     }
 }
 
-void TdmLagMultiplierUpdater::getRatio(int iter) { _ratio = _baseRate * pow(0.5, _changeRate * iter); }
+template <typename T>
+void TdmLagMultiplierUpdaterT<T>::getRatio(int iter) { _ratio = _baseRate * pow(0.5, _changeRate * iter); }
+
+// Polyak: the ratio is the relative gap between the incumbent primal and the last dual, times a scale halving whenever
+// the dual does not improve for _maxStall iterations
+template <typename T>
+void TdmLagMultiplierUpdaterT<T>::getPolyakRatio() {
+    TdmLagDataT<T> &data = _tdmLagData;
+    if (data._dual > data._bestDual) {
+        data._bestDual = data._dual;
+        data._nStall = 0;
+    } else if (++data._nStall >= _maxStall) {
+        data._stepScale /= 2;
+        data._nStall = 0;
+    }
+    double gap = max(0.0, (data._bestPrimal - data._dual) / data._bestPrimal);
+    _ratio = min(_baseRate, data._stepScale * gap);
+}
+
+// a light bundle method: the steps start from a stability center. A step improving the dual or the primal moves the
+// center (serious step), otherwise its multipliers are averaged with the center, a convex combination of legal flows,
+// and the ratio halves (null step). The flow updates are no ascent steps of the dual, so the center moves anyway after
+// _maxStall null steps
+template <typename T>
+void TdmLagMultiplierUpdaterT<T>::moveCenter() {
+    TdmLagDataT<T> &data = _tdmLagData;
+    if (data._dual > data._centerDual || data._primal < data._centerPrimal || ++data._nStall >= _maxStall) {
+        data._centerPrimal = data._primal;
+        data._centerDual = data._dual;
+        data._centerMu = data._mu;
+        data._centerLambda = data._lambda;
+        data._stepScale = 1;
+        data._nStall = 0;
+    } else {
+        for (unsigned e = 0; e < data._mu.size(); e++) data._mu[e] = (data._mu[e] + data._centerMu[e]) / 2;
+        for (unsigned i = 0; i < data._lambda.size(); i++)
+            data._lambda[i] = (data._lambda[i] + data._centerLambda[i]) / 2;
+        data._stepScale /= 2;
+    }
+    _ratio *= data._stepScale;
+}
+
+// momentum: mu moves on by beta times the last change of the updates, the negative ones are cut to 0 and the flow is
+// made conservative again by repairFlow
+template <typename T>
+void TdmLagMultiplierUpdaterT<T>::extrapolate(double beta) {
+    vector<T> &mu = _tdmLagData._mu, &lastMu = _tdmLagData._lastMu;
+    vector<T> cur = mu;
+    if (lastMu.size() == mu.size()) {
+        for (unsigned e = 0; e < mu.size(); e++) mu[e] = max((T)0, (T)(cur[e] + beta * (cur[e] - lastMu[e])));
+        repairFlow();
+    }
+    lastMu.swap(cur);
+}
+
+// from the sink, the drivers of each node are scaled to carry the flow of its fanouts, or the most critical one
+// carries it if none has a flow
+template <typename T>
+void TdmLagMultiplierUpdaterT<T>::repairFlow() {
+    auto *timingGraph = _tdmLagData._timingGraph;
+    for (auto &level : timingGraph->getRevLevels()) {
+        for (auto node : level) {
+            if (node == timingGraph->getSource() || node->_drivers.empty()) continue;
+            double driverSum = 0, fanoutSum = 0;
+            if (node == timingGraph->getSink())
+                fanoutSum = 1;
+            else
+                for (auto fanout : node->_fanouts) fanoutSum += _tdmLagData.getMuVal(fanout);
+            for (auto driver : node->_drivers) driverSum += _tdmLagData.getMuVal(driver);
+
+            if (driverSum > 0) {
+                for (auto driver : node->_drivers) _tdmLagData.getMu(driver) *= fanoutSum / driverSum;
+            } else {
+                Edge *critDriver = node->_drivers[0];
+                for (auto driver : node->_drivers)
+                    if (driver->getArrivalTimeAlongEdge() > critDriver->getArrivalTimeAlongEdge()) critDriver = driver;
+                _tdmLagData.getMu(critDriver) = fanoutSum;
+            }
+        }
+    }
+}
 
-double TdmLagMultiplierUpdater::getMuStepSize() {
+template <typename T>
+double TdmLagMultiplierUpdaterT<T>::getMuStepSize() {
     auto *timingGraph = _tdmLagData._timingGraph;
 
     double stepSize = DBL_MAX;
@@ -375,7 +465,8 @@ double TdmLagMultiplierUpdater::getMuStepSize() {
     return stepSize;
 }
 
-double TdmLagMultiplierUpdater::getLambdaStepSize() {
+template <typename T>
+double TdmLagMultiplierUpdaterT<T>::getLambdaStepSize() {
     double stepSize = DBL_MAX;
     double maxPosStepSize = DBL_MIN, minPosStepSize = DBL_MAX;
     double maxNegStepSize = DBL_MIN, minNegStepSize = DBL_MAX;
@@ -433,13 +524,33 @@ double TdmLagMultiplierUpdater::getLambdaStepSize() {
     return stepSize;
 }
 
-TdmLagMultiplierUpdater::TdmLagMultiplierUpdater(TdmLagData &tdmLagData) : _tdmLagData(tdmLagData) {
+template <typename T>
+TdmLagMultiplierUpdaterT<T>::TdmLagMultiplierUpdaterT(TdmLagDataT<T> &tdmLagData) : _tdmLagData(tdmLagData) {
     _preserve.assign(_tdmLagData._timingGraph->getNumEdges(), true);
 }
 
-void TdmLagMultiplierUpdater::run(int iter) {
+template <typename T>
+void TdmLagMultiplierUpdaterT<T>::run(int iter) {
     getRatio(iter);
-
-    updateMu();
-    updateLambda();
+    if (setting.lagUpdate == Setting::LagUpdate_Polyak)
+        getPolyakRatio();
+    else if (setting.lagUpdate == Setting::LagUpdate_Bundle)
+        moveCenter();
+
+    {
+        PROF_SCOPE("updateMu");
+        updateMu();
+    }
+    if (setting.lagUpdate == Setting::LagUpdate_Momentum)
+        extrapolate(_momentumBeta);
+    else if (setting.lagUpdate == Setting::LagUpdate_Nesterov)
+        extrapolate((iter - 1.0) / (iter + 2));
+    assert(setting.lagUpdate == Setting::LagUpdate_Geometric || _tdmLagData.isLagMultiplierLegal());
+    {
+        PROF_SCOPE("updateLambda");
+        updateLambda();
+    }
 }
+
+template class TdmLagMultiplierUpdaterT<double>;
+template class TdmLagMultiplierUpdaterT<float>;
@@ -68,7 +68,8 @@ void TdmLpSolver::addLimitConstraint() {
                 }
             }
         }
-        _model.addConstr(expr <= pair.first->_limit);
+        // the fixed vars of the troncon (see TdmDB::presolve) take their wires first
+        _model.addConstr(expr <= pair.first->_limit - tdmDatabase.getFixedContUsage(pair.first));
     }
 }
 
@@ -84,6 +85,8 @@ void TdmLpSolver::addExactLimitConstraint() {
                     expr2 += _xdrVar[i * _nChoice + j];
                 }
             }
+            expr1 += tdmDatabase.getNumFixedVars(pair.first, true, TdmDB::getXdrChoice(j));
+            expr2 += tdmDatabase.getNumFixedVars(pair.first, false, TdmDB::getXdrChoice(j));
             _model.addConstr(expr1 <= _usageVar[cnt * _nChoice * 2 + 2 * j] * TdmDB::getXdrChoice(j));
             _model.addConstr(expr2 <= _usageVar[cnt * _nChoice * 2 + 2 * j + 1] * TdmDB::getXdrChoice(j));
         }
@@ -224,15 +227,16 @@ void TdmLpSolver::getResult() {
     // tdmDatabase.reportTdmAssignment();
 }
 
-TdmLpSolver::TdmLpSolver(bool useLP) : _optXdrVars(tdmDatabase.getOptXdrVars()), _model(_env), _useLP(useLP) {
+TdmLpSolver::TdmLpSolver(bool useLP)
+    : _optXdrVars(tdmDatabase.getOptXdrVars()),
+      _model(_env),
+      _useLP(useLP),
+      _tronconToXdrVar(tdmDatabase.getOptTroncons()) {
     _nVar = _optXdrVars.size();
+    _nChoice = TdmDB::getNumChoices();
     tdmDatabase.checkFeasibility(_nChoice);
 
     _timingGraph = tdmDatabase.getTimingGraph();
-    for (int i = 0; i < _nVar; i++) {
-        Troncon *troncon = _optXdrVars[i]->getNet()->_troncon;
-        _tronconToXdrVar[troncon].push_back(i);
-    }
 
     int xdrVarNum = _nVar * _nChoice;
     int gateVarNum = _timingGraph->getNumNodes();
@@ -5,7 +5,9 @@
 
 class TdmDB;
 class XdrVar;
-class TimingGraph;
+template <typename T>
+class TimingGraphT;
+using TimingGraph = TimingGraphT<double>;
 class Troncon;
 
 class TdmLpSolver {
@@ -14,7 +16,7 @@ public:
     void solve();
 
 protected:
-    int _nChoice = 1600 / 8 + 1;
+    int _nChoice;
     int _nVar;
 
     TimingGraph *_timingGraph;
@@ -36,7 +38,7 @@ protected:
 
 private:
     bool _useLP;
-    map<Troncon *, vector<int>> _tronconToXdrVar;
+    vector<pair<Troncon *, vector<int>>> &_tronconToXdrVar;
     const int _timeLimit = 10000;
     const int _moreChoiceIdx = 2;
 
@@ -0,0 +1,297 @@
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "tdm_sweep.h"
+#include "db/db.h"
+#include "tdm_db.h"
+#include "tdm_leg.h"
+#include "tdm_refine_greedy.h"
+#include "tdm_solve_lag.h"
+#include "timing_graph.h"
+
+// sent back by the child of a scenario, small enough for an atomic write to the pipe
+struct TdmScenarioResult {
+    double at;
+    int limitVio;
+    double choiceVio;
+    int nOptVars;
+    int maxUsedRatio;
+    double time;
+};
+
+bool TdmSweep::read(const string &filename) {
+    ifstream fs(filename);
+    if (!fs.good()) {
+        printlog(LOG_ERROR, "Cannot open %s to read", filename.c_str());
+        return false;
+    }
+
+    TimingGraph *timingGraph = tdmDatabase.getTimingGraph();
+    TdmScenario defaults;
+    defaults.limit = tdmDatabase.hasBoard() ? 0 : tdmDatabase.getTronconLimit();
+    defaults.maxRatio = tdmDatabase.getMaxChoice();
+    defaults.tdmCoef = timingGraph->getNumEdges() > 0 ? timingGraph->getEdge(0)->_tdmCoef : 5;
+
+    _scenarios.clear();
+    string line;
+    int lineNum = 0;
+    while (getline(fs, line)) {
+        lineNum++;
+        line = line.substr(0, line.find('#'));
+        istringstream iss(line);
+        TdmScenario scenario = defaults;
+        if (!(iss >> scenario.name)) continue;
+        // the name is a part of the file names of the scenario, next to the multipliers of the warm start
+        bool validName = scenario.name != "lag" && all_of(scenario.name.begin(), scenario.name.end(), [](char c) {
+            return isalnum((unsigned char)c) || c == '_' || c == '-';
+        });
+        if (!validName) {
+            printlog(LOG_ERROR,
+                     "%s:%d: invalid scenario name %s, only letters, digits, _ and - are allowed (except lag)",
+                     filename.c_str(),
+                     lineNum,
+                     scenario.name.c_str());
+            return false;
+        }
+        for (const auto &other : _scenarios) {
+            if (other.name == scenario.name) {
+                printlog(LOG_ERROR, "%s:%d: duplicate scenario %s", filename.c_str(), lineNum, scenario.name.c_str());
+                return false;
+            }
+        }
+
+        string token;
+        bool ok = true;
+        while (ok && iss >> token) {
+            size_t pos = token.find('=');
+            string key = token.substr(0, pos);
+            const char *val = pos == string::npos ? "" : token.c_str() + pos + 1;
+            char *end;
+            if (key == "limit") {
+                scenario.limit = strtol(val, &end, 10);
+                ok = *val && !*end && scenario.limit > 0;
+            } else if (key == "maxRatio") {
+                scenario.maxRatio = strtol(val, &end, 10);
+                ok = *val && !*end && scenario.maxRatio >= 8;
+            } else if (key == "tdmCoef") {
+                scenario.tdmCoef = strtod(val, &end);
+                ok = *val && !*end && scenario.tdmCoef > 0;
+            } else {
+                ok = false;
+            }
+        }
+        if (!ok) {
+            printlog(LOG_ERROR, "%s:%d: invalid scenario option %s", filename.c_str(), lineNum, token.c_str());
+            return false;
+        }
+        _scenarios.push_back(scenario);
+    }
+    if (_scenarios.empty()) {
+        printlog(LOG_ERROR, "no scenario in %s", filename.c_str());
+        return false;
+    }
+    return true;
+}
+
+void TdmSweep::solveScenario(TdmScenario &scenario, const string &lagFile) {
+    timer::timer time;
+    printlog(LOG_INFO,
+             "scenario %s: limit=%d, maxRatio=%d, tdmCoef=%.3f",
+             scenario.name.c_str(),
+             scenario.limit,
+             scenario.maxRatio,
+             scenario.tdmCoef);
+    tdmDatabase.getTimingGraph()->setTdmCoef(scenario.tdmCoef);
+    tdmDatabase.setMaxChoice(scenario.maxRatio);
+    if (scenario.limit > 0) tdmDatabase.setTronconLimit(scenario.limit);
+    if (setting.presolve) tdmDatabase.presolve();
+
+    solveLag(lagFile, "");
+    if (setting.lg != Setting::Lg_None) {
+        TdmLegalize legalizer;
+        legalizer.solve();
+    }
+    {
+        TdmRefine greedyRefiner;
+        greedyRefiner.solve();
+    }
+    tdmDatabase.reportSol();
+    if (setting.presolve) tdmDatabase.checkPresolve();
+    tdmDatabase.writeSol(db::database.bmName + "_" + scenario.name + ".tdm", !setting.binSol);
+
+    scenario.at = tdmDatabase.getArrivalTime();
+    scenario.limitVio = tdmDatabase.getLimitVio();
+    scenario.choiceVio = tdmDatabase.getChoiceVio();
+    scenario.nOptVars = tdmDatabase.getOptXdrVars().size();
+    scenario.maxUsedRatio = 0;
+    for (auto var : tdmDatabase.getXdrVars()) scenario.maxUsedRatio = max(scenario.maxUsedRatio, (int)var->getVal());
+    scenario.time = time.elapsed();
+}
+
+// the settings of a scenario only live in its child, so the next one starts from the base solve again
+void TdmSweep::solve() {
+    timer::timer wallTime;
+    int nScenarios = _scenarios.size();
+    string lagFile = db::database.bmName + "_lag.tdm";
+    {
+        PROF_SCOPE("sweepBase");
+        solveLag("", lagFile);
+    }
+
+    vector<pid_t> pids(nScenarios, -1);
+    vector<int> fds(nScenarios, -1);
+    int nWorkers = max(1, min(nScenarios, (int)thread::hardware_concurrency() / max(1, setting.nThreads)));
+
+    auto launch = [&](int i) {
+        TdmScenario &scenario = _scenarios[i];
+        int fd[2];
+        if (pipe(fd) != 0) {
+            printlog(LOG_ERROR, "pipe fails for scenario %s", scenario.name.c_str());
+            return;
+        }
+        cout.flush();
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(fd[0]);
+            string logFile = db::database.bmName + "_" + scenario.name + ".log";
+            int logFd = open(logFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (logFd >= 0) {
+                dup2(logFd, STDOUT_FILENO);
+                dup2(logFd, STDERR_FILENO);
+                close(logFd);
+            }
+            solveScenario(scenario, lagFile);
+            cout.flush();
+            fflush(stdout);
+            TdmScenarioResult res = {scenario.at,
+                                     scenario.limitVio,
+                                     scenario.choiceVio,
+                                     scenario.nOptVars,
+                                     scenario.maxUsedRatio,
+                                     scenario.time};
+            _exit(write(fd[1], &res, sizeof(res)) == sizeof(res) ? 0 : 1);
+        }
+        close(fd[1]);
+        if (pid < 0) {
+            printlog(LOG_ERROR, "fork fails for scenario %s", scenario.name.c_str());
+            close(fd[0]);
+            return;
+        }
+        pids[i] = pid;
+        fds[i] = fd[0];
+    };
+
+    double serialTime = 0;
+    auto collect = [&](int i) {
+        TdmScenario &scenario = _scenarios[i];
+        TdmScenarioResult res;
+        bool ok = ::read(fds[i], &res, sizeof(res)) == sizeof(res);
+        close(fds[i]);
+        fds[i] = -1;
+        int status;
+        if (waitpid(pids[i], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) ok = false;
+        if (ok) {
+            scenario.solved = true;
+            scenario.at = res.at;
+            scenario.limitVio = res.limitVio;
+            scenario.choiceVio = res.choiceVio;
+            scenario.nOptVars = res.nOptVars;
+            scenario.maxUsedRatio = res.maxUsedRatio;
+            scenario.time = res.time;
+            serialTime += res.time;
+            printlog(LOG_INFO,
+                     "scenario %s: at=%.3f, LimitVio=%d, time=%.2fs",
+                     scenario.name.c_str(),
+                     scenario.at,
+                     scenario.limitVio,
+                     scenario.time);
+        } else {
+            printlog(LOG_ERROR, "scenario %s fails, see its log", scenario.name.c_str());
+        }
+    };
+
+    // the next scenario starts as soon as any running one ends (its result or its exit closes the pipe)
+    int nLaunched = 0, nRunning = 0;
+    while (true) {
+        for (; nLaunched < nScenarios && nRunning < nWorkers; nLaunched++) {
+            launch(nLaunched);
+            if (fds[nLaunched] >= 0) nRunning++;
+        }
+        if (nRunning == 0) break;
+
+        vector<struct pollfd> pfds;
+        vector<int> running;
+        for (int i = 0; i < nLaunched; i++) {
+            if (fds[i] < 0) continue;
+            pfds.push_back({fds[i], POLLIN, 0});
+            running.push_back(i);
+        }
+        if (poll(pfds.data(), pfds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            printlog(LOG_ERROR, "poll fails: %s", strerror(errno));
+            for (auto i : running) collect(i);
+            nRunning = 0;
+            continue;
+        }
+        for (unsigned j = 0; j < pfds.size(); j++) {
+            if (pfds[j].revents == 0) continue;
+            collect(running[j]);
+            nRunning--;
+        }
+    }
+
+    printlog(LOG_INFO,
+             "%d scenarios on %d workers: time=%.2fs (serial %.2fs)",
+             nScenarios,
+             nWorkers,
+             wallTime.elapsed(),
+             serialTime);
+    prof::count("scenarios", nScenarios);
+}
+
+void TdmSweep::writeTable(const string &filename) const {
+    ofstream fs(filename);
+    fs << "scenario,limit,maxRatio,tdmCoef,at,limitVio,choiceVio,optVars,maxUsedRatio,time" << endl;
+    log() << "scenario        limit  maxRatio  tdmCoef          at  limitVio  optVars  maxUsedRatio    time" << endl;
+    for (auto &scenario : _scenarios) {
+        char buf[256];
+        if (scenario.solved) {
+            snprintf(buf,
+                     sizeof(buf),
+                     "%s,%d,%d,%g,%.3f,%d,%g,%d,%d,%.3f",
+                     scenario.name.c_str(),
+                     scenario.limit,
+                     scenario.maxRatio,
+                     scenario.tdmCoef,
+                     scenario.at,
+                     scenario.limitVio,
+                     scenario.choiceVio,
+                     scenario.nOptVars,
+                     scenario.maxUsedRatio,
+                     scenario.time);
+        } else {
+            snprintf(
+                buf, sizeof(buf), "%s,%d,%d,%g,,,,,,", scenario.name.c_str(), scenario.limit, scenario.maxRatio, scenario.tdmCoef);
+        }
+        fs << buf << endl;
+
+        snprintf(buf,
+                 sizeof(buf),
+                 "%-14s %6d %9d %8.3f %11.3f %9d %8d %13d %7.2f",
+                 scenario.name.c_str(),
+                 scenario.limit,
+                 scenario.maxRatio,
+                 scenario.tdmCoef,
+                 scenario.at,
+                 scenario.limitVio,
+                 scenario.nOptVars,
+                 scenario.maxUsedRatio,
+                 scenario.time);
+        log() << buf << (scenario.solved ? "" : "  (failed)") << endl;
+    }
+    fs.close();
+    printlog(LOG_INFO, "sweep table is written to %s", filename.c_str());
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "global.h"
+
+// a what-if scenario of the board, given by a line of the sweep file
+//   <name> [limit=<wires per troncon>] [maxRatio=<max TDM ratio>] [tdmCoef=<delay per unit of ratio>]
+// where the missing ones keep the defaults of TdmDB and TimingGraph (limit 0 keeps the wires of -board)
+class TdmScenario {
+public:
+    string name;
+    int limit;
+    int maxRatio;
+    double tdmCoef;
+
+    // results
+    bool solved = false;
+    double at = 0;
+    int limitVio = 0;
+    double choiceVio = 0;
+    int nOptVars = 0;
+    int maxUsedRatio = 0;
+    double time = 0;
+};
+
+// All scenarios share the partition and the timing graph of tdmDatabase. The multipliers of a Lagrangian solve of the
+// default settings warm-start each scenario, which runs in a forked child (cores / nThreads at a time) with its log in
+// <bmName>_<scenario>.log and its solution in <bmName>_<scenario>.tdm.
+class TdmSweep {
+public:
+    bool read(const string &filename);
+    void solve();
+    void writeTable(const string &filename) const;
+
+private:
+    vector<TdmScenario> _scenarios;
+
+    void solveScenario(TdmScenario &scenario, const string &lagFile);
+};
@@ -6,7 +6,8 @@
 #include "tdm_net.h"
 #include "db/site.h"
 
-Edge::Edge(Node* fromNode, Node* toNode, TdmNet* net, int id) {
+template <typename T>
+EdgeT<T>::EdgeT(Node* fromNode, Node* toNode, TdmNet* net, int id) {
     _driver = fromNode;
     _fanout = toNode;
     _id = id;
@@ -17,20 +18,22 @@ Edge::Edge(Node* fromNode, Node* toNode, TdmNet* net, int id) {
     toNode->addDriver(this);
 }
 
-void Edge::updateDelay() {
+template <typename T>
+void EdgeT<T>::updateDelay() {
     if (!_net) {
         _delay = 0;
     } else {
         _delay = _constDelay;
         if (_net->isInterNet()) {
-            _delay += _tdmCoef * _net->getXdrVar()->getVal();
+            _delay += _tdmCoef * (T)_net->getXdrVar()->getVal();
         }
     }
     _arrivalTimeAlongEdge = _delay + _driver->getArrivalTime();
 }
 
-double Edge::getDelay(int val) const {
-    double delay;
+template <typename T>
+T EdgeT<T>::getDelay(int val) const {
+    T delay;
 
     if (!_net) {
         delay = 0;
@@ -41,7 +44,8 @@ double Edge::getDelay(int val) const {
     return delay;
 }
 
-Node::Node(db::Instance* instance, int id) {
+template <typename T>
+NodeT<T>::NodeT(db::Instance* instance, int id) {
     _id = id;
     _instance = instance;
     _arrivalTime = -1;
@@ -52,27 +56,85 @@ Node::Node(db::Instance* instance, int id) {
         _delay = 0;
 }
 
-vector<Edge*>& TimingGraph::getEdges(XdrVar* var) { return _xdrToEdges[var]; }
+template <typename T>
+vector<EdgeT<T>*>& TimingGraphT<T>::getEdges(XdrVar* var) { return _xdrToEdges[var->_id]; }
 
-vector<Edge*>& TimingGraph::getEdges(TdmNet* net) { return getEdges(net->getXdrVar()); }
+template <typename T>
+vector<EdgeT<T>*>& TimingGraphT<T>::getEdges(TdmNet* net) { return getEdges(net->getXdrVar()); }
 
-Edge* TimingGraph::addEdge(int u, int v, TdmNet* net) { return addEdge(_nodes[u], _nodes[v], net); }
+template <typename T>
+EdgeT<T>* TimingGraphT<T>::addEdge(int u, int v, TdmNet* net) { return addEdge(_nodes[u], _nodes[v], net); }
 
-Node* TimingGraph::addNode(db::Instance* instance) {
-    Node* node = new Node(instance, _nodes.size());
+template <typename T>
+NodeT<T>* TimingGraphT<T>::addNode(db::Instance* instance) {
+    Node* node = _nodePool.create(instance, _nodes.size());
     _nodes.push_back(node);
+    _csrTopologyValid = false;
 
     return node;
 }
-Edge* TimingGraph::addEdge(Node* u, Node* v, TdmNet* net) {
-    Edge* edge = new Edge(u, v, net, _edges.size());
+template <typename T>
+EdgeT<T>* TimingGraphT<T>::addEdge(Node* u, Node* v, TdmNet* net) {
+    Edge* edge = _edgePool.create(u, v, net, _edges.size());
     _edges.push_back(edge);
+    _csrTopologyValid = false;
     return edge;
 }
 
-void TimingGraph::addMapping(XdrVar* var, Edge* edge) { _xdrToEdges[var].push_back(edge); }
+template <typename T>
+void TimingGraphT<T>::addMapping(XdrVar* var, Edge* edge) {
+    _xdrToEdges[var->_id].push_back(edge);
+    _csrDelayValid = false;
+}
+
+template <typename T>
+void TimingGraphT<T>::resetMapping(int nXdrVars) {
+    _xdrToEdges.clear();
+    _xdrToEdges.resize(nXdrVars);
+    _csrDelayValid = false;
+}
+
+template <typename T>
+void TimingGraphT<T>::reserve(int nNodes, int nEdges, int nXdrVars) {
+    _nodes.reserve(nNodes);
+    _edges.reserve(nEdges);
+    _xdrToEdges.resize(nXdrVars);
+}
+
+// an empty graph takes the nodes and edges of the graph with the same ids and the same order of drivers and fanouts
+// (the multiplier updates sort drivers in place)
+template <typename T>
+void TimingGraphT<T>::copyFrom(const TimingGraph& graph) {
+    reserve(graph._nodes.size(), graph._edges.size(), graph._xdrToEdges.size());
+    for (auto node : graph._nodes) addNode(node->_instance)->_delay = node->_delay;
+    for (auto edge : graph._edges) {
+        Edge* copy = addEdge(edge->_driver->_id, edge->_fanout->_id, edge->_net);
+        copy->_constDelay = edge->_constDelay;
+        copy->_tdmCoef = edge->_tdmCoef;
+    }
+    for (auto node : graph._nodes) {
+        Node* copy = _nodes[node->_id];
+        copy->_drivers.clear();
+        copy->_fanouts.clear();
+        for (auto edge : node->_drivers) copy->_drivers.push_back(_edges[edge->_id]);
+        for (auto edge : node->_fanouts) copy->_fanouts.push_back(_edges[edge->_id]);
+    }
+    for (unsigned i = 0; i < graph._xdrToEdges.size(); i++)
+        for (auto edge : graph._xdrToEdges[i]) _xdrToEdges[i].push_back(_edges[edge->_id]);
+    _source = _nodes[graph._source->_id];
+    _sink = _nodes[graph._sink->_id];
+
+    auto copyLevels = [&](const vector<vector<TimingGraph::Node*>>& from, vector<vector<Node*>>& to) {
+        to.assign(from.size(), {});
+        for (unsigned l = 0; l < from.size(); l++)
+            for (auto node : from[l]) to[l].push_back(_nodes[node->_id]);
+    };
+    copyLevels(graph._levels, _levels);
+    copyLevels(graph._revLevels, _revLevels);
+}
 
-void TimingGraph::breakCycle() {
+template <typename T>
+void TimingGraphT<T>::breakCycle() {
     int sz = _nodes.size();
     vector<pair<int, int>> edgeToAdd;
 
@@ -83,22 +145,15 @@ void TimingGraph::breakCycle() {
         if (inst->IsLUT() || inst->IsIO()) continue;
 
         Node* pseudoNode = addNode(inst);
-        for (auto edge : curNode->_fanouts) {
-            edge->_driver = pseudoNode;
-            pseudoNode->_fanouts.push_back(edge);
-        }
-        curNode->_fanouts.clear();
-    }
-
-    if (isCyclic()) {
-        cout << "error: cannot remove all cycle by breaking the current set of instances" << endl;
-        exit(1);
+        pseudoNode->_fanouts.swap(curNode->_fanouts);
+        for (auto edge : pseudoNode->_fanouts) edge->_driver = pseudoNode;
     }
 
     // printlog(LOG_INFO, "after breaking loops: diff_nodes=%d", getNumNodes() - sz);
 }
 
-void TimingGraph::removeAbnEdges() {
+template <typename T>
+void TimingGraphT<T>::removeAbnEdges() {
     vector<double> intraNetDelay;
     for (auto edge : _edges) {
         if (edge->_net && edge->isConstEdge() && edge->_constDelay > 0) {
@@ -116,9 +171,43 @@ void TimingGraph::removeAbnEdges() {
             if (false && edge->_constDelay > outlierThreshold) edge->_constDelay = 0;
         }
     }
+    _csrDelayValid = false;
 }
 
-void TimingGraph::setConstDelay() {
+template <typename T>
+double TimingGraphT<T>::getWireDelay(const Edge* edge) const {
+    if (!edge->_net->isIntraNet()) return 0;
+
+    db::Group& driver = tdmDatabase.getGroup(edge->_driver->_instance->id);
+    db::Group& fanout = tdmDatabase.getGroup(edge->_fanout->_instance->id);
+
+    db::Site* driverSite = db::database.getSite(driver.x, driver.y);
+    db::Site* fanoutSite = db::database.getSite(fanout.x, fanout.y);
+
+    if (driverSite == fanoutSite && edge->_driver->_instance->IsLUT() && edge->_fanout->_instance->IsFF()) return 0;
+
+    return wireDelayCoef * max(1.0, abs(driver.x - fanout.x) + abs(driver.y - fanout.y));
+}
+
+template <typename T>
+void TimingGraphT<T>::updateConstDelay(Edge* edge) {
+    // as setConstDelay and then removeAbnEdges
+    edge->_constDelay = edge->_driver->_delay + getWireDelay(edge);
+    if (edge->isConstEdge() && (!edge->_driver->_instance->IsLUTFF() || !edge->_fanout->_instance->IsLUTFF()))
+        edge->_constDelay = 0;
+    _csrDelayValid = false;
+}
+
+template <typename T>
+void TimingGraphT<T>::setTdmCoef(double tdmCoef) {
+    for (auto edge : _edges) edge->_tdmCoef = tdmCoef;
+    _csrDelayValid = false;
+}
+
+template <typename T>
+void TimingGraphT<T>::setConstDelay() {
+    _csrDelayValid = false;
+
     // some stats
     double sumConstDelay = 0;
     double maxConstDelay = DBL_MIN, minConstDelay = DBL_MAX;
@@ -127,26 +216,14 @@ void TimingGraph::setConstDelay() {
     for (auto edge : _edges) {
         if (!edge->_net) continue;
 
-        if (edge->_net->isIntraNet()) {
-            db::Group& driver = tdmDatabase.getGroup(edge->_driver->_instance->id);
-            db::Group& fanout = tdmDatabase.getGroup(edge->_fanout->_instance->id);
-
-            db::Site* driverSite = db::database.getSite(driver.x, driver.y);
-            db::Site* fanoutSite = db::database.getSite(fanout.x, fanout.y);
+        double wireDelay = getWireDelay(edge);
+        if (wireDelay == 0) continue;
+        edge->_constDelay += wireDelay;
 
-            if (driverSite == fanoutSite && edge->_driver->_instance->IsLUT() && edge->_fanout->_instance->IsFF())
-                continue;
-
-            double wireDelay = wireDelayCoef * max(1.0, abs(driver.x - fanout.x) + abs(driver.y - fanout.y));
-            edge->_constDelay += wireDelay;
-
-            maxConstDelay = max(wireDelay, maxConstDelay);
-            minConstDelay = min(wireDelay, minConstDelay);
-            sumConstDelay += wireDelay;
-            cnt++;
-        } else {
-            edge->_constDelay += 0;
-        }
+        maxConstDelay = max(wireDelay, maxConstDelay);
+        minConstDelay = min(wireDelay, minConstDelay);
+        sumConstDelay += wireDelay;
+        cnt++;
     }
 
     int gateCnt = 0;
@@ -170,7 +247,8 @@ void TimingGraph::setConstDelay() {
     //          maxConstDelay);
 }
 
-void TimingGraph::setSrcSink() {
+template <typename T>
+void TimingGraphT<T>::setSrcSink() {
     vector<Node*> pis, pos;
 
     for (auto node : _nodes) {
@@ -189,7 +267,8 @@ void TimingGraph::setSrcSink() {
     }
 }
 
-void TimingGraph::forwardPropagateST() {
+template <typename T>
+void TimingGraphT<T>::forwardPropagateST() {
     queue<Node*> q;
     q.push(_source);
 
@@ -211,7 +290,8 @@ void TimingGraph::forwardPropagateST() {
     }
 }
 
-void TimingGraph::forwardPropagateMT() {
+template <typename T>
+void TimingGraphT<T>::forwardPropagateMT() {
     for (unsigned l = 0; l < _levels.size(); l++) {
         std::mutex idx_mutex;
         int vIdx = 0;
@@ -243,7 +323,8 @@ void TimingGraph::forwardPropagateMT() {
     }
 }
 
-void TimingGraph::backwardPropagateST() {
+template <typename T>
+void TimingGraphT<T>::backwardPropagateST() {
     queue<Node*> q;
     q.push(_sink);
 
@@ -265,7 +346,8 @@ void TimingGraph::backwardPropagateST() {
     }
 }
 
-void TimingGraph::backwardPropagateMT() {
+template <typename T>
+void TimingGraphT<T>::backwardPropagateMT() {
     // TODO: implement multi-thread structure
     for (unsigned l = 0; l < _revLevels.size(); l++) {
         for (auto node : _revLevels[l]) {
@@ -277,19 +359,173 @@ void TimingGraph::backwardPropagateMT() {
     }
 }
 
-void TimingGraph::updateArrivalTime() {
+// The CSR of a direction has the edges of the rows of the nodes in the order of the levels, so that the kernels of a
+// batch of nodes run over contiguous edges and the rows of a level only read the times of the levels before.
+template <typename T>
+void TimingGraphT<T>::buildCsr(MaxPlusCsr<T>& csr, bool backward) {
+    const vector<vector<Node*>>& levels = backward ? _revLevels : _levels;
+    csr = MaxPlusCsr<T>();
+    csr.node.reserve(_nodes.size());
+    csr.edge.reserve(_edges.size());
+    for (auto& level : levels) {
+        csr.levelBegin.push_back(csr.node.size());
+        for (auto node : level) {
+            csr.node.push_back(node->_id);
+            csr.edgeBegin.push_back(csr.edge.size());
+            for (auto edge : backward ? node->_fanouts : node->_drivers) {
+                csr.edge.push_back(edge->_id);
+                csr.from.push_back(edge->_driver->_id);
+                csr.to.push_back(edge->_fanout->_id);
+            }
+        }
+    }
+    csr.levelBegin.push_back(csr.node.size());
+    csr.edgeBegin.push_back(csr.edge.size());
+
+    int nEdges = csr.edge.size();
+    csr.var.assign(nEdges, 0);
+    csr.constDelay.assign(nEdges, 0);
+    csr.tdmCoef.assign(nEdges, 0);
+    csr.delay.assign(nEdges, 0);
+    csr.atAlong.assign(nEdges, 0);
+    csr.reqAlong.assign(nEdges, 0);
+}
+
+// the delays as Edge::updateDelay, an edge without net or of an intra-FPGA net has no TDM delay
+template <typename T>
+void TimingGraphT<T>::setCsrDelays(MaxPlusCsr<T>& csr) {
+    for (int e = 0, sz = csr.edge.size(); e < sz; e++) {
+        Edge* edge = _edges[csr.edge[e]];
+        csr.var[e] = 0;
+        csr.constDelay[e] = edge->_net ? edge->_constDelay : 0;
+        csr.tdmCoef[e] = 0;
+        if (edge->_net && edge->_net->isInterNet()) {
+            XdrVar* var = edge->_net->getXdrVar();
+            if (var->_id + 1 >= (int)_csrVars.size()) _csrVars.resize(var->_id + 2, NULL);
+            _csrVars[var->_id + 1] = var;
+            csr.var[e] = var->_id + 1;
+            csr.tdmCoef[e] = edge->_tdmCoef;
+        }
+    }
+}
+
+template <typename T>
+void TimingGraphT<T>::updateCsr() {
+    if (!_csrTopologyValid) {
+        buildCsr(_forwardCsr, false);
+        buildCsr(_backwardCsr, true);
+        _at.resize(_nodes.size());
+        _rt.resize(_nodes.size());
+        _csrTopologyValid = true;
+        _csrDelayValid = false;
+    }
+    if (!_csrDelayValid) {
+        _csrVars.assign(1, NULL);
+        setCsrDelays(_forwardCsr);
+        setCsrDelays(_backwardCsr);
+        _xdrVal.assign(_csrVars.size(), 0);
+        _csrDelayValid = true;
+    }
+    for (int i = 1, sz = _csrVars.size(); i < sz; i++)
+        if (_csrVars[i]) _xdrVal[i] = _csrVars[i]->getVal();
+}
+
+template <typename T>
+void TimingGraphT<T>::writeBackCsr(const MaxPlusCsr<T>& csr, int posBegin, int posEnd, bool backward) {
+    for (int pos = posBegin; pos < posEnd; pos++) {
+        Node* node = _nodes[csr.node[pos]];
+        if (backward)
+            node->_requireTime = _rt[node->_id];
+        else
+            node->_arrivalTime = _at[node->_id];
+    }
+    for (int e = csr.edgeBegin[posBegin]; e < csr.edgeBegin[posEnd]; e++) {
+        Edge* edge = _edges[csr.edge[e]];
+        edge->_delay = csr.delay[e];
+        edge->_arrivalTimeAlongEdge = csr.atAlong[e];
+    }
+}
+
+// the nodes of a level are split in batches over the threads as in forwardPropagateMT, a level of one batch runs in
+// the calling thread
+template <typename T>
+void TimingGraphT<T>::propagateCsr(bool backward) {
+    updateCsr();
+    MaxPlusCsr<T>& csr = backward ? _backwardCsr : _forwardCsr;
+    MaxPlusKernels<T> kernels = selectMaxPlusKernels<T>(resolveSimdIsa(setting.simd));
+    auto kernel = backward ? kernels.backward : kernels.forward;
+    MaxPlusBatch<T> batch = csr.getBatch(_xdrVal.data(), _at.data(), _rt.data());
+
+    if (backward) {
+        for (auto node : _nodes) _at[node->_id] = node->getArrivalTime();
+        fill(_rt.begin(), _rt.end(), numeric_limits<T>::max());
+        _rt[_sink->_id] = getSinkAT();
+    } else {
+        fill(_at.begin(), _at.end(), -1);
+        _at[_source->_id] = 0;
+    }
+
+    const int batchSize = 64;
+    int nThreads = max(1, setting.nThreads);
+    for (int l = 0, nLevels = csr.getNumLevels(); l < nLevels; l++) {
+        int begin = csr.levelBegin[l], end = csr.levelBegin[l + 1];
+        int nLevelThreads = min(nThreads, (end - begin + batchSize - 1) / batchSize);
+        if (nLevelThreads <= 1) {
+            kernel(batch, begin, end);
+            writeBackCsr(csr, begin, end, backward);
+            continue;
+        }
+
+        std::mutex idx_mutex;
+        int vIdx = begin;
+
+        auto propagateBatches = [&]() {
+            while (true) {
+                int idx;
+                idx_mutex.lock();
+                idx = vIdx;
+                vIdx += batchSize;
+                idx_mutex.unlock();
+
+                if (idx >= end) break;
+
+                kernel(batch, idx, min(end, idx + batchSize));
+                writeBackCsr(csr, idx, min(end, idx + batchSize), backward);
+            }
+        };
+
+        std::thread threads[nLevelThreads];
+        for (int i = 0; i < nLevelThreads; i++) threads[i] = std::thread(propagateBatches);
+        for (int i = 0; i < nLevelThreads; i++) threads[i].join();
+    }
+}
+
+template <typename T>
+void TimingGraphT<T>::updateArrivalTime() {
+    PROF_SCOPE("forwardPropagate");
+    if (setting.simd != Setting::Simd_Off) {
+        propagateCsr(false);
+        return;
+    }
     resetArrivalTime();
     _source->updateArrivalTime(0);
     forwardPropagateMT();
 }
 
-void TimingGraph::updateRequireTime() {
+template <typename T>
+void TimingGraphT<T>::updateRequireTime() {
+    PROF_SCOPE("backwardPropagate");
+    if (setting.simd != Setting::Simd_Off) {
+        propagateCsr(true);
+        return;
+    }
     resetRequireTime();
     _sink->updateRequireTime(getSinkAT());
     backwardPropagateMT();
 }
 
-void TimingGraph::getSRCoef(XdrVar* var, double& k, double& b) {
+template <typename T>
+void TimingGraphT<T>::getSRCoef(XdrVar* var, double& k, double& b) {
     vector<Edge*> edges = getEdges(var);
     double sinkAT = getSinkAT();
 
@@ -309,106 +545,71 @@ void TimingGraph::getSRCoef(XdrVar* var, double& k, double& b) {
     }
 }
 
-void TimingGraph::resetTiming() {
+template <typename T>
+void TimingGraphT<T>::resetTiming() {
     resetArrivalTime();
     resetRequireTime();
 }
 
-void TimingGraph::resetArrivalTime() {
+template <typename T>
+void TimingGraphT<T>::resetArrivalTime() {
     for (auto node : _nodes) node->resetArrivalTime();
 }
 
-void TimingGraph::resetRequireTime() {
+template <typename T>
+void TimingGraphT<T>::resetRequireTime() {
     for (auto node : _nodes) node->resetRequireTime();
 }
 
-void TimingGraph::levelize() {
-    if (isCyclic()) {
-        cout << "Error:cyclic graph" << endl;
-        return;
-    }
-
-    forLevelize();
-    revLevelize();
-}
+// Forward levels are the BFS layers of a Kahn pass from the source, and nodes it never reaches are on cycles.
+// Reverse levels are the layers of the same pass from the sink over drivers.
+template <typename T>
+bool TimingGraphT<T>::levelize() {
+    _levels.clear();
+    _revLevels.clear();
+    _csrTopologyValid = false;
 
-void TimingGraph::revLevelize() {
-    queue<Node*> q;
-    vector<int> numFanouts(_nodes.size(), 0);
+    vector<int> numDrivers(_nodes.size());
+    vector<Node*> level;
     for (auto node : _nodes) {
-        numFanouts[node->_id] = node->_fanouts.size();
+        numDrivers[node->_id] = node->_drivers.size();
+        if (numDrivers[node->_id] == 0) level.push_back(node);
     }
 
-    vector<Node*>* level;
-    q.push(_sink);
-
-    int curLevelNode = 1;
-    int prevLevelNode = 0;
-
-    while (true) {
-        if (prevLevelNode == 0) {
-            _revLevels.resize(_revLevels.size() + 1);
-            level = &_revLevels.back();
-            prevLevelNode = curLevelNode;
-            curLevelNode = 0;
-        }
-        Node* curNode = q.front();
-        q.pop();
-
-        prevLevelNode--;
-        level->push_back(curNode);
-
-        if (curNode == _source) break;
-
-        for (auto edge : curNode->_drivers) {
-            numFanouts[edge->_driver->_id]--;
-            if (numFanouts[edge->_driver->_id] == 0) {
-                q.push(edge->_driver);
-                curLevelNode++;
+    unsigned nVisited = 0;
+    while (!level.empty()) {
+        nVisited += level.size();
+        _levels.push_back(move(level));
+        level.clear();
+        for (auto node : _levels.back()) {
+            for (auto edge : node->_fanouts) {
+                if (--numDrivers[edge->_fanout->_id] == 0) level.push_back(edge->_fanout);
             }
         }
     }
-}
+    if (nVisited != _nodes.size()) return false;
 
-void TimingGraph::forLevelize() {
-    queue<Node*> q;
-    vector<int> numDrivers(_nodes.size(), 0);
+    // the graph is acyclic, so the reverse layers need no check
+    vector<int>& numFanouts = numDrivers;
     for (auto node : _nodes) {
-        numDrivers[node->_id] = node->_drivers.size();
+        numFanouts[node->_id] = node->_fanouts.size();
+        if (numFanouts[node->_id] == 0) level.push_back(node);
     }
-
-    vector<Node*>* level;
-    q.push(_source);
-
-    int curLevelNode = 1;
-    int prevLevelNode = 0;
-
-    while (true) {
-        if (prevLevelNode == 0) {
-            _levels.resize(_levels.size() + 1);
-            level = &_levels.back();
-            prevLevelNode = curLevelNode;
-            curLevelNode = 0;
-        }
-        Node* curNode = q.front();
-        q.pop();
-
-        prevLevelNode--;
-        level->push_back(curNode);
-
-        if (curNode == _sink) break;
-
-        for (auto edge : curNode->_fanouts) {
-            numDrivers[edge->_fanout->_id]--;
-            if (numDrivers[edge->_fanout->_id] == 0) {
-                q.push(edge->_fanout);
-                curLevelNode++;
+    while (!level.empty()) {
+        _revLevels.push_back(move(level));
+        level.clear();
+        for (auto node : _revLevels.back()) {
+            for (auto edge : node->_drivers) {
+                if (--numFanouts[edge->_driver->_id] == 0) level.push_back(edge->_driver);
             }
         }
     }
+
+    return true;
 }
 
-void TimingGraph::report() const {
+template <typename T>
+void TimingGraphT<T>::report() const {
     log() << "---- report timing graph ----" << endl;
     printlog(LOG_INFO, "#level/#revLevel=%lu/%lu", _levels.size(), _revLevels.size());
     int cnt = 0;
@@ -471,43 +672,8 @@ void TimingGraph::report() const {
     }
 }
 
-bool TimingGraph::isCyclicUtil(int v, vector<bool>& visited, vector<bool>& recStack) {
-    if (!visited[v]) {
-        // Mark the current node as visited and part of recursion stack
-        visited[v] = true;
-        recStack[v] = true;
-
-        // Recur for all the vertices adjacent to this vertex
-        list<int>::iterator i;
-        for (auto edge : _nodes[v]->_fanouts) {
-            int i = edge->_fanout->_id;
-            if (!visited[i] && isCyclicUtil(i, visited, recStack)) {
-                return true;
-            } else if (recStack[i]) {
-                return true;
-            }
-        }
-    }
-    recStack[v] = false;  // remove the vertex from recursion stack
-    return false;
-}
-
-// Returns true if the graph contains a cycle, else false.
-bool TimingGraph::isCyclic() {
-    // Mark all the vertices as not visited and not part of recursion
-    // stack
-    vector<bool> visited(_nodes.size(), false);
-    vector<bool> recStack(_nodes.size(), false);
-
-    // Call the recursive helper function to detect cycle in different
-    // DFS trees
-    for (unsigned i = 0; i < _nodes.size(); i++)
-        if (isCyclicUtil(i, visited, recStack)) return true;
-
-    return false;
-}
-
-bool TimingGraph::DFSUtil(int v, int dest, vector<bool>& visited) {
+template <typename T>
+bool TimingGraphT<T>::DFSUtil(int v, int dest, vector<bool>& visited) {
     visited[v] = true;
 
     if (dest == v) return true;
@@ -524,23 +690,26 @@ bool TimingGraph::DFSUtil(int v, int dest, vector<bool>& visited) {
     return false;
 }
 
-void TimingGraph::DFS(int v, int dest) {
+template <typename T>
+void TimingGraphT<T>::DFS(int v, int dest) {
     vector<bool> visited(_nodes.size(), false);
 
     DFSUtil(v, dest, visited);
 }
 
-bool Edge::isConstEdge() const { return !_net || _net->isIntraNet(); }
+template <typename T>
+bool EdgeT<T>::isConstEdge() const { return !_net || _net->isIntraNet(); }
 
-bool Edge::isCritical() const { return _fanout->getArrivalTime() == _driver->getArrivalTime() + getDelay(); }
+template <typename T>
+bool EdgeT<T>::isCritical() const { return _fanout->getArrivalTime() == _driver->getArrivalTime() + getDelay(); }
 
-bool TimingGraph::isOptEdge(const Edge* edge) const {
+template <typename T>
+bool TimingGraphT<T>::isOptEdge(const Edge* edge) const {
     return edge->_net && !edge->isConstEdge() && tdmDatabase.isOptVar(edge->_net->_xdrVar);
 }
 
-void Node::updateArrivalTime(double value) { _arrivalTime = max(_arrivalTime, value); }
-
-vector<Edge*> TimingGraph::getCriticalPath() const {
+template <typename T>
+vector<EdgeT<T>*> TimingGraphT<T>::getCriticalPath() const {
     vector<Edge*> path;
 
     Node* sink = getSink();
@@ -557,3 +726,10 @@ vector<Edge*> TimingGraph::getCriticalPath() const {
 
     return path;
 }
+
+template class NodeT<double>;
+template class EdgeT<double>;
+template class TimingGraphT<double>;
+template class NodeT<float>;
+template class EdgeT<float>;
+template class TimingGraphT<float>;
@@ -1,10 +1,21 @@
 #pragma once
 
 #include "global.h"
+#include "timing_simd.h"
+#include "utils/pool.h"
+
+// The timing of a graph is stored in the scalar type T. tdmDatabase keeps the graph in double for reporting,
+// legalization and refinement, and the Lagrangian solver may iterate on a float copy of it (-precision float).
+template <typename T>
+class NodeT;
+template <typename T>
+class EdgeT;
+template <typename T>
+class TimingGraphT;
+using Node = NodeT<double>;
+using Edge = EdgeT<double>;
+using TimingGraph = TimingGraphT<double>;
 
-class Node;
-class Edge;
-class TimingGraph;
 class TdmNet;
 namespace db {
 class Instance;
@@ -13,40 +24,50 @@ class Group;
 class XdrVar;
 class TdmDB;
 
-class Node {
+template <typename T>
+class NodeT {
+    friend class TimingGraphT<T>;
+
 public:
-    void updateArrivalTime(double value);
-    void updateRequireTime(double value) { _requireTime = min(_requireTime, value); }
+    using Edge = EdgeT<T>;
+
+    void updateArrivalTime(T value) { _arrivalTime = max(_arrivalTime, value); }
+    void updateRequireTime(T value) { _requireTime = min(_requireTime, value); }
     void resetArrivalTime() { _arrivalTime = -1; }
-    void resetRequireTime() { _requireTime = DBL_MAX; }
-    double getArrivalTime() const { return _arrivalTime; }
-    double getRequireTime() const { return _requireTime; }
-    double getSlack() const { return _requireTime - _arrivalTime; }
+    void resetRequireTime() { _requireTime = numeric_limits<T>::max(); }
+    T getArrivalTime() const { return _arrivalTime; }
+    T getRequireTime() const { return _requireTime; }
+    T getSlack() const { return _requireTime - _arrivalTime; }
 
     void addDriver(Edge* driver) { _drivers.push_back(driver); }
     void addFanout(Edge* fanout) { _fanouts.push_back(fanout); }
 
-    Node(db::Instance* instance, int id);
+    NodeT(db::Instance* instance, int id);
 
     vector<Edge*> _drivers;
     vector<Edge*> _fanouts;
     int _id;
 
     db::Instance* _instance;
-    double _delay;
+    T _delay;
 
 private:
-    double _arrivalTime;
-    double _requireTime;
+    T _arrivalTime;
+    T _requireTime;
 };
 
-class Edge {
+template <typename T>
+class EdgeT {
+    friend class TimingGraphT<T>;
+
 public:
-    Edge(Node* fromNode, Node* toNode, TdmNet* net, int id);
+    using Node = NodeT<T>;
+
+    EdgeT(Node* fromNode, Node* toNode, TdmNet* net, int id);
     void updateDelay();
-    double getDelay() const { return _delay; }
-    double getDelay(int val) const;
-    double getArrivalTimeAlongEdge() const { return _arrivalTimeAlongEdge; }
+    T getDelay() const { return _delay; }
+    T getDelay(int val) const;
+    T getArrivalTimeAlongEdge() const { return _arrivalTimeAlongEdge; }
     bool isConstEdge() const;
     bool isCritical() const;
 
@@ -55,34 +76,46 @@ public:
     int _id;
 
     TdmNet* _net;
-    double _constDelay;
-    const double _tdmCoef = 5;
+    T _constDelay;
+    T _tdmCoef = 5;
 
 private:
-    double _delay;
-    double _arrivalTimeAlongEdge;
+    T _delay;
+    T _arrivalTimeAlongEdge;
 };
 
-class TimingGraph {
+template <typename T>
+class TimingGraphT {
+    template <typename S>
+    friend class TimingGraphT;
+
 public:
+    using Node = NodeT<T>;
+    using Edge = EdgeT<T>;
+
     void updateArrivalTime();
     void updateRequireTime();
     void resetTiming();
     void resetArrivalTime();
     void resetRequireTime();
 
-    double getSinkAT() const { return _sink->getArrivalTime(); }
+    T getSinkAT() const { return _sink->getArrivalTime(); }
 
     Edge* addEdge(int u, int v, TdmNet* net);
     Edge* addEdge(Node* u, Node* v, TdmNet* net);
     Node* addNode(db::Instance* instance);
 
+    void reserve(int nNodes, int nEdges, int nXdrVars);
+    void copyFrom(const TimingGraph& graph);  // the same graph, delays and levels in the precision T
     void breakCycle();
     void setConstDelay();
+    void updateConstDelay(Edge* edge);  // after its net or the position of its instances changes
+    void setTdmCoef(double tdmCoef);     // delay per unit of TDM ratio
     void setSrcSink();
     void removeAbnEdges();
+    void invalidateDelays() { _csrDelayValid = false; }  // after _constDelay or _tdmCoef of edges are written
 
-    void levelize();
+    bool levelize();  // false if the graph is cyclic
     vector<vector<Node*>>& getRevLevels() { return _revLevels; }
     vector<vector<Node*>>& getLevels() { return _levels; }
 
@@ -98,10 +131,10 @@ public:
     bool isOptEdge(const Edge* edge) const;
 
     void addMapping(XdrVar* var, Edge* edge);
+    void resetMapping(int nXdrVars);
 
     void report() const;
 
-    bool isCyclic();
     void DFS(int v, int dest);
 
     Node* getSink() const { return _sink; }
@@ -113,10 +146,12 @@ private:
     Node* _source;
     Node* _sink;
 
-    map<XdrVar*, vector<Edge*>> _xdrToEdges;
+    vector<vector<Edge*>> _xdrToEdges;  // by XdrVar::_id
 
     vector<Node*> _nodes;
     vector<Edge*> _edges;
+    Pool<Node> _nodePool;
+    Pool<Edge> _edgePool;
 
     vector<vector<Node*>> _levels;     // from source to sink
     vector<vector<Node*>> _revLevels;  // frome sink to source
@@ -124,14 +159,27 @@ private:
     const double outlierRatio = 0.02;
     const double wireDelayCoef = 1;
 
-    void forLevelize();
-    void revLevelize();
-
-    bool isCyclicUtil(int v, vector<bool>& visited, vector<bool>& recStack);
     bool DFSUtil(int v, int dest, vector<bool>& visited);
+    double getWireDelay(const Edge* edge) const;
 
     void forwardPropagateST();
     void forwardPropagateMT();
     void backwardPropagateST();
     void backwardPropagateMT();
+
+    // the propagation over the CSRs of timing_simd.h, rebuilt after the levels or the delays of the edges change
+    MaxPlusCsr<T> _forwardCsr;
+    MaxPlusCsr<T> _backwardCsr;
+    vector<XdrVar*> _csrVars;  // by XdrVar::_id + 1, NULL at 0 for the edges without TDM delay
+    vector<T> _xdrVal;         // the values of _csrVars
+    vector<T> _at;             // by node id
+    vector<T> _rt;             // by node id
+    bool _csrTopologyValid = false;
+    bool _csrDelayValid = false;
+
+    void buildCsr(MaxPlusCsr<T>& csr, bool backward);
+    void setCsrDelays(MaxPlusCsr<T>& csr);
+    void updateCsr();
+    void propagateCsr(bool backward);
+    void writeBackCsr(const MaxPlusCsr<T>& csr, int posBegin, int posEnd, bool backward);
 };
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include "timing_simd.h"
+
+namespace {
+
+// one lane: the kernels reduce to the loops over the nodes and the edges of the CSR
+template <typename S>
+struct ScalarVec {
+    typedef S T;
+    typedef S Vec;
+    static const int W = 1;
+
+    static Vec load(const S* p) { return *p; }
+    static void store(S* p, Vec v) { *p = v; }
+    static Vec gather(const S* base, const int* idx) { return base[*idx]; }
+    static Vec add(Vec a, Vec b) { return a + b; }
+    static Vec sub(Vec a, Vec b) { return a - b; }
+    static Vec mul(Vec a, Vec b) { return a * b; }
+    static Vec max(Vec a, Vec b) { return a < b ? b : a; }
+    static Vec min(Vec a, Vec b) { return b < a ? b : a; }
+    static S reduceMax(Vec v) { return v; }
+    static S reduceMin(Vec v) { return v; }
+};
+
+}  // namespace
+
+template <>
+MaxPlusKernels<double> getMaxPlusScalar<double>() {
+    return getMaxPlusKernels<ScalarVec<double>>();
+}
+
+template <>
+MaxPlusKernels<float> getMaxPlusScalar<float>() {
+    return getMaxPlusKernels<ScalarVec<float>>();
+}
+
+bool isSimdIsaSupported(Setting::SimdIsa isa) {
+    __builtin_cpu_init();
+    switch (isa) {
+        case Setting::Simd_SSE42:
+            return __builtin_cpu_supports("sse4.2");
+        case Setting::Simd_AVX2:
+            return __builtin_cpu_supports("avx2");
+        case Setting::Simd_AVX512:
+#ifdef LARF_MAX_PLUS_AVX512
+            return __builtin_cpu_supports("avx512f");
+#else
+            return false;
+#endif
+        default:
+            return true;
+    }
+}
+
+// the ISAs from Simd_Scalar on are ordered by width
+Setting::SimdIsa resolveSimdIsa(Setting::SimdIsa isa) {
+    if (isa == Setting::Simd_Off || isa == Setting::Simd_Scalar) return isa;
+
+    Setting::SimdIsa resolved = isa == Setting::Simd_Auto ? Setting::Simd_AVX512 : isa;
+    while (resolved != Setting::Simd_Scalar && !isSimdIsaSupported(resolved))
+        resolved = (Setting::SimdIsa)(resolved - 1);
+
+    static bool warned = false;
+    if (isa != Setting::Simd_Auto && resolved != isa && !warned) {
+        printlog(LOG_WARN,
+                 "%s is not supported, timing propagation uses %s",
+                 getSimdIsaName(isa),
+                 getSimdIsaName(resolved));
+        warned = true;
+    }
+    return resolved;
+}
+
+const char* getSimdIsaName(Setting::SimdIsa isa) {
+    switch (isa) {
+        case Setting::Simd_Auto:
+            return "auto";
+        case Setting::Simd_Off:
+            return "off";
+        case Setting::Simd_Scalar:
+            return "scalar";
+        case Setting::Simd_SSE42:
+            return "sse4.2";
+        case Setting::Simd_AVX2:
+            return "avx2";
+        case Setting::Simd_AVX512:
+            return "avx512";
+    }
+    return "";
+}
+
+template <typename T>
+MaxPlusKernels<T> selectMaxPlusKernels(Setting::SimdIsa isa) {
+    switch (isa) {
+        case Setting::Simd_SSE42:
+            return getMaxPlusSse42<T>();
+        case Setting::Simd_AVX2:
+            return getMaxPlusAvx2<T>();
+#ifdef LARF_MAX_PLUS_AVX512
+        case Setting::Simd_AVX512:
+            return getMaxPlusAvx512<T>();
+#endif
+        default:
+            return getMaxPlusScalar<T>();
+    }
+}
+
+template MaxPlusKernels<double> selectMaxPlusKernels<double>(Setting::SimdIsa isa);
+template MaxPlusKernels<float> selectMaxPlusKernels<float>(Setting::SimdIsa isa);
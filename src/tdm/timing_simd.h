@@ -0,0 +1,50 @@
+#pragma once
+
+#include "global.h"
+#include "timing_simd_kernel.h"
+
+// The edges of a timing graph in structure of arrays, in rows of the node they are reduced into: the drivers of the
+// nodes by level for the arrival times, the fanouts of the nodes by reverse level for the require times.
+template <typename T>
+class MaxPlusCsr {
+public:
+    vector<int> node;        // by position
+    vector<int> levelBegin;  // by level, the first position, the last one ends the positions
+    vector<int> edgeBegin;   // by position, the first edge, the last one ends the edges
+    vector<int> edge;        // by edge, the id in the timing graph
+    vector<int> from;
+    vector<int> to;
+    vector<int> var;
+    vector<T> constDelay;
+    vector<T> tdmCoef;
+    vector<T> delay;
+    vector<T> atAlong;
+    vector<T> reqAlong;
+
+    int getNumLevels() const { return (int)levelBegin.size() - 1; }
+    MaxPlusBatch<T> getBatch(const T* xdrVal, T* at, T* rt) {
+        return {node.data(),
+                edgeBegin.data(),
+                from.data(),
+                to.data(),
+                var.data(),
+                constDelay.data(),
+                tdmCoef.data(),
+                xdrVal,
+                delay.data(),
+                atAlong.data(),
+                reqAlong.data(),
+                at,
+                rt};
+    }
+};
+
+// the ISA of the kernels for setting.simd: the widest one of the cpu for Simd_Auto and, with a warning, for an ISA
+// that the cpu or the compiler lacks
+Setting::SimdIsa resolveSimdIsa(Setting::SimdIsa isa);
+bool isSimdIsaSupported(Setting::SimdIsa isa);
+const char* getSimdIsaName(Setting::SimdIsa isa);
+
+// the kernels of a resolved ISA other than Simd_Off
+template <typename T>
+MaxPlusKernels<T> selectMaxPlusKernels(Setting::SimdIsa isa);
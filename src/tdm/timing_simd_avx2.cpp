@@ -0,0 +1,75 @@
+// max-plus kernels for AVX2
+#pragma GCC target("avx2")
+#pragma GCC optimize("fp-contract=off")
+// the undefined vectors of the intrinsics are reported uninitialized by some gcc
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+
+#include "timing_simd_kernel.h"
+
+namespace {
+
+struct Avx2Double {
+    typedef double T;
+    typedef __m256d Vec;
+    static const int W = 4;
+
+    static Vec load(const double *p) { return _mm256_loadu_pd(p); }
+    static void store(double *p, Vec v) { _mm256_storeu_pd(p, v); }
+    static Vec gather(const double *base, const int *idx) {
+        return _mm256_i32gather_pd(base, _mm_loadu_si128((const __m128i *)idx), 8);
+    }
+    static Vec add(Vec a, Vec b) { return _mm256_add_pd(a, b); }
+    static Vec sub(Vec a, Vec b) { return _mm256_sub_pd(a, b); }
+    static Vec mul(Vec a, Vec b) { return _mm256_mul_pd(a, b); }
+    static Vec max(Vec a, Vec b) { return _mm256_max_pd(a, b); }
+    static Vec min(Vec a, Vec b) { return _mm256_min_pd(a, b); }
+    static double reduceMax(Vec v) {
+        __m128d h = _mm_max_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+        return _mm_cvtsd_f64(_mm_max_sd(h, _mm_unpackhi_pd(h, h)));
+    }
+    static double reduceMin(Vec v) {
+        __m128d h = _mm_min_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+        return _mm_cvtsd_f64(_mm_min_sd(h, _mm_unpackhi_pd(h, h)));
+    }
+};
+
+struct Avx2Float {
+    typedef float T;
+    typedef __m256 Vec;
+    static const int W = 8;
+
+    static Vec load(const float *p) { return _mm256_loadu_ps(p); }
+    static void store(float *p, Vec v) { _mm256_storeu_ps(p, v); }
+    static Vec gather(const float *base, const int *idx) {
+        return _mm256_i32gather_ps(base, _mm256_loadu_si256((const __m256i *)idx), 4);
+    }
+    static Vec add(Vec a, Vec b) { return _mm256_add_ps(a, b); }
+    static Vec sub(Vec a, Vec b) { return _mm256_sub_ps(a, b); }
+    static Vec mul(Vec a, Vec b) { return _mm256_mul_ps(a, b); }
+    static Vec max(Vec a, Vec b) { return _mm256_max_ps(a, b); }
+    static Vec min(Vec a, Vec b) { return _mm256_min_ps(a, b); }
+    static float reduceMax(Vec v) {
+        __m128 h = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        h = _mm_max_ps(h, _mm_movehl_ps(h, h));
+        return _mm_cvtss_f32(_mm_max_ss(h, _mm_shuffle_ps(h, h, 1)));
+    }
+    static float reduceMin(Vec v) {
+        __m128 h = _mm_min_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        h = _mm_min_ps(h, _mm_movehl_ps(h, h));
+        return _mm_cvtss_f32(_mm_min_ss(h, _mm_shuffle_ps(h, h, 1)));
+    }
+};
+
+}  // namespace
+
+template <>
+MaxPlusKernels<double> getMaxPlusAvx2<double>() {
+    return getMaxPlusKernels<Avx2Double>();
+}
+
+template <>
+MaxPlusKernels<float> getMaxPlusAvx2<float>() {
+    return getMaxPlusKernels<Avx2Float>();
+}
@@ -0,0 +1,86 @@
+// max-plus kernels for AVX-512 (AVX512F only), the condition is the one of LARF_MAX_PLUS_AVX512 that cannot be
+// tested here: the kernels must be compiled after the pragmas
+#if !defined(__clang__) && (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+
+#pragma GCC target("avx512f")
+#pragma GCC optimize("fp-contract=off")
+// the undefined vectors of the intrinsics are reported uninitialized by some gcc
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+
+#include "timing_simd_kernel.h"
+
+namespace {
+
+struct Avx512Double {
+    typedef double T;
+    typedef __m512d Vec;
+    static const int W = 8;
+
+    static Vec load(const double *p) { return _mm512_loadu_pd(p); }
+    static void store(double *p, Vec v) { _mm512_storeu_pd(p, v); }
+    static Vec gather(const double *base, const int *idx) {
+        return _mm512_i32gather_pd(_mm256_loadu_si256((const __m256i *)idx), base, 8);
+    }
+    static Vec add(Vec a, Vec b) { return _mm512_add_pd(a, b); }
+    static Vec sub(Vec a, Vec b) { return _mm512_sub_pd(a, b); }
+    static Vec mul(Vec a, Vec b) { return _mm512_mul_pd(a, b); }
+    static Vec max(Vec a, Vec b) { return _mm512_max_pd(a, b); }
+    static Vec min(Vec a, Vec b) { return _mm512_min_pd(a, b); }
+    static double reduceMax(Vec v) {
+        __m256d q = _mm256_max_pd(_mm512_castpd512_pd256(v), _mm512_extractf64x4_pd(v, 1));
+        __m128d h = _mm_max_pd(_mm256_castpd256_pd128(q), _mm256_extractf128_pd(q, 1));
+        return _mm_cvtsd_f64(_mm_max_sd(h, _mm_unpackhi_pd(h, h)));
+    }
+    static double reduceMin(Vec v) {
+        __m256d q = _mm256_min_pd(_mm512_castpd512_pd256(v), _mm512_extractf64x4_pd(v, 1));
+        __m128d h = _mm_min_pd(_mm256_castpd256_pd128(q), _mm256_extractf128_pd(q, 1));
+        return _mm_cvtsd_f64(_mm_min_sd(h, _mm_unpackhi_pd(h, h)));
+    }
+};
+
+struct Avx512Float {
+    typedef float T;
+    typedef __m512 Vec;
+    static const int W = 16;
+
+    static Vec load(const float *p) { return _mm512_loadu_ps(p); }
+    static void store(float *p, Vec v) { _mm512_storeu_ps(p, v); }
+    static Vec gather(const float *base, const int *idx) {
+        return _mm512_i32gather_ps(_mm512_loadu_si512((const void *)idx), base, 4);
+    }
+    static Vec add(Vec a, Vec b) { return _mm512_add_ps(a, b); }
+    static Vec sub(Vec a, Vec b) { return _mm512_sub_ps(a, b); }
+    static Vec mul(Vec a, Vec b) { return _mm512_mul_ps(a, b); }
+    static Vec max(Vec a, Vec b) { return _mm512_max_ps(a, b); }
+    static Vec min(Vec a, Vec b) { return _mm512_min_ps(a, b); }
+    // the upper half is taken as doubles, AVX512F has no 256-bit extract of floats
+    static __m256 upper(Vec v) { return _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1)); }
+    static float reduceMax(Vec v) {
+        __m256 q = _mm256_max_ps(_mm512_castps512_ps256(v), upper(v));
+        __m128 h = _mm_max_ps(_mm256_castps256_ps128(q), _mm256_extractf128_ps(q, 1));
+        h = _mm_max_ps(h, _mm_movehl_ps(h, h));
+        return _mm_cvtss_f32(_mm_max_ss(h, _mm_shuffle_ps(h, h, 1)));
+    }
+    static float reduceMin(Vec v) {
+        __m256 q = _mm256_min_ps(_mm512_castps512_ps256(v), upper(v));
+        __m128 h = _mm_min_ps(_mm256_castps256_ps128(q), _mm256_extractf128_ps(q, 1));
+        h = _mm_min_ps(h, _mm_movehl_ps(h, h));
+        return _mm_cvtss_f32(_mm_min_ss(h, _mm_shuffle_ps(h, h, 1)));
+    }
+};
+
+}  // namespace
+
+template <>
+MaxPlusKernels<double> getMaxPlusAvx512<double>() {
+    return getMaxPlusKernels<Avx512Double>();
+}
+
+template <>
+MaxPlusKernels<float> getMaxPlusAvx512<float>() {
+    return getMaxPlusKernels<Avx512Float>();
+}
+
+#endif
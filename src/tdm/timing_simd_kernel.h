@@ -0,0 +1,121 @@
+#pragma once
+
+// Max-plus kernels of timing propagation over the edges of a MaxPlusCsr (see timing_simd.h). A vector type V gives
+// the width W and the operations; the kernels are instantiated in timing_simd_<isa>.cpp, each built for its ISA.
+// No other header is included here: the inline functions of the STL must not be compiled for an ISA in those files.
+
+// arrays of a MaxPlusCsr and of the nodes; positions index the nodes of the CSR, edges are those of the positions
+template <typename T>
+struct MaxPlusBatch {
+    const int *node;        // by position, the node id
+    const int *edgeBegin;   // by position, the first edge, the last one ends the edges of the CSR
+    const int *from;        // by edge, the driver
+    const int *to;          // by edge, the fanout
+    const int *var;         // by edge, the index in xdrVal
+    const T *constDelay;    // by edge, 0 for an edge without net
+    const T *tdmCoef;       // by edge, 0 for an edge not of an inter-FPGA net
+    const T *xdrVal;        // by var, xdrVal[0] = 0
+    T *delay;               // by edge
+    T *atAlong;             // by edge, the arrival time along the edge
+    T *reqAlong;            // by edge, the require time at the driver along the edge (backward)
+    T *at;                  // by node id
+    T *rt;                  // by node id
+};
+
+template <typename T>
+struct MaxPlusKernels {
+    // at[node] = max(at[node], max of delay + at[from] over the drivers of the nodes in [posBegin, posEnd)
+    void (*forward)(const MaxPlusBatch<T> &batch, int posBegin, int posEnd);
+    // rt[node] = min(rt[node], min of rt[to] - delay over the fanouts of the nodes in [posBegin, posEnd)
+    void (*backward)(const MaxPlusBatch<T> &batch, int posBegin, int posEnd);
+};
+
+template <typename T>
+MaxPlusKernels<T> getMaxPlusScalar();
+template <typename T>
+MaxPlusKernels<T> getMaxPlusSse42();
+template <typename T>
+MaxPlusKernels<T> getMaxPlusAvx2();
+template <typename T>
+MaxPlusKernels<T> getMaxPlusAvx512();
+
+// gcc 4.8 has neither the intrinsics nor the cpu check of AVX-512, and clang (__GNUC__ 4.2) does not take the
+// #pragma GCC target of the kernels
+#if !defined(__clang__) && (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+#define LARF_MAX_PLUS_AVX512
+#endif
+
+// delay = constDelay + tdmCoef * xdrVal[var] and atAlong = delay + at[from] as Edge::updateDelay, in the same order
+// of operations, so that the results are the same bit by bit
+template <typename V>
+inline void maxPlusEdges(const MaxPlusBatch<typename V::T> &b, int begin, int end, bool backward) {
+    typedef typename V::T T;
+    int e = begin;
+    for (; e + V::W <= end; e += V::W) {
+        typename V::Vec coef = V::mul(V::load(b.tdmCoef + e), V::gather(b.xdrVal, b.var + e));
+        typename V::Vec delay = V::add(V::load(b.constDelay + e), coef);
+        V::store(b.delay + e, delay);
+        V::store(b.atAlong + e, V::add(delay, V::gather(b.at, b.from + e)));
+        if (backward) V::store(b.reqAlong + e, V::sub(V::gather(b.rt, b.to + e), delay));
+    }
+    for (; e < end; e++) {
+        T delay = b.constDelay[e] + b.tdmCoef[e] * b.xdrVal[b.var[e]];
+        b.delay[e] = delay;
+        b.atAlong[e] = delay + b.at[b.from[e]];
+        if (backward) b.reqAlong[e] = b.rt[b.to[e]] - delay;
+    }
+}
+
+template <typename V>
+inline typename V::T maxPlusMax(const typename V::T *val, int begin, int end, typename V::T res) {
+    int e = begin;
+    if (end - begin >= V::W) {
+        typename V::Vec vec = V::load(val + e);
+        for (e += V::W; e + V::W <= end; e += V::W) vec = V::max(vec, V::load(val + e));
+        typename V::T vecMax = V::reduceMax(vec);
+        if (vecMax > res) res = vecMax;
+    }
+    for (; e < end; e++)
+        if (val[e] > res) res = val[e];
+    return res;
+}
+
+template <typename V>
+inline typename V::T maxPlusMin(const typename V::T *val, int begin, int end, typename V::T res) {
+    int e = begin;
+    if (end - begin >= V::W) {
+        typename V::Vec vec = V::load(val + e);
+        for (e += V::W; e + V::W <= end; e += V::W) vec = V::min(vec, V::load(val + e));
+        typename V::T vecMin = V::reduceMin(vec);
+        if (vecMin < res) res = vecMin;
+    }
+    for (; e < end; e++)
+        if (val[e] < res) res = val[e];
+    return res;
+}
+
+template <typename V>
+void maxPlusForward(const MaxPlusBatch<typename V::T> &b, int posBegin, int posEnd) {
+    maxPlusEdges<V>(b, b.edgeBegin[posBegin], b.edgeBegin[posEnd], false);
+    for (int pos = posBegin; pos < posEnd; pos++) {
+        int node = b.node[pos];
+        b.at[node] = maxPlusMax<V>(b.atAlong, b.edgeBegin[pos], b.edgeBegin[pos + 1], b.at[node]);
+    }
+}
+
+template <typename V>
+void maxPlusBackward(const MaxPlusBatch<typename V::T> &b, int posBegin, int posEnd) {
+    maxPlusEdges<V>(b, b.edgeBegin[posBegin], b.edgeBegin[posEnd], true);
+    for (int pos = posBegin; pos < posEnd; pos++) {
+        int node = b.node[pos];
+        b.rt[node] = maxPlusMin<V>(b.reqAlong, b.edgeBegin[pos], b.edgeBegin[pos + 1], b.rt[node]);
+    }
+}
+
+template <typename V>
+MaxPlusKernels<typename V::T> getMaxPlusKernels() {
+    MaxPlusKernels<typename V::T> kernels;
+    kernels.forward = maxPlusForward<V>;
+    kernels.backward = maxPlusBackward<V>;
+    return kernels;
+}
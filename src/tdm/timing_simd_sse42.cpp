@@ -0,0 +1,62 @@
+// max-plus kernels for SSE4.2, which has no gather
+#pragma GCC target("sse4.2")
+#pragma GCC optimize("fp-contract=off")
+#include <immintrin.h>
+
+#include "timing_simd_kernel.h"
+
+namespace {
+
+struct Sse42Double {
+    typedef double T;
+    typedef __m128d Vec;
+    static const int W = 2;
+
+    static Vec load(const double *p) { return _mm_loadu_pd(p); }
+    static void store(double *p, Vec v) { _mm_storeu_pd(p, v); }
+    static Vec gather(const double *base, const int *idx) { return _mm_set_pd(base[idx[1]], base[idx[0]]); }
+    static Vec add(Vec a, Vec b) { return _mm_add_pd(a, b); }
+    static Vec sub(Vec a, Vec b) { return _mm_sub_pd(a, b); }
+    static Vec mul(Vec a, Vec b) { return _mm_mul_pd(a, b); }
+    static Vec max(Vec a, Vec b) { return _mm_max_pd(a, b); }
+    static Vec min(Vec a, Vec b) { return _mm_min_pd(a, b); }
+    static double reduceMax(Vec v) { return _mm_cvtsd_f64(_mm_max_sd(v, _mm_unpackhi_pd(v, v))); }
+    static double reduceMin(Vec v) { return _mm_cvtsd_f64(_mm_min_sd(v, _mm_unpackhi_pd(v, v))); }
+};
+
+struct Sse42Float {
+    typedef float T;
+    typedef __m128 Vec;
+    static const int W = 4;
+
+    static Vec load(const float *p) { return _mm_loadu_ps(p); }
+    static void store(float *p, Vec v) { _mm_storeu_ps(p, v); }
+    static Vec gather(const float *base, const int *idx) {
+        return _mm_set_ps(base[idx[3]], base[idx[2]], base[idx[1]], base[idx[0]]);
+    }
+    static Vec add(Vec a, Vec b) { return _mm_add_ps(a, b); }
+    static Vec sub(Vec a, Vec b) { return _mm_sub_ps(a, b); }
+    static Vec mul(Vec a, Vec b) { return _mm_mul_ps(a, b); }
+    static Vec max(Vec a, Vec b) { return _mm_max_ps(a, b); }
+    static Vec min(Vec a, Vec b) { return _mm_min_ps(a, b); }
+    static float reduceMax(Vec v) {
+        v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+        return _mm_cvtss_f32(_mm_max_ss(v, _mm_shuffle_ps(v, v, 1)));
+    }
+    static float reduceMin(Vec v) {
+        v = _mm_min_ps(v, _mm_movehl_ps(v, v));
+        return _mm_cvtss_f32(_mm_min_ss(v, _mm_shuffle_ps(v, v, 1)));
+    }
+};
+
+}  // namespace
+
+template <>
+MaxPlusKernels<double> getMaxPlusSse42<double>() {
+    return getMaxPlusKernels<Sse42Double>();
+}
+
+template <>
+MaxPlusKernels<float> getMaxPlusSse42<float>() {
+    return getMaxPlusKernels<Sse42Float>();
+}
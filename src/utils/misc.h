@@ -94,4 +94,32 @@ template <typename key, typename value>
 struct sorting_order {
     static bool desc(const pair<key, value>& left, const pair<key, value>& right) { return left.first > right.first; }
     static bool asc(const pair<key, value>& left, const pair<key, value>& right) { return left.first < right.first; }
-};
\ No newline at end of file
+};
+
+// func(begin, end) over [0, n) in batches, which threads take in order
+template <typename Func>
+void parallelFor(int n, int nThreads, int batchSize, Func func) {
+    nThreads = max(1, min(nThreads, (n + batchSize - 1) / batchSize));
+    if (nThreads == 1) {
+        if (n > 0) func(0, n);
+        return;
+    }
+
+    std::mutex idx_mutex;
+    int next = 0;
+    auto threadFunc = [&]() {
+        while (true) {
+            idx_mutex.lock();
+            int begin = next;
+            next += batchSize;
+            idx_mutex.unlock();
+
+            if (begin >= n) break;
+            func(begin, min(n, begin + batchSize));
+        }
+    };
+
+    std::thread threads[nThreads];
+    for (int i = 0; i < nThreads; i++) threads[i] = std::thread(threadFunc);
+    for (int i = 0; i < nThreads; i++) threads[i].join();
+}
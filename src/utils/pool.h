@@ -0,0 +1,55 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+//////////OBJECT POOL//////////
+
+// Objects are constructed in place in large blocks, so millions of small objects cost a few allocations.
+// Pointers stay valid until the pool is destroyed, and nothing is freed individually.
+
+template <typename T>
+class Pool {
+private:
+    struct Block {
+        T* data;
+        size_t size;
+        size_t used;
+    };
+    std::vector<Block> _blocks;
+    size_t _blockSize;
+
+public:
+    explicit Pool(size_t blockSize = 4096) : _blockSize(blockSize) {}
+    Pool(const Pool&) = delete;
+    Pool& operator=(const Pool&) = delete;
+    ~Pool() { clear(); }
+
+    template <typename... Args>
+    T* create(Args&&... args) {
+        return new (alloc(1)) T(std::forward<Args>(args)...);
+    }
+
+    // storage of n contiguous objects, the caller constructs all of them (e.g., by threads) before the pool is destroyed
+    T* alloc(size_t n) {
+        if (_blocks.empty() || _blocks.back().used + n > _blocks.back().size) {
+            size_t size = std::max(n, _blockSize);
+            _blocks.push_back({static_cast<T*>(::operator new(size * sizeof(T))), size, 0});
+        }
+        Block& block = _blocks.back();
+        T* res = block.data + block.used;
+        block.used += n;
+        return res;
+    }
+
+    void clear() {
+        for (auto& block : _blocks) {
+            for (size_t i = 0; i < block.used; i++) block.data[i].~T();
+            ::operator delete(block.data);
+        }
+        _blocks.clear();
+    }
+};
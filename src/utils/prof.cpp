@@ -0,0 +1,168 @@
+#include <ctime>
+#include <sys/resource.h>
+
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "log.h"
+#include "prof.h"
+
+using namespace std;
+
+extern timer::timer tstamp;
+
+namespace prof {
+
+struct Node {
+    string name;
+    Node* parent;
+    vector<Node*> children;
+    long calls;
+    double wall;
+    double cpu;
+    long peakRSS;
+    map<string, long> counters;
+
+    Node(const string& _name, Node* _parent) : name(_name), parent(_parent), calls(0), wall(0), cpu(0), peakRSS(0) {}
+    Node* child(const string& childName) {
+        for (auto c : children)
+            if (c->name == childName) return c;
+        children.push_back(new Node(childName, this));
+        return children.back();
+    }
+};
+
+Node root("run", NULL);
+map<string, string> infos;
+mutex profMutex;
+thread_local Node* current = NULL;
+double rootWallStart = 0;  // of the run, see reset
+double rootCpuStart = 0;
+
+inline Node* currentNode() { return current ? current : &root; }
+
+double cpuTime() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+long peakRSS() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+Scope::Scope(const char* name) {
+    _parent = currentNode();
+    profMutex.lock();
+    _node = static_cast<Node*>(_parent)->child(name);
+    profMutex.unlock();
+    current = static_cast<Node*>(_node);
+    _wallStart = tstamp.elapsed();
+    _cpuStart = cpuTime();
+}
+
+Scope::~Scope() {
+    double wall = tstamp.elapsed() - _wallStart;
+    double cpu = cpuTime() - _cpuStart;
+    long rss = peakRSS();
+    Node* node = static_cast<Node*>(_node);
+    profMutex.lock();
+    node->calls++;
+    node->wall += wall;
+    node->cpu += cpu;
+    node->peakRSS = max(node->peakRSS, rss);
+    profMutex.unlock();
+    current = static_cast<Node*>(_parent);
+}
+
+void count(const char* name, long value) {
+    Node* node = currentNode();
+    lock_guard<mutex> lock(profMutex);
+    node->counters[name] += value;
+}
+
+void info(const string& key, const string& value) {
+    lock_guard<mutex> lock(profMutex);
+    infos[key] = value;
+}
+
+string jsonString(const string& str) {
+    string res = "\"";
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            res += '\\';
+            res += c;
+        } else if ((unsigned char)c < 0x20) {
+            res += ' ';
+        } else {
+            res += c;
+        }
+    }
+    return res + "\"";
+}
+
+void writeNode(ostream& os, const Node* node, const string& indent) {
+    os << indent << "{\"name\": " << jsonString(node->name) << ", \"calls\": " << node->calls
+       << ", \"wall\": " << node->wall << ", \"cpu\": " << node->cpu
+       << ", \"utilization\": " << (node->wall > 0 ? node->cpu / node->wall : 0.0)
+       << ", \"peak_rss_kb\": " << node->peakRSS << ", \"counters\": {";
+    bool first = true;
+    for (auto& counter : node->counters) {
+        os << (first ? "" : ", ") << jsonString(counter.first) << ": " << counter.second;
+        first = false;
+    }
+    os << "}, \"phases\": [";
+    if (!node->children.empty()) {
+        os << "\n";
+        for (unsigned i = 0; i < node->children.size(); i++) {
+            writeNode(os, node->children[i], indent + "  ");
+            os << (i + 1 < node->children.size() ? ",\n" : "\n");
+        }
+        os << indent;
+    }
+    os << "]}";
+}
+
+bool writeReport(const string& file) {
+    ofstream fs(file);
+    if (!fs.good()) {
+        printlog(LOG_ERROR, "Cannot open %s to write", file.c_str());
+        return false;
+    }
+    lock_guard<mutex> lock(profMutex);
+    root.calls = 1;
+    root.wall = tstamp.elapsed() - rootWallStart;
+    root.cpu = cpuTime() - rootCpuStart;
+    root.peakRSS = peakRSS();
+    fs << setprecision(6) << fixed;
+    fs << "{\n";
+    for (auto& pair : infos) fs << "  " << jsonString(pair.first) << ": " << jsonString(pair.second) << ",\n";
+    fs << "  \"report\":\n";
+    writeNode(fs, &root, "  ");
+    fs << "\n}\n";
+    fs.close();
+    printlog(LOG_INFO, "run report is written to %s", file.c_str());
+    return true;
+}
+
+void deleteNode(Node* node) {
+    for (auto child : node->children) deleteNode(child);
+    delete node;
+}
+
+void reset() {
+    lock_guard<mutex> lock(profMutex);
+    for (auto child : root.children) deleteNode(child);
+    root = Node("run", NULL);
+    infos.clear();
+    rootWallStart = tstamp.elapsed();
+    rootCpuStart = cpuTime();
+}
+
+}  // namespace prof
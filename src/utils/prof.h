@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+
+//////////PHASE PROFILER//////////
+
+// Scopes nest per thread into a tree of phases. Each phase records call count, wall time,
+// process CPU time (CPU / wall is the average number of busy threads), peak RSS at exit
+// and named counters. Scopes opened in worker threads start from the root.
+
+namespace prof {
+class Scope {
+private:
+    void* _node;
+    void* _parent;
+    double _wallStart;
+    double _cpuStart;
+
+public:
+    explicit Scope(const char* name);
+    ~Scope();
+};
+
+void count(const char* name, long value = 1);            // add to a counter of the current phase
+void info(const std::string& key, const std::string& value);  // top-level key of the report
+double cpuTime();                                         // seconds, all threads of the process
+long peakRSS();                                           // KB
+bool writeReport(const std::string& file);               // JSON
+void reset();                                            // new run with no scope open, peak RSS is kept
+}  // namespace prof
+
+#define PROF_CONCAT_(a, b) a##b
+#define PROF_CONCAT(a, b) PROF_CONCAT_(a, b)
+#define PROF_SCOPE(name) prof::Scope PROF_CONCAT(_profScope, __LINE__)(name)